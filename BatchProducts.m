@@ -0,0 +1,256 @@
+function varargout=BatchProducts(Command,varargin)
+% Call as:  B=BatchProducts('start',Rasters,PoolSize)
+%      or:  B=BatchProducts('start',Rasters,PoolSize,StatusFcn)
+%           B=BatchProducts('submit',B,Task)
+%           Log=BatchProducts('finish',B)
+%
+% Renders nodal fields to PNG images without drawing them, for the
+% batch products of StormSurgeViz (see MakeBatchProducts there).  Each
+% field is rasterized by the pixel weights of its grid, Rasters{GridId}
+% (see RasterWeights), and mapped to colors as the GUI maps them, so
+% no figure or display is needed.  Pixels outside the grid are
+% transparent, and each image has a world file (.pgw) placing it on
+% the map.
+%
+% 'start' sets up the rendering.  With PoolSize>0 and the Parallel
+% Computing Toolbox, tasks are run on the current parallel pool, or on
+% a pool of PoolSize workers started for it, and the rasters are sent
+% to each worker once.  At most PoolSize tasks are queued at a time,
+% so a larger pool already running (e.g., one started to connect to
+% the members) renders on only PoolSize of its workers.  Otherwise, or
+% if the pool cannot be used, each task is run as it is submitted.
+%
+% 'submit' queues a task and returns at once when it runs on the pool,
+% once fewer than PoolSize tasks are queued, so the caller can read or compute its next fields while the workers
+% render, and the workers that read from the server overlap those
+% rendering.  A Task has fields:
+%    .Url      - the member's dataset, read on the worker; '' to
+%                render .Data
+%    .Var      - the netCDF variable, or a 2-cell of the u,v names of
+%                a vector, which is rendered as its magnitude
+%    .Levels   - time levels to read from .Url; [] for a variable
+%                without time.  They are read in one contiguous read,
+%                so keep them close together.
+%    .Fac      - units factor for the data read from .Url
+%    .Perm     - the grid's node order (see ReorderGrid), or []
+%    .Data     - nn x k fields to render, when .Url is ''
+%    .Times    - datenums of the k fields, if known; for .Url they are
+%                read from the dataset (see MemberTimes)
+%    .DateFormat - format of the dataset's base_date
+%    .GridId   - index into Rasters
+%    .CLim     - [cmin cmax] color limits
+%    .CMap     - colormap, ncolors x 3
+%    .Files    - output files, one per field, without extension
+%    .Member, .Variable, .Units - for the log
+%
+% 'finish' waits for the queued tasks and returns the log, one element
+% per task, with the task's .Member, .Variable, .Units, .CLim, .Files
+% written, their .Times, and a .Message if the task failed.
+%
+% StatusFcn (default @disp) is called with a status string as tasks
+% finish.
+
+switch lower(Command)
+    case 'start'
+        varargout{1}=Start(varargin{:});
+    case 'submit'
+        varargout{1}=Submit(varargin{:});
+    case 'finish'
+        varargout{1}=Finish(varargin{:});
+    otherwise
+        error('Unknown command %s to %s.',Command,mfilename)
+end
+
+
+function B=Start(Rasters,PoolSize,StatusFcn)
+
+    if ~exist('StatusFcn','var') || isempty(StatusFcn)
+        StatusFcn=@disp;
+    end
+    B.Rasters=Rasters;
+    B.StatusFcn=StatusFcn;
+    B.Pool=[];
+    B.Shared=[];
+    B.Futures=[];
+    B.Pending=0;
+    B.MaxPending=max(1,PoolSize);
+    B.Log=repmat(EmptyLog,0,1);
+
+    if PoolSize>0 && exist('parfeval','file')==2 && license('test','Distrib_Computing_Toolbox')
+        try
+            pool=gcp('nocreate');
+            if isempty(pool)
+                StatusFcn(sprintf('* Starting a pool of %d workers for rendering ...\n',PoolSize));
+                pool=parpool(PoolSize);
+            end
+            PrepareWorkers(pool);
+            if exist('parallel.pool.Constant','class')
+                B.Shared=parallel.pool.Constant(Rasters);
+            else
+                B.Shared=Rasters;
+            end
+            B.Pool=pool;
+        catch ME
+            StatusFcn(sprintf('* Parallel rendering failed to start (%s); rendering in turn ...\n',ME.message));
+        end
+    end
+
+
+function B=Submit(B,Task)
+
+    if isempty(B.Pool)
+        B=Record(B,RunTask(Task,B.Rasters));
+        return
+    end
+    % no more than PoolSize tasks outstanding, whatever the pool's size
+    while B.Pending>=B.MaxPending
+        [~,out]=fetchNext(B.Futures);
+        B.Pending=B.Pending-1;
+        B=Record(B,out);
+    end
+    f=parfeval(B.Pool,@RunTask,1,Task,B.Shared);
+    if isempty(B.Futures)
+        B.Futures=f;
+    else
+        B.Futures(end+1)=f;
+    end
+    B.Pending=B.Pending+1;
+
+    % take in what has finished, so that results do not pile up
+    while B.Pending>0
+        [i,out]=fetchNext(B.Futures,0);
+        if isempty(i),break,end
+        B.Pending=B.Pending-1;
+        B=Record(B,out);
+    end
+
+
+function Log=Finish(B)
+
+    while B.Pending>0
+        [~,out]=fetchNext(B.Futures);
+        B.Pending=B.Pending-1;
+        B=Record(B,out);
+    end
+    Log=B.Log;
+
+
+function B=Record(B,out)
+
+    B.Log(end+1,1)=out;
+    if isempty(out.Message)
+        B.StatusFcn(sprintf('* Rendered %s %s, %d image(s)\n',out.Member,out.Variable,length(out.Files)));
+    else
+        B.StatusFcn(sprintf('***** %s %s not rendered: %s *****\n',out.Member,out.Variable,out.Message));
+    end
+
+
+function out=RunTask(Task,Rasters)
+
+    % runs on a worker, or on the client when there is no pool
+    if isa(Rasters,'parallel.pool.Constant')
+        Rasters=Rasters.Value;
+    end
+    out=EmptyLog;
+    out.Member=Task.Member;
+    out.Variable=Task.Variable;
+    out.Units=Task.Units;
+    out.CLim=Task.CLim;
+    out.Times=Task.Times;
+    try
+        if isempty(Task.Url)
+            Q=Task.Data;
+        else
+            h=ncgeodataset(Task.Url);
+            Q=ReadLevels(h,Task);
+            if ~isempty(Task.Levels) && isempty(out.Times)
+                try
+                    t=MemberTimes(h,Task.DateFormat);
+                    out.Times=t(Task.Levels);
+                catch
+                    % the images are still good without their times
+                end
+            end
+            close(h);
+        end
+        out.Files=RenderRaster(Rasters{Task.GridId},Q,Task.CLim,Task.CMap,Task.Files);
+    catch ME
+        out.Message=ME.message;
+    end
+
+
+function Q=ReadLevels(h,Task)
+
+    % as GetDataObject reads them, but a slab of levels at a time
+    v=Task.Var;
+    if ~iscell(v)
+        v={v};
+    end
+    L=Task.Levels(:)';
+    if isempty(L)
+        Q=cast(h.data(v{1}),'double');
+        Q=Q(:);
+    else
+        r=L-L(1)+1;
+        hh=h.geovariable(v{1});
+        Q=cast(hh.data(L(1):L(end),:),'double');
+        Q=Q(r,:)';
+        if length(v)==2
+            hh=h.geovariable(v{2});
+            Q2=cast(hh.data(L(1):L(end),:),'double');
+            Q2=Q2(r,:)';
+            inan=abs(Q)<eps & abs(Q2)<eps;
+            Q=abs(Q+sqrt(-1)*Q2);
+            Q(inan)=NaN;
+        end
+    end
+    Q=Q*Task.Fac;
+    if size(Q,1)==length(Task.Perm)
+        Q=Q(Task.Perm,:);
+    end
+
+
+function Files=RenderRaster(R,Q,CLim,CMap,Names)
+
+    % the pixel values of all the fields in one pass over the pixels
+    if exist('interpmex5','file')==3
+        V=interpmex5(R.n,R.w,Q);
+    else
+        V=zeros(length(R.pix),size(Q,2));
+        for k=1:size(Q,2)
+            q=Q(:,k);
+            V(:,k)=sum(R.w.*q(R.n),2);
+        end
+    end
+
+    % color index as for CDataMapping 'scaled' and the axes' CLim
+    nc=size(CMap,1);
+    RGB=uint8(round(255*CMap));
+    Files=cell(size(Q,2),1);
+    for k=1:size(Q,2)
+        v=V(:,k);
+        in=~isnan(v);
+        if CLim(2)>CLim(1)
+            c=floor((v(in)-CLim(1))/(CLim(2)-CLim(1))*nc)+1;
+            c=min(max(c,1),nc);
+        else
+            c=ones(sum(in),1);
+        end
+        img=zeros(R.ny*R.nx,3,'uint8');
+        alpha=zeros(R.ny,R.nx);
+        p=R.pix(in);
+        img(p,:)=RGB(c,:);
+        alpha(p)=1;
+        Files{k}=[Names{k} '.png'];
+        imwrite(reshape(img,R.ny,R.nx,3),Files{k},'Alpha',alpha);
+
+        % world file: pixel size and the center of the top-left pixel
+        fid=fopen([Names{k} '.pgw'],'w');
+        fprintf(fid,'%.10g\n',[R.dx 0 0 -R.dy R.bbox(1)+R.dx/2 R.bbox(4)-R.dy/2]);
+        fclose(fid);
+    end
+
+
+function out=EmptyLog
+    out=struct('Member','','Variable','','Units','','CLim',[],...
+               'Files',{{}},'Times',[],'Message','');
@@ -0,0 +1,121 @@
+function Meta=ConnectMembers(Urls,VarNames,PoolSize,StatusFcn)
+% Call as:  Meta=ConnectMembers(Urls,VarNames,PoolSize)
+%      or:  Meta=ConnectMembers(Urls,VarNames,PoolSize,StatusFcn)
+%
+% Opens the NEns x NFiles OPeNDAP datasets Urls{i,j} (the variable files
+% of each ensemble member) and gathers what OpenDataConnections needs of
+% each: whether it opened, the number of nodes and time levels of its
+% variable VarNames{j} (a name, or a 2-cell of the u,v names of a
+% vector), and the content hash of its grid (GridFingerprint).  Each
+% open is a few round trips to the server and the fingerprint a few
+% small reads, so for a large ensemble this is most of the startup time.
+%
+% With PoolSize>0 and the Parallel Computing Toolbox, the members are
+% connected concurrently, one member per task, on the current parallel
+% pool, or on a pool of PoolSize workers started for it, so the time
+% taken is that of the slowest members rather than the sum over all of
+% them.  netCDF-Java handles do not cross from the workers, so Meta has
+% no handles and the client opens each member's when it is first used
+% (see OpenMemberHandles).  Otherwise, or if the pool cannot be used,
+% the members are connected in turn and Meta(i,j).Handle is the open
+% ncgeodataset.
+%
+% StatusFcn (default @disp) is called with a status string as members
+% are connected.
+%
+% Meta(i,j) has fields:
+%    .Ok       - true if the dataset opened and has variables
+%    .Message  - why not, if not
+%    .Handle   - the ncgeodataset, if connected on the client, else []
+%    .NNodes   - number of nodes of VarNames{j}
+%    .NTimes   - number of time levels of VarNames{j}
+%    .GridHash - GridFingerprint of the grid; files of a member with the
+%                dimensions of an earlier file of that member share its
+%                hash
+
+if ~exist('StatusFcn','var') || isempty(StatusFcn)
+    StatusFcn=@disp;
+end
+
+[NEns,NFiles]=size(Urls);
+Meta=repmat(EmptyMeta,NEns,NFiles);
+
+if PoolSize>0 && exist('parfeval','file')==2 && license('test','Distrib_Computing_Toolbox')
+    try
+        pool=gcp('nocreate');
+        if isempty(pool)
+            StatusFcn(sprintf('* Starting a pool of %d workers for connections ...\n',PoolSize));
+            pool=parpool(PoolSize);
+        end
+        PrepareWorkers(pool);
+        for i=NEns:-1:1
+            F(i)=parfeval(pool,@MemberMeta,1,Urls(i,:),VarNames,false);
+        end
+        for k=1:NEns
+            [i,m]=fetchNext(F);
+            Meta(i,:)=m;
+            StatusFcn(sprintf('* Connected to member %d (%d of %d)\n',i,k,NEns));
+        end
+        return
+    catch ME
+        StatusFcn(sprintf('* Parallel connections failed (%s); connecting in turn ...\n',ME.message));
+    end
+end
+
+for i=1:NEns
+    Meta(i,:)=MemberMeta(Urls(i,:),VarNames,true);
+    StatusFcn(sprintf('* Connected to member %d of %d\n',i,NEns));
+end
+
+
+function meta=MemberMeta(urls,VarNames,KeepHandles)
+
+    % connect to the files of one member; runs on a worker, or on the
+    % client with KeepHandles
+    meta=repmat(EmptyMeta,1,length(urls));
+    GridSize=[];
+    GridHash='';
+    for j=1:length(urls)
+        try
+            nc=ncgeodataset(urls{j});
+        catch ME
+            meta(j).Message=ME.message;
+            continue
+        end
+        if isempty(nc.variables)
+            meta(j).Message='No variables found';
+            continue
+        end
+        meta(j).Ok=true;
+
+        sz=[double(size(nc.variable{'element'})) double(size(nc.variable{'x'}))];
+        if ~isequal(sz,GridSize)
+            GridSize=sz;
+            GridHash=GridFingerprint(nc);
+        end
+        meta(j).GridHash=GridHash;
+
+        v=VarNames{j};
+        if iscell(v)
+            v=v{1};
+        end
+        MandN=size(nc{v});
+        if (length(MandN)>1  && ~any(MandN==1))
+            meta(j).NNodes=MandN(2);
+            meta(j).NTimes=MandN(1);
+        else
+            meta(j).NNodes=max(MandN);
+            meta(j).NTimes=1;
+        end
+
+        if KeepHandles
+            meta(j).Handle=nc;
+        else
+            close(nc);
+        end
+    end
+
+
+function meta=EmptyMeta
+
+    meta=struct('Ok',false,'Message','','Handle',[],'NNodes',NaN,'NTimes',NaN,'GridHash','');
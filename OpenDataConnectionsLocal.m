@@ -199,6 +199,7 @@ function Connections=OpenDataConnectionsLocal(Url)
     Connections.members{1,NVars+1}.FileNetcdfVariableName='depth';
     Connections.members{1,NVars+1}.VariableDisplayName='Grid Elevation';
     Connections.members{1,NVars+1}.NNodes=Connections.members{1,1}.NNodes;
+    Connections.members{1,NVars+1}.GridHash=Connections.members{1,1}.GridHash;
     Connections.members{1,NVars+1}.NTimes=1;
     
     Connections.members{1,NVars+1}.Units='Meters';
@@ -208,18 +209,18 @@ function Connections=OpenDataConnectionsLocal(Url)
         Connections.members{1,NVars+1}.Units='Feet';
     end
              
-    % check the grids on which the variables are defined
-    NumberOfGridNodes=NaN*ones(NEns*NVars,1);
+    % check the grids on which the variables are defined; members on
+    % the same grid share it, by content hash (see GridFingerprint)
+    GridHashes={};
     GridId=0;
     for i=1:NEns
         for j=1:NVars+1        % +1 for the added grid depth
            Member=Connections.members{i,j};
            if ~isempty(Member) && ~isempty(Member.NcTBHandle)
-               nnodes=Member.NNodes;
-               gridid=find(NumberOfGridNodes==nnodes);
+               gridid=find(strcmp(GridHashes,Member.GridHash));
                if isempty(gridid)
                    GridId=GridId+1;
-                   NumberOfGridNodes(GridId)=nnodes;
+                   GridHashes{GridId}=Member.GridHash;
                    TheGrids{GridId}=GetGridStructure(Member,GridId);
                    if isfield(TheGrids{GridId},'z')
                        if any(strcmpi(Url.Units,{'english','feet'}))
@@ -245,6 +246,10 @@ function Connections=OpenDataConnectionsLocal(Url)
     
     function storm=GetStorm(url1) 
         storm=struct('NcTBHandle',[],'Units',[],'FieldDisplayName',[],'FileNetcdfVariableName',[],'GridHash',[]);
+        % the grid is fingerprinted once per storm; files whose grid
+        % dimensions match the fingerprinted one share its hash
+        GridSize=[];
+        GridHash=[];
         for ii=1:length(FilesToOpen)
             ThisVariable=FilesToOpen{ii};
             ThisVariableDisplayName=VariableDisplayNames{ii};
@@ -274,10 +279,12 @@ function Connections=OpenDataConnectionsLocal(Url)
             
             if ~isempty(ttemp)
                 
-                a=prod(double(size(ttemp.variable{'element'})));
-                b=prod(double(size(ttemp.variable{'x'})));
-
-                storm(ii).GridHash=DataHash2(a*b);
+                sz=[double(size(ttemp.variable{'element'})) double(size(ttemp.variable{'x'}))];
+                if ~isequal(sz,GridSize)
+                    GridSize=sz;
+                    GridHash=GridFingerprint(ttemp);
+                end
+                storm(ii).GridHash=GridHash;
                 
                 if iscell(ThisFileNetcdfVariableName)
                     MandN=size(ttemp{ThisFileNetcdfVariableName{1}});
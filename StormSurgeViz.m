@@ -22,6 +22,30 @@ function varargout=StormSurgeViz(varargin)
 % ColorMin          - Minimum scalar value for color scaling
 % ColorMap          - Color map to use; {'noaa_cmap','jet','hsv',...}
 % DisableContouring - {false,true} logical disabling mex compiled code calls
+% ReorderGrid       - {true,false} renumber grid nodes/elements for locality
+% SliceCacheMB      - (2048) memory budget for time levels kept in memory
+% PrefetchSlices    - (3) time levels read ahead in the stepping direction
+% NodeMajorStore    - {false,true} build local node-major copies of the
+%                     time-dependent variables for fast hydrographs
+% ConnectionPoolSize - (8) parallel workers used to connect to the ensemble
+%                     members at startup (Parallel Computing Toolbox);
+%                     0 connects to them in turn (see ConnectMembers)
+% DerivedFields     - ('mean spread p90 exceed inundation timemax') derived
+%                     fields added to the scalar variables, computed when
+%                     first shown; '' for none (see DefineDerivedFields)
+% ExceedanceLevel   - (1) water level for the 'exceed' derived field, the
+%                     fraction of members whose Max Water Level is above it
+% MeshLODElements   - (250000) most elements drawn for the current view;
+%                     the grid is drawn coarsened when zoomed out, 
+%                     0 draws the full grid (see ComputeMeshLOD)
+% Batch             - {false,true} render the products of the run to PNG
+%                     images, with no GUI, and quit (see BatchProducts):
+% BatchOutputDir    - ('') where; default TempDataLocation/products/<storm>_<advisory>
+% BatchVariables    - ('') comma-separated variables; default every scalar
+% BatchMembers      - ('') comma-separated members; default every member
+% BatchTimeLevels   - ([]) time levels; default every level
+% BatchImageWidth   - (1600) image width in pixels
+% BatchWorkers      - (4) parallel workers rendering; 0 renders in turn
 % GoogleMapsApiKey  - Api Key from Google for extended map accessing
 % PollingInterval   - (900) interval in seconds to poll for catalog updates.
 % ThreddsServer     - specify alternative THREDDS server
@@ -236,6 +260,20 @@ else  %  mode is "network"
 end
 setappdata(Handles.MainFigure,'Connections',Connections);
 
+%% MakeBatchProducts
+if SSVizOpts.Batch
+    if isfield(Connections,'members')
+        MakeBatchProducts(Handles);
+        Connections=getappdata(Handles.MainFigure,'Connections');
+    end
+    delete(Handles.MainFigure)   % ShutDownUI cleans up
+    if nargout>0, varargout{1}=[]; end
+    if nargout>1, varargout{2}=Url; end
+    if nargout>2, varargout{3}=Connections; end
+    if nargout>3, varargout{4}=SSVizOpts; end
+    return
+end
+
 %%
 global TheGrids
 
@@ -270,6 +308,7 @@ if isfield(Connections,'members')
         Connections=GetDataObject(Connections,EnsIndex,WindVecIndex,TimIndex);
         setappdata(Handles.MainFigure,'Connections',Connections);
     end
+    StartNodeMajorStore(Handles);
 end
 
 %% Process ensemble probabilities
@@ -500,6 +539,7 @@ function BrowseFileSystem(~,~)
    VarIndex=1;
    TimIndex=1;
    Connections=GetDataObject(Connections,EnsIndex,VarIndex,TimIndex);
+   StartNodeMajorStore(Handles);
 
     Handles=SetEnsembleControls(Handles.MainFigure);
     set(Handles.MainFigure,'UserData',Handles);
@@ -516,7 +556,7 @@ function BrowseFileSystem(~,~)
    ThisData=Connections.members{EnsIndex,VarIndex}.TheData{1};
    Handles=DrawTriSurf(Handles,Connections.members{EnsIndex,VarIndex},ThisData);
       
-   [Min,Max]=GetMinMaxInView(TheGrid,Connections.members{EnsIndex,VarIndex}.TheData{1});
+   [Min,Max]=GetMinMaxInView(TheGrid,ThisData,getappdata(Handles.TriSurf,'TileExtrema'));
    NumberOfColors=str2double(get(Handles.NCol,'String'));
    ColorIncrement=SSVizOpts.ColorIncrement;
    SetColors(Handles,Min,Max,NumberOfColors,ColorIncrement);
@@ -798,10 +838,19 @@ function Connections=OpenDataConnections(Url)
     Connections.members=cell(length(Connections.EnsembleNames),length(Connections.VariableNames));
     
     NEns=length(Url.Ens);
+
+    % connect to every member's files at once (see ConnectMembers)
+    Urls=cell(NEns,NVars);
+    for i=1:NEns
+        for j=1:NVars
+            Urls{i,j}=[Url.FullDodsC '/' Url.Ens{i} '/' FilesToOpen{j}];
+        end
+    end
+    SetUIStatusMessage(sprintf('* Connecting to %d files of %d members ...\n',NEns*NVars,NEns))
+    Meta=ConnectMembers(Urls,FileNetcdfVariableNames,SSVizOpts.ConnectionPoolSize,@SetUIStatusMessage);
        
     for i=1:NEns
-        TopDodsCUrl=[Url.FullDodsC '/' Url.Ens{i}];
-        storm=GetStorm(TopDodsCUrl); 
+        storm=GetStorm(i); 
 
         for j=1:NVars
             Connections.members{i,j}=storm(j);
@@ -851,10 +900,12 @@ function Connections=OpenDataConnections(Url)
     Connections.VariableDisplayNames{NVars+1}='Grid Elevation';
     Connections.VariableTypes{1,NVars+1}='Scalar';
     Connections.members{1,NVars+1}.NcTBHandle=Connections.members{1,1}.NcTBHandle;
+    Connections.members{1,NVars+1}.Url=Connections.members{1,1}.Url;
     Connections.members{1,NVars+1}.FieldDisplayName=[];
     Connections.members{1,NVars+1}.FileNetcdfVariableName='depth';
     Connections.members{1,NVars+1}.VariableDisplayName='Grid Elevation';
     Connections.members{1,NVars+1}.NNodes=Connections.members{1,1}.NNodes;
+    Connections.members{1,NVars+1}.GridHash=Connections.members{1,1}.GridHash;
     Connections.members{1,NVars+1}.NTimes=1;
     
     Connections.members{1,NVars+1}.Units='Meters';
@@ -864,18 +915,22 @@ function Connections=OpenDataConnections(Url)
         Connections.members{1,NVars+1}.Units='Feet';
     end
              
-    % check the grids on which the variables are defined
-    NumberOfGridNodes=NaN*ones(NEns*NVars,1);
+    % check the grids on which the variables are defined; members on
+    % the same grid share it, by content hash (see GridFingerprint)
+    GridHashes={};
     GridId=0;
     for i=1:NEns
         for j=1:NVars+1        % +1 for the added grid depth
            Member=Connections.members{i,j};
            if ~isempty(Member) && ~isempty(Member.NcTBHandle)
-               nnodes=Member.NNodes;
-               gridid=find(NumberOfGridNodes==nnodes);
+               gridid=find(strcmp(GridHashes,Member.GridHash));
                if isempty(gridid)
+                   if ischar(Member.NcTBHandle)
+                       Connections=OpenMemberHandles(Connections,i);
+                       Member=Connections.members{i,j};
+                   end
                    GridId=GridId+1;
-                   NumberOfGridNodes(GridId)=nnodes;
+                   GridHashes{GridId}=Member.GridHash;
                    TheGrids{GridId}=GetGridStructure(Member,GridId);
                    if isfield(TheGrids{GridId},'z')
                        if any(strcmpi(Url.Units,{'english','feet'}))
@@ -890,14 +945,23 @@ function Connections=OpenDataConnections(Url)
            end
         end
     end
+    
+    % derived fields (ensemble statistics, ...) go after the file
+    % variables and grid depth; they are computed when first shown
+    Connections=DefineDerivedFields(Connections,SSVizOpts.DerivedFields,SSVizOpts.ExceedanceLevel);
              
     SetUIStatusMessage('Done.\n')
     
     %%% nested fxn to get the data objects (not the data itself; that's
     %%% done in GetDataObjects)
     
-    function storm=GetStorm(url1) 
-        storm=struct('NcTBHandle',[],'Units',[],'FieldDisplayName',[],'FileNetcdfVariableName',[],'GridHash',[]);
+    function storm=GetStorm(i) 
+        % the handles, sizes and grid hashes of member i were gathered
+        % by ConnectMembers.  A member connected on a parallel worker
+        % gets its handles when first used (see OpenMemberHandles),
+        % except the first, which is shown at startup; until then
+        % NcTBHandle is the dataset url.
+        storm=struct('NcTBHandle',[],'Url',[],'Units',[],'FieldDisplayName',[],'FileNetcdfVariableName',[],'GridHash',[]);
         for ii=1:length(FilesToOpen)
             ThisVariable=FilesToOpen{ii};
             ThisVariableDisplayName=VariableDisplayNames{ii};
@@ -905,50 +969,35 @@ function Connections=OpenDataConnections(Url)
             %ThisVariableType=VariableType{ii};
             ThisUnits=VariableUnits{ii};
             ThisFileNetcdfVariableName=FileNetcdfVariableNames{ii};
-            url=[url1 '/' ThisVariable];
+            M=Meta(i,ii);
+            
             ttemp=[];
-            try
-                SetUIStatusMessage(sprintf('* Connecting to %s\n', ThisVariable))
-                ttemp=ncgeodataset(url);
-                SetUIStatusMessage(sprintf('* Opened %s  file connection.\n',ThisVariable))
-                if length(ttemp.variables)<1
-                    SetUIStatusMessage(sprintf('***** No variables found in %s\n', ThisVariable))
-                    ttemp=[];
+            if M.Ok
+                if ~isempty(M.Handle)
+                    ttemp=M.Handle;
+                elseif i==1
+                    ttemp=ncgeodataset(Urls{i,ii});
+                else
+                    ttemp=Urls{i,ii};
                 end
-            catch ME
+                SetUIStatusMessage(sprintf('* Opened %s  file connection.\n',ThisVariable))
+            else
                 SetUIStatusMessage(sprintf('***** Could not open %s connection. *****\n',ThisVariable))
                 if ii==1
-                    throw(ME)
+                    error('Could not open %s: %s',Urls{i,ii},M.Message)
                 end
             end
             
             storm(ii).NcTBHandle=ttemp;
+            storm(ii).Url=Urls{i,ii};
             storm(ii).Units=ThisUnits;
             storm(ii).VariableDisplayName=ThisVariableDisplayName;
             storm(ii).FileNetcdfVariableName=ThisFileNetcdfVariableName;
             
             if ~isempty(ttemp)
-                
-                a=prod(double(size(ttemp.variable{'element'})));
-                b=prod(double(size(ttemp.variable{'x'})));
-
-                storm(ii).GridHash=DataHash2(a*b);
-                
-                if iscell(ThisFileNetcdfVariableName)
-                    MandN=size(ttemp{ThisFileNetcdfVariableName{1}});
-                else
-                    MandN=size(ttemp{ThisFileNetcdfVariableName});
-                end
-                
-                if (length(MandN)>1  && ~any(MandN==1))
-                    m=MandN(2);
-                    n=MandN(1);
-                else
-                    m=max(MandN);
-                    n=1;
-                end
-                storm(ii).NNodes=m;
-                storm(ii).NTimes=n;
+                storm(ii).GridHash=M.GridHash;
+                storm(ii).NNodes=M.NNodes;
+                storm(ii).NTimes=M.NTimes;
             end
             
             %storm(ii).VariableType=ThisVariableType;
@@ -978,11 +1027,16 @@ function Connections=ProcessEnsemble(Connections)
     ifac=find(strcmp(Connections.VariableNames,'Max Water Level'));
     fac=Connections.VariableUnitsFac{ifac}; %#ok<FNDSB>
 
+    Connections=OpenMemberHandles(Connections,1:NEns);
     for i=1:NEns
         h=Handles.EnsButtonHandles(i);
         Z(:,i)=Connections.members{i,1}.NcTBHandle{'zeta_max'}(:);
         h.Enable='on';
     end
+    if isfield(g,'perm')
+        % put the nodal values in the grid's node order
+        Z=Z(g.perm,:);
+    end
     
     if Debug,fprintf('SSViz++   Computing Exceedence Levels... \n');end
     Zs=sort(Z,2);
@@ -1008,10 +1062,20 @@ end
 %%  GetDataObject
 %%% GetDataObject
 %%% GetDataObject
-function Connections=GetDataObject(Connections,EnsIndex,VarIndex,TimIndex) 
+function Connections=GetDataObject(Connections,EnsIndex,VarIndex,TimIndex,Quiet) 
 
-   global Debug 
+   global TheGrids Debug 
    if Debug,fprintf('SSViz++ Function = %s\n',ThisFunctionName);end
+   
+   % Quiet is set by the prefetch timer, which should not take over
+   % the status line
+   if ~exist('Quiet','var'),Quiet=false;end
+   
+   if isfield(Connections.members{EnsIndex,VarIndex},'Derived')
+       if ~exist('TimIndex','var'),TimIndex=1;end
+       Connections=GetDerivedObject(Connections,EnsIndex,VarIndex,TimIndex,Quiet);
+       return
+   end
 
    v=Connections.members{EnsIndex,VarIndex}.FileNetcdfVariableName;
    if ~iscell(v)
@@ -1027,8 +1091,18 @@ function Connections=GetDataObject(Connections,EnsIndex,VarIndex,TimIndex)
    str=sprintf('* Getting %s for ens=%s ',vstr,Connections.EnsembleNames{EnsIndex});
 
    fac=Connections.VariableUnitsFac{VarIndex};
+   Connections=OpenMemberHandles(Connections,EnsIndex);
    h=Connections.members{EnsIndex,VarIndex}.NcTBHandle;
    
+   % nodal data is put in the grid's node order (see ReorderGrid)
+   perm=[];
+   if isfield(Connections.members{EnsIndex,VarIndex},'GridId')
+       g=TheGrids{Connections.members{EnsIndex,VarIndex}.GridId};
+       if isfield(g,'perm')
+           perm=g.perm;
+       end
+   end
+   
 %    if isempty(h)
 %        % connection was not made.  Disable the variable and return
 %    end
@@ -1040,7 +1114,7 @@ function Connections=GetDataObject(Connections,EnsIndex,VarIndex,TimIndex)
    else
        str=[str ' at time level ' int2str(TimIndex) ' ...'];
    end  % first time level if TimIndex not passed in
-   SetUIStatusMessage(str);
+   if ~Quiet,SetUIStatusMessage(str);end
 
    if ~isfield(Connections.members{EnsIndex,VarIndex},'TheData')
 
@@ -1069,6 +1143,9 @@ function Connections=GetDataObject(Connections,EnsIndex,VarIndex,TimIndex)
           TheData=h.data(v{1})*fac;
       end
       TheData=cast(TheData(:),'double');  % just in case  ...
+      if length(TheData)==length(perm)
+          TheData=TheData(perm);
+      end
       Connections.members{EnsIndex,VarIndex}.TheData{1}=TheData;
       
    else
@@ -1087,10 +1164,450 @@ function Connections=GetDataObject(Connections,EnsIndex,VarIndex,TimIndex)
           temp=temp+sqrt(-1)*temp2;
           temp(inan)=NaN;
       end
+      if length(temp)==length(perm)
+          temp=temp(perm);
+      end
       Connections.members{EnsIndex,VarIndex}.TheData{TimIndex}=temp*fac;
+      Connections=CacheSlice(Connections,EnsIndex,VarIndex,TimIndex);
    end
    
-   SetUIStatusMessage('* Got it.')
+   if ~Quiet,SetUIStatusMessage('* Got it.');end
+
+end
+
+%%  GetDerivedObject
+%%% GetDerivedObject
+%%% GetDerivedObject
+function Connections=GetDerivedObject(Connections,EnsIndex,VarIndex,TimIndex,Quiet) 
+
+   % Computes time level TimIndex of the derived field (EnsIndex,VarIndex)
+   % (see DefineDerivedFields) from its source variable, reading the
+   % source levels not yet in memory, and keeps it in TheData like a
+   % file variable.  Ensemble statistics are taken in one pass over the
+   % members (see EnsembleStats) and, being the same for every member,
+   % are kept in every member row.
+   
+   global TheGrids
+   
+   Member=Connections.members{EnsIndex,VarIndex};
+   d=Member.Derived;
+   if ~Quiet
+       SetUIStatusMessage(sprintf('* Computing %s ...',Connections.VariableNames{VarIndex}));
+   end
+   
+   if d.Ensemble
+       Rows=1:length(Connections.EnsembleNames);
+   else
+       Rows=EnsIndex;
+   end
+   
+   if strcmp(d.Op,'timemax')
+       Connections=OpenMemberHandles(Connections,EnsIndex);
+       q=TimeMaxOfMember(Connections,EnsIndex,d.Source);
+   else
+       Z={};
+       for i=Rows
+           Source=Connections.members{i,d.Source};
+           if isempty(Source) || ~isfield(Source,'NcTBHandle') || isempty(Source.NcTBHandle)
+               % members that did not connect are left out
+               continue
+           end
+           % level 1 first; GetDataObject's first read goes to TheData{1}
+           if ~IsSliceLoaded(Connections,i,d.Source,1)
+               Connections=GetDataObject(Connections,i,d.Source,1,true);
+           end
+           if ~IsSliceLoaded(Connections,i,d.Source,TimIndex)
+               Connections=GetDataObject(Connections,i,d.Source,TimIndex,true);
+           end
+           Z{end+1}=Connections.members{i,d.Source}.TheData{TimIndex}; %#ok<AGROW>
+       end
+       if strcmp(d.Op,'inundation')
+           q=EnsembleStats(Z,[1 0],TheGrids{Member.GridId}.z);
+       else
+           q=EnsembleStats(Z,[d.Code d.Param]);
+       end
+   end
+   
+   for i=Rows
+       Connections.members{i,VarIndex}.TheData{TimIndex}=q;
+   end
+   Connections=CacheSlice(Connections,EnsIndex,VarIndex,TimIndex);
+   
+   if ~Quiet,SetUIStatusMessage('* Got it.');end
+
+end
+
+%%  TimeMaxOfMember
+function q=TimeMaxOfMember(Connections,EnsIndex,VarIndex) 
+
+   % Nodal maximum over every time level of member (EnsIndex,VarIndex),
+   % read in slabs of time levels, each one contiguous read, so that the
+   % levels are neither kept nor put through the slice cache.
+   
+   global TheGrids
+   
+   Member=Connections.members{EnsIndex,VarIndex};
+   hh=Member.NcTBHandle.geovariable(Member.FileNetcdfVariableName);
+   nn=Member.NNodes;
+   nt=Member.NTimes;
+   B=max(1,floor(64*2^20/(8*nn)));    % levels per read, 64MB of doubles
+   
+   q=-Inf(nn,1);
+   for t1=1:B:nt
+       t2=min(t1+B-1,nt);
+       SetUIStatusMessage(sprintf('* Time levels %d-%d of %d ...',t1,t2,nt),false);
+       temp=cast(hh.data(t1:t2,:),'double');
+       q=max(q,max(temp,[],1)');     % MAX skips NaN (dry) levels
+   end
+   q(isinf(q))=NaN;
+   q=q*Connections.VariableUnitsFac{VarIndex};
+   
+   g=TheGrids{Member.GridId};
+   if isfield(g,'perm') && length(q)==length(g.perm)
+       q=q(g.perm);
+   end
+
+end
+
+%%  CacheSlice
+%%% CacheSlice
+%%% CacheSlice
+function Connections=CacheSlice(Connections,EnsIndex,VarIndex,TimIndex) 
+
+   % Records a use of time level TimIndex of member (EnsIndex,VarIndex)
+   % and evicts the least recently used time levels, of any member,
+   % until those kept fit in SSVizOpts.SliceCacheMB.  Level 1 of each
+   % member is its default field, read throughout, and is never
+   % evicted; neither is the level just used.  The use table lives in
+   % Connections, so it goes with it when a new storm is loaded.
+   
+   global SSVizOpts
+   
+   if TimIndex<2,return,end
+   if ~isfield(Connections,'SliceCache')
+       Connections.SliceCache=struct('keys',zeros(0,3),'bytes',zeros(0,1),...
+                                     'used',zeros(0,1),'clock',0);
+   end
+   C=Connections.SliceCache;
+   C.clock=C.clock+1;
+   
+   k=find(C.keys(:,1)==EnsIndex & C.keys(:,2)==VarIndex & C.keys(:,3)==TimIndex,1);
+   if isempty(k)
+       d=Connections.members{EnsIndex,VarIndex}.TheData{TimIndex}; %#ok<NASGU>
+       w=whos('d');
+       C.keys(end+1,:)=[EnsIndex VarIndex TimIndex];
+       C.bytes(end+1,1)=w.bytes;
+       C.used(end+1,1)=C.clock;
+   else
+       C.used(k)=C.clock;
+   end
+   
+   Budget=SSVizOpts.SliceCacheMB*2^20;
+   Total=sum(C.bytes);
+   if Total>Budget
+       [~,o]=sort(C.used);
+       evict=false(size(C.used));
+       for i=o(1:end-1)'
+           if Total<=Budget,break,end
+           % an ensemble statistic is kept in every member row
+           Rows=C.keys(i,1);
+           Member=Connections.members{Rows,C.keys(i,2)};
+           if isfield(Member,'Derived') && Member.Derived.Ensemble
+               Rows=1:length(Connections.EnsembleNames);
+           end
+           for r=Rows
+               Connections.members{r,C.keys(i,2)}.TheData{C.keys(i,3)}=[];
+           end
+           Total=Total-C.bytes(i);
+           evict(i)=true;
+       end
+       C.keys(evict,:)=[];
+       C.bytes(evict)=[];
+       C.used(evict)=[];
+   end
+   Connections.SliceCache=C;
+
+end
+
+%%  PrefetchSlices
+%%% PrefetchSlices
+%%% PrefetchSlices
+function PrefetchSlices(Handles,EnsIndex,VarIndices,TimIndex,Direction) 
+
+   % Queues the next SSVizOpts.PrefetchSlices time levels after 
+   % TimIndex in the stepping Direction (+1/-1) for the members 
+   % (EnsIndex,VarIndices) that are not in memory, and starts the 
+   % prefetch timer to read them one per tick while MATLAB is idle.
+   % A new queue replaces the old one, so reading follows the user.
+   
+   global Connections SSVizOpts
+   
+   if SSVizOpts.PrefetchSlices<1 || ~exist('timer','file'),return,end
+   Connections=MergeTimerResults(Connections);
+   
+   nt=get(Handles.ScalarSnapshotSliderHandle,'Max');
+   Queue=zeros(0,3);
+   for k=1:SSVizOpts.PrefetchSlices
+       t=TimIndex+Direction*k;
+       if t<2 || t>nt,break,end
+       for v=VarIndices(:)'
+           % members not yet read at all are left to GetDataObject's
+           % first-read path
+           if ~isfield(Connections.members{EnsIndex,v},'TheData'),continue,end
+           if ~IsSliceLoaded(Connections,EnsIndex,v,t)
+               Queue(end+1,:)=[EnsIndex v t]; %#ok<AGROW>
+           end
+       end
+   end
+   
+   PrefetchTimer=timerfind('Name','StormSurgeVizPrefetch');
+   if isempty(PrefetchTimer)
+       PrefetchTimer=timer('ExecutionMode','fixedSpacing',...
+                           'BusyMode','drop',...
+                           'Period',.05,...
+                           'TimerFcn',@PrefetchFromTimer,...
+                           'Name','StormSurgeVizPrefetch');
+   end
+   set(PrefetchTimer,'UserData',Queue);
+   if ~isempty(Queue) && strcmp(get(PrefetchTimer,'Running'),'off')
+       start(PrefetchTimer);
+   end
+   
+end
+
+%%  PrefetchFromTimer
+function PrefetchFromTimer(hObj,~) 
+
+   global Connections
+   
+   Queue=get(hObj,'UserData');
+   if isempty(Queue)
+       stop(hObj);
+       return
+   end
+   set(hObj,'UserData',Queue(2:end,:));
+   e=Queue(1,1);v=Queue(1,2);t=Queue(1,3);
+   % read into a copy, and post what was read (see PostTimerResult)
+   C=MergeTimerResults(Connections,true);
+   if ~IsSliceLoaded(C,e,v,t)
+       try
+           C2=GetDataObject(C,e,v,t,true);
+           PostTimerResult('slices',[e v t],C2.members{e,v}.TheData{t});
+           PostOpenedHandles(C,C2);
+       catch ME
+           % leave it to be read, and reported, when it is viewed
+           fprintf('SSViz++ Prefetch of time level %d failed: %s\n',t,ME.message);
+       end
+   end
+   
+end
+
+%%  StartNodeMajorStore
+%%% StartNodeMajorStore
+%%% StartNodeMajorStore
+function StartNodeMajorStore(Handles) 
+
+   % With SSVizOpts.NodeMajorStore, queues every time-dependent scalar
+   % member of the open run for a node-major copy in TempDataLocation
+   % (see NodeMajorStore), built one slab of time levels per timer
+   % tick while MATLAB is idle.  LoadNodeTimeSeries reads a member's
+   % copy once it is complete.
+   
+   global Connections SSVizOpts
+   
+   StoreTimer=timerfind('Name','StormSurgeVizNodeMajor');
+   if ~isempty(StoreTimer)
+       stop(StoreTimer);
+       delete(StoreTimer);
+   end
+   % the timers' results and queued reads are of the run before
+   PrefetchTimer=timerfind('Name','StormSurgeVizPrefetch');
+   if ~isempty(PrefetchTimer)
+       set(PrefetchTimer,'UserData',zeros(0,3));
+   end
+   setappdata(Handles.MainFigure,'TimerResults',[]);
+   if ~SSVizOpts.NodeMajorStore || ~exist('timer','file'),return,end
+   
+   TempDataLocation=getappdata(Handles.MainFigure,'TempDataLocation');
+   Queue={};
+   [NEns,NVars]=size(Connections.members);
+   for j=1:NVars
+       for i=1:NEns
+           Member=Connections.members{i,j};
+           if isempty(Member) || ~isfield(Member,'NTimes') || Member.NTimes<2 || ...
+                   ~ischar(Member.FileNetcdfVariableName) || isempty(Member.NcTBHandle) || ...
+                   isfield(Member,'Derived')
+               continue
+           end
+           f=NodeMajorStore('file',TempDataLocation,Member.NcTBHandle,Member.FileNetcdfVariableName);
+           Queue(end+1,:)={f,i,j}; %#ok<AGROW>
+       end
+   end
+   if isempty(Queue),return,end
+   
+   StoreTimer=timer('ExecutionMode','fixedSpacing',...
+                    'BusyMode','drop',...
+                    'Period',.1,...
+                    'TimerFcn',@NodeMajorStoreFromTimer,...
+                    'UserData',Queue,...
+                    'Name','StormSurgeVizNodeMajor');
+   start(StoreTimer);
+
+end
+
+%%  NodeMajorStoreFromTimer
+function NodeMajorStoreFromTimer(hObj,~) 
+
+   global Connections
+   
+   Queue=get(hObj,'UserData');
+   if isempty(Queue)
+       stop(hObj);
+       delete(hObj);
+       return
+   end
+   % a copy, with what this and the prefetch timer have posted; what
+   % is opened or stamped here is posted (see PostTimerResult)
+   C=MergeTimerResults(Connections,true);
+   i=Queue{1,2};j=Queue{1,3};
+   if ischar(C.members{i,j}.NcTBHandle)
+       C2=OpenMemberHandles(C,i);
+       PostOpenedHandles(C,C2);
+       C=C2;
+   end
+   Member=C.members{i,j};
+   try
+       if isfield(Member,'NodeMajorStamp')
+           stamp=Member.NodeMajorStamp;
+       else
+           stamp=NodeMajorStore('stamp',Member.NcTBHandle,Member.FileNetcdfVariableName);
+           PostTimerResult('stamps',[i j],stamp);
+       end
+       done=NodeMajorStore('append',Queue{1,1},Member.NcTBHandle,Member.FileNetcdfVariableName,stamp);
+   catch ME
+       fprintf('SSViz++ Node-major store %s not built: %s\n',Queue{1,1},ME.message);
+       done=true;
+   end
+   if done
+       set(hObj,'UserData',Queue(2:end,:));
+   end
+   
+end
+
+%%  NodeMajorStamp
+function stamp=NodeMajorStamp(EnsIndex,VarIndex) 
+
+   % the member's NodeMajorStore stamp, computed once per session, so
+   % that a store left from other contents at the same location (a run
+   % redone, a local file overwritten) is rebuilt and not read.  It
+   % sets the global Connections, so it is not called from a timer
+   global Connections
+   
+   Connections=MergeTimerResults(Connections);
+   Member=Connections.members{EnsIndex,VarIndex};
+   if ~isfield(Member,'NodeMajorStamp')
+       Member.NodeMajorStamp=NodeMajorStore('stamp',Member.NcTBHandle,Member.FileNetcdfVariableName);
+       Connections.members{EnsIndex,VarIndex}.NodeMajorStamp=Member.NodeMajorStamp;
+   end
+   stamp=Member.NodeMajorStamp;
+
+end
+
+%%  PostTimerResult
+function PostTimerResult(Kind,Key,Value) 
+
+   % Keeps what a timer callback has read or opened, Kind 'slices'
+   % (Key [EnsIndex VarIndex TimIndex]), 'handles' or 'stamps' (Key
+   % [EnsIndex VarIndex]), in the main figure's appdata until the
+   % foreground merges it into Connections (see MergeTimerResults).  A
+   % timer callback must not assign the global Connections: one that
+   % runs during the drawnow or status updates inside a foreground
+   % Connections=GetDataObject(...) is lost when that call returns.
+   
+   MainFig=findobj(0,'Tag','MainVizAppFigure');
+   if isempty(MainFig),return,end
+   R=getappdata(MainFig,'TimerResults');
+   if isempty(R)
+       R=struct('slices',{cell(0,2)},'handles',{cell(0,2)},'stamps',{cell(0,2)});
+   end
+   R.(Kind)(end+1,:)={Key,Value};
+   setappdata(MainFig,'TimerResults',R);
+
+end
+
+%%  PostOpenedHandles
+function PostOpenedHandles(Before,After) 
+
+   % posts the member handles that OpenMemberHandles opened in After
+   for i=1:size(Before.members,1)
+       for j=1:size(Before.members,2)
+           Member=Before.members{i,j};
+           if ~isempty(Member) && isfield(Member,'NcTBHandle') && ischar(Member.NcTBHandle) && ...
+                   ~ischar(After.members{i,j}.NcTBHandle)
+               PostTimerResult('handles',[i j],After.members{i,j}.NcTBHandle);
+           end
+       end
+   end
+
+end
+
+%%  MergeTimerResults
+function Connections=MergeTimerResults(Connections,Keep) 
+
+   % Merges the results posted by the timer callbacks (see
+   % PostTimerResult) into Connections: handles and stamps not yet in
+   % it, and time levels not yet loaded, through the slice cache.  The
+   % foreground merges them into the global Connections and clears
+   % them; a timer callback merges them into its own copy, with Keep,
+   % so that it does not read or open them again.
+   
+   if ~exist('Keep','var'),Keep=false;end
+   MainFig=findobj(0,'Tag','MainVizAppFigure');
+   if isempty(MainFig),return,end
+   R=getappdata(MainFig,'TimerResults');
+   if isempty(R),return,end
+   
+   for k=1:size(R.handles,1)
+       i=R.handles{k,1}(1);j=R.handles{k,1}(2);
+       if isfield(Connections.members{i,j},'NcTBHandle') && ischar(Connections.members{i,j}.NcTBHandle)
+           Connections.members{i,j}.NcTBHandle=R.handles{k,2};
+       end
+   end
+   for k=1:size(R.stamps,1)
+       i=R.stamps{k,1}(1);j=R.stamps{k,1}(2);
+       if isstruct(Connections.members{i,j}) && ~isfield(Connections.members{i,j},'NodeMajorStamp')
+           Connections.members{i,j}.NodeMajorStamp=R.stamps{k,2};
+       end
+   end
+   for k=1:size(R.slices,1)
+       e=R.slices{k,1}(1);v=R.slices{k,1}(2);t=R.slices{k,1}(3);
+       % members not yet read at all are left to GetDataObject's
+       % first-read path, as in PrefetchSlices
+       Member=Connections.members{e,v};
+       if ~isfield(Member,'TheData') || IsSliceLoaded(Connections,e,v,t),continue,end
+       % an ensemble statistic is kept in every member row
+       Rows=e;
+       if isfield(Member,'Derived') && Member.Derived.Ensemble
+           Rows=1:length(Connections.EnsembleNames);
+       end
+       for r=Rows
+           Connections.members{r,v}.TheData{t}=R.slices{k,2};
+       end
+       Connections=CacheSlice(Connections,e,v,t);
+   end
+   
+   if ~Keep
+       setappdata(MainFig,'TimerResults',[]);
+   end
+
+end
+
+%%  IsSliceLoaded
+function tf=IsSliceLoaded(Connections,EnsIndex,VarIndex,TimIndex)
+
+   Member=Connections.members{EnsIndex,VarIndex};
+   tf=isfield(Member,'TheData') && iscell(Member.TheData) && ...
+      length(Member.TheData)>=TimIndex && ~isempty(Member.TheData{TimIndex});
 
 end
 
@@ -1196,6 +1713,7 @@ function InstanceUrl(varargin)
    VarIndex=1;
    TimIndex=1;
    Connections=GetDataObject(Connections,EnsIndex,VarIndex,TimIndex);
+   StartNodeMajorStore(Handles);
    %setappdata(Handles.MainFigure,'Connections',Connections);
 
    Handles=SetEnsembleControls(Handles.MainFigure);
@@ -1215,7 +1733,7 @@ function InstanceUrl(varargin)
    ThisData=Connections.members{EnsIndex,VarIndex}.TheData{1};
    Handles=DrawTriSurf(Handles,Connections.members{EnsIndex,VarIndex},ThisData);
       
-   [Min,Max]=GetMinMaxInView(TheGrid,Connections.members{EnsIndex,VarIndex}.TheData{1});
+   [Min,Max]=GetMinMaxInView(TheGrid,ThisData,getappdata(Handles.TriSurf,'TileExtrema'));
    NumberOfColors=str2double(get(Handles.NCol,'String'));
    ColorIncrement=SSVizOpts.ColorIncrement;
    SetColors(Handles,Min,Max,NumberOfColors,ColorIncrement);
@@ -1325,7 +1843,7 @@ function SetNewField(varargin)
         
         NumberOfColors=str2double(get(Handles.NCol,'String'));
         ColorIncrement=SSVizOpts.ColorIncrement;
-        [Min,Max]=GetMinMaxInView(TheGrid,ThisData);
+        [Min,Max]=GetMinMaxInView(TheGrid,ThisData,getappdata(Handles.TriSurf,'TileExtrema'));
         SetColors(Handles,Min,Max,NumberOfColors,ColorIncrement);
         
     end
@@ -1556,11 +2074,21 @@ function Handles=DrawTriSurf(Handles,Member,Field)
 % 
 %     end
     
-    Handles.TriSurf=trisurf(TheGrid.e,TheGrid.x,TheGrid.y,...
+    % only the elements in view, at a resolution bounded by 
+    % MeshLODElements; RefreshTriSurf redraws them on pan/zoom
+    SSVizOpts=getappdata(Handles.MainFigure,'SSVizOpts');
+    e=SelectMeshLOD(TheGrid,axis(Handles.MainAxes),SSVizOpts.MeshLODElements);
+
+    Handles.TriSurf=trisurf(e,TheGrid.x,TheGrid.y,...
         ones(size(TheGrid.x)),Field,'EdgeColor','none',...
         'FaceColor','interp','Tag','TriSurf');
 
+    setappdata(Handles.TriSurf,'GridId',Member.GridId);
     setappdata(Handles.TriSurf,'Field',Field);
+    if isfield(TheGrid,'nodeindex') && isstruct(TheGrid.nodeindex)
+        % tile min/max of this field, for the in-view queries
+        setappdata(Handles.TriSurf,'TileExtrema',TileExtrema(TheGrid,Field));
+    end
     setappdata(Handles.TriSurf,'FieldMax',max(Field));
     setappdata(Handles.TriSurf,'FieldMin',min(Field));
     setappdata(Handles.TriSurf,'Name',[]);
@@ -1662,8 +2190,8 @@ function Handles=DrawVectors(Handles,Member,Field)
     TheGrid=TheGrids{Member.GridId};
     
     %VectorOptions=getappdata(Handles.MainFigure,'VectorOptions');
-    Stride=get(Handles.VectorOptionsStride,'String');
-    Stride=str2double(Stride);
+    Spacing=get(Handles.VectorOptionsSpacing,'String');
+    Spacing=str2double(Spacing);
     ScaleFac=get(Handles.VectorOptionsScaleFactor,'String');
     ScaleFac=str2double(ScaleFac);
     ScaleLabel=get(Handles.VectorOptionsScaleLabel,'String');
@@ -1678,9 +2206,10 @@ function Handles=DrawVectors(Handles,Member,Field)
     u=real(Field);
     v=imag(Field);
     axes(Handles.MainAxes);
+    % one vector per Spacing pixels of the view, from the nodes in view
     Handles.Vectors=vecplot(TheGrid.x,TheGrid.y,u,v,...
         'ScaleFac',ScaleFac,...
-        'Stride',Stride,...
+        'Spacing',Spacing,...
         'Color',Color,...
         'ScaleLabel',ScaleLabel); %,...
         %'ScaleType','floating');
@@ -1690,11 +2219,53 @@ function Handles=DrawVectors(Handles,Member,Field)
     nz=2*ones(size(get(Handles.Vectors(1),'XData')));
     set(Handles.Vectors(1),'ZData',nz);
     setappdata(Handles.Vectors(1),'Field',Field);
+    % what RefreshVectors needs to repick the vectors on pan/zoom, at
+    % the same length scale as the drawn vector scale
+    xl=get(Handles.MainAxes,'XLim');
+    setappdata(Handles.Vectors(1),'VectorOptions',...
+        struct('GridId',Member.GridId,'Spacing',Spacing,'Color',Color,...
+               'ScaleFac',ScaleFac,'XRange',xl(2)-xl(1)));
     
     drawnow
     
 end
 
+%%  RefreshVectors
+function Handles=RefreshVectors(Handles)
+
+    % repick the vectors for the current view, keeping the vector scale
+    global TheGrids
+
+    if ~isfield(Handles,'Vectors') || isempty(Handles.Vectors) || ~ishandle(Handles.Vectors(1))
+        return
+    end
+    VectorOptions=getappdata(Handles.Vectors(1),'VectorOptions');
+    if isempty(VectorOptions) || ~(VectorOptions.Spacing>0)
+        return
+    end
+    Field=getappdata(Handles.Vectors(1),'Field');
+    TheGrid=TheGrids{VectorOptions.GridId};
+    
+    % vecplot scales vectors to a fraction of the x range, so the 
+    % scale factor follows the range to keep the drawn length
+    xl=get(Handles.MainAxes,'XLim');
+    ScaleFac=VectorOptions.ScaleFac*(xl(2)-xl(1))/VectorOptions.XRange;
+    
+    delete(Handles.Vectors(1));
+    axes(Handles.MainAxes);
+    h=vecplot(TheGrid.x,TheGrid.y,real(Field),imag(Field),...
+        'ScaleFac',ScaleFac,...
+        'Spacing',VectorOptions.Spacing,...
+        'Color',VectorOptions.Color,...
+        'ScaleLabel','no scale');
+    % above the surface, as DrawVectors draws them
+    set(h(1),'ZData',2*ones(size(get(h(1),'XData'))));
+    Handles.Vectors(1)=h(1);
+    setappdata(h(1),'Field',Field);
+    setappdata(h(1),'VectorOptions',VectorOptions);
+
+end
+
 %%  RedrawVectors
 %%% RedrawVectors
 %%% RedrawVectors
@@ -1792,6 +2363,8 @@ ColorMap=SSVizOpts.ColorMap;
 UseGoogleMaps=SSVizOpts.UseGoogleMaps;
 ForkAxes=SSVizOpts.ForkAxes;
 HOME=SSVizOpts.HOME;
+Visible='on';
+if SSVizOpts.Batch, Visible='off'; end   % products only; no GUI shown
 Mode=SSVizOpts.Mode;
 KeepInSync=SSVizOpts.KeepScalarsAndVectorsInSync;
 
@@ -1827,6 +2400,7 @@ if ~ForkAxes
         'Tag','MainVizAppFigure',...
         'NumberTitle','off',...
         'Name',AppName,...
+        'Visible',Visible,...
         'Resize','off');
         Handles.panHandle=pan(Handles.MainFigure); %#ok<*NASGU>
         Handles.zoomHandle=zoom(Handles.MainFigure);
@@ -1850,6 +2424,7 @@ else
         'Tag','MainVizAppFigure',...
         'NumberTitle','off',...
         'Name',AppName,...
+        'Visible',Visible,...
         'Resize','off');
     
     Handles.MainFigureSub=figure(...  % this contains the drawing axes if forked
@@ -1861,6 +2436,7 @@ else
         'Tag','MainVizAppFigureSub',...
         'NumberTitle','off',...
         'Name',AppName,...
+        'Visible',Visible,...
         'CloseRequestFcn','');
     
     Handles.panHandle=pan(Handles.MainFigureSub);
@@ -3053,8 +3629,8 @@ BackgroundMapsContainerContents;
             'Position',[.01 .87 Width Height],...
             'FontSize',fs2,...
             'HorizontalAlignment','right',...
-            'String','Stride = ');
-        Handles.VectorOptionsStride=uicontrol(...
+            'String','Spacing (px) = ');
+        Handles.VectorOptionsSpacing=uicontrol(...
             'Parent',Handles.VectorOptionsPanel,...
             'Style','edit',...
             'Units','normalized',...
@@ -3062,8 +3638,8 @@ BackgroundMapsContainerContents;
             'Position',[.34 .87 Width2 Height],...
             'FontSize',fs1,...
             'HorizontalAlignment','left',...
-            'Tag','VectorOptionsStride',...
-            'String','1000');
+            'Tag','VectorOptionsSpacing',...
+            'String','25');
         
         % ScaleFac
         % ScaleFac
@@ -3411,6 +3987,11 @@ function ShutDownUI(~,~)
             delete(Handles.Timer);
         end
     end
+    PrefetchTimer=[timerfind('Name','StormSurgeVizPrefetch') timerfind('Name','StormSurgeVizNodeMajor')];
+    if ~isempty(PrefetchTimer)
+        stop(PrefetchTimer);
+        delete(PrefetchTimer);
+    end
 
     parent=get(get(Handles.MainAxes,'Parent'),'Parent');
     delete(parent)
@@ -3600,7 +4181,8 @@ function Handles=SetVariableControls(varargin)
         'Tag','ScalarVariableMemberRadioButtonGroup',...
         'SelectionChangeFcn',@SetNewField);
     
-    dy2=1/11;
+    % derived fields can make the list longer than the panel's 10
+    dy2=min(1/11,.95/max(NVar,1));
     for i=1:NVar
         Handles.ScalarVarButtonHandles(i)=uicontrol(...
             Handles.ScalarVarButtonHandlesGroup,...
@@ -3801,24 +4383,16 @@ function Handles=SetSnapshotControls(varargin)
         % base the times on the variables selected in the UI. 
         
         try
-            time=Connections.members{EnsIndex,b(iThreeDvar)}.NcTBHandle.geovariable('time');
+            Connections=OpenMemberHandles(Connections,EnsIndex);
+            time_datenum=MemberTimes(Connections.members{EnsIndex,b(iThreeDvar)}.NcTBHandle,DateStringFormatInput);
         catch ME
             msg=sprintf('Time variable in %s not correctly defined. The simulation may not be finished.  This is terminal. \n');
             SetUIStatusMessage(msg)
             throw(ME)
         end
-        basedate=time.attribute('base_date');
-        if isempty(basedate)
-            s=time.attribute('units');
-            p=strspl(s);
-            basedate=datestr(datenum([p{3} ' ' p{4}],DateStringFormatInput));
-        end
-        timebase_datenum=datenum(basedate,DateStringFormatInput);
-        t=cast(time.data(:),'double');
-        snapshotlist=cell(length(t),1);
-        time_datenum=time.data(:)/86400+timebase_datenum;
-        for i=1:length(t)
-            snapshotlist{i}=datestr(t(i)/86400+timebase_datenum+LocalTimeOffset/24,DateStringFormatOutput);
+        snapshotlist=cell(length(time_datenum),1);
+        for i=1:length(time_datenum)
+            snapshotlist{i}=datestr(time_datenum(i)+LocalTimeOffset/24,DateStringFormatOutput);
         end
         [m,~]=size(snapshotlist);
         
@@ -3966,6 +4540,8 @@ function ViewSnapshot(hObj,~)
         VectorSnapshotClicked=[];
     end
     
+    % time levels read ahead by the prefetch timer
+    Connections=MergeTimerResults(Connections);
     EnsembleNames=Connections.EnsembleNames; 
     VariableNames=Connections.VariableNames; 
     
@@ -3997,6 +4573,7 @@ function ViewSnapshot(hObj,~)
             end
         end
         ScalarData=Connections.members{EnsIndex,ScalarVarIndex}.TheData{ScalarSnapshotSliderValue};
+        Connections=CacheSlice(Connections,EnsIndex,ScalarVarIndex,ScalarSnapshotSliderValue);
         if InundationClicked && ismember(Connections.VariableNames{ScalarVarIndex},{'Water Level','Max Water Level'});
             z=TheGrid.z;
             idx=z<0;
@@ -4021,6 +4598,7 @@ function ViewSnapshot(hObj,~)
             end
         end
         VectorData=Connections.members{EnsIndex,VectorVarIndex}.TheData{VectorSnapshotSliderValue};
+        Connections=CacheSlice(Connections,EnsIndex,VectorVarIndex,VectorSnapshotSliderValue);
         if VectorAsScalar
             VectorData=abs(VectorData);
             ScalarData=VectorData;
@@ -4071,6 +4649,20 @@ function ViewSnapshot(hObj,~)
     setappdata(FigHandle,'Connections',Connections);
     UpdateUI(Handles.MainFigure);
     SetTitle(Connections);
+    
+    % read ahead in the direction the user is stepping
+    LastSnapshot=getappdata(Handles.MainFigure,'LastSnapshot');
+    Direction=1;
+    if ~isempty(LastSnapshot) && SnapshotClicked<LastSnapshot
+        Direction=-1;
+    end
+    setappdata(Handles.MainFigure,'LastSnapshot',SnapshotClicked);
+    PrefetchVars=[];
+    if ScalarClicked,PrefetchVars=ScalarVarIndex;end
+    if VectorClicked && ~isempty(VectorVarIndex) && ~VectorAsScalar
+        PrefetchVars=[PrefetchVars VectorVarIndex];
+    end
+    PrefetchSlices(Handles,EnsIndex,PrefetchVars,SnapshotClicked,Direction);
 
     %SetUIStatusMessage('Done.')
     if ScalarClicked
@@ -4167,15 +4759,18 @@ function ExportShapeFile(~,~)
         throw(ME);
     end
     
-    figure
-    geoshow(SS,'SymbolSpec',spec)
-    caxis([edges(1) edges(end)])
-    colormap(jet(length(bin_centers)))
-    colorbar
-    title(sprintf('GeoShow view of exported Shape File in %s',strrep(OutName,'_','\_')))
-    axes(Handles.MainAxes);
+    % the preview needs the Mapping Toolbox; the file itself does not
+    if exist('geoshow','file')
+        figure
+        geoshow(SS,'SymbolSpec',spec)
+        caxis([edges(1) edges(end)])
+        colormap(jet(length(bin_centers)))
+        colorbar
+        title(sprintf('GeoShow view of exported Shape File in %s',strrep(OutName,'_','\_')))
+        axes(Handles.MainAxes);
+    end
 
-    shapewrite(SS,sprintf('%s.shp',OutName))
+    WriteShapeFile(SS,OutName)
     SetUIStatusMessage(sprintf('Done. Shape File = %s/%s\n',pwd,OutName))
 
 end
@@ -4291,6 +4886,273 @@ function GraphicOutputPrint(~,~)
       
 end
 
+%%  MakeBatchProducts
+%%% MakeBatchProducts
+%%% MakeBatchProducts
+function MakeBatchProducts(Handles) 
+
+    % Renders the product set of the open run, each selected member,
+    % variable and time level, to PNG images in SSVizOpts.BatchOutputDir
+    % without drawing them (see RasterWeights and BatchProducts), for
+    % StormSurgeViz('Batch',true,...).  The pixels are located once per
+    % grid.  Each variable is colored over fixed limits, found from its
+    % first member's first time level as at startup, so that its images
+    % compare.  File variables are read and rendered on the parallel
+    % workers, a few time levels per task, so that reads from the
+    % server overlap rendering; derived fields are computed here while
+    % the workers render, and sent to them.  products.txt in the output
+    % directory lists the images with their times and color limits.
+    
+    global Connections TheGrids SSVizOpts 
+    
+    TempDataLocation=getappdata(Handles.MainFigure,'TempDataLocation');
+    DateStringFormatInput=getappdata(Handles.MainFigure,'DateStringFormatInput');
+    
+    OutDir=SSVizOpts.BatchOutputDir;
+    if isempty(OutDir)
+        OutDir=[TempDataLocation '/products'];
+        if isfield(Connections,'RunProperties')
+            OutDir=sprintf('%s/%s_%s',OutDir,...
+                BatchName(GetRunProperty(Connections.RunProperties,'stormname')),...
+                BatchName(GetRunProperty(Connections.RunProperties,'advisory')));
+        end
+    end
+    if ~exist(OutDir,'dir'),mkdir(OutDir);end
+    SetUIStatusMessage(sprintf('Making batch products in %s ...\n',OutDir))
+    
+    EnsembleNames=Connections.EnsembleNames;
+    VariableNames=Connections.VariableNames;
+    Ens=BatchList(SSVizOpts.BatchMembers,EnsembleNames,1:length(EnsembleNames));
+    Vars=BatchList(SSVizOpts.BatchVariables,VariableNames,find(strcmp(Connections.VariableTypes,'Scalar')));
+    cmap=feval(SSVizOpts.ColorMap,SSVizOpts.NumberOfColors);
+    
+    % pixel weights of each grid in use
+    GridIds=[];
+    for j=Vars
+        for i=Ens
+            Member=Connections.members{i,j};
+            if ~isempty(Member) && isfield(Member,'GridId')
+                GridIds(end+1)=Member.GridId; %#ok<AGROW>
+            end
+        end
+    end
+    Rasters=cell(1,length(TheGrids));
+    for g=unique(GridIds)
+        SetUIStatusMessage(sprintf('* Locating the product pixels in grid %d ...\n',g))
+        Rasters{g}=RasterWeights(TheGrids{g},SSVizOpts.BoundingBox,SSVizOpts.BatchImageWidth);
+    end
+    
+    B=BatchProducts('start',Rasters,SSVizOpts.BatchWorkers,@SetUIStatusMessage);
+    
+    % file variables go to the workers, which read them; the rest are
+    % read or computed here once these are queued
+    Client=zeros(0,2);
+    CLims=cell(1,length(VariableNames));
+    for j=Vars
+        for i=Ens
+            Member=Connections.members{i,j};
+            if isempty(Member) || ~isfield(Member,'GridId') || isempty(Member.NcTBHandle)
+                continue
+            end
+            Derived=isfield(Member,'Derived');
+            if Derived && Member.Derived.Ensemble && any(Client(:,2)==j)
+                continue       % the same for every member; done once
+            end
+            if isempty(CLims{j})
+                [Connections,CLims{j}]=BatchColorLimits(Connections,i,j);
+            end
+            if Derived || ~isfield(Member,'Url') || isempty(Member.Url)
+                Client(end+1,:)=[i j]; %#ok<AGROW>
+                continue
+            end
+            perm=[];
+            if isfield(TheGrids{Member.GridId},'perm')
+                perm=TheGrids{Member.GridId}.perm;
+            end
+            Name=[OutDir '/' BatchName(EnsembleNames{i}) '_' BatchName(VariableNames{j})];
+            Task=BatchTask(Member,EnsembleNames{i},VariableNames{j},CLims{j},cmap);
+            Task.Url=Member.Url;
+            Task.Var=Member.FileNetcdfVariableName;
+            Task.Fac=Connections.VariableUnitsFac{j};
+            Task.Perm=perm;
+            Task.DateFormat=DateStringFormatInput;
+            if Member.NTimes>1
+                Slabs=BatchSlabs(BatchLevels(Member.NTimes),Member.NNodes);
+                for s=1:length(Slabs)
+                    Task.Levels=Slabs{s};
+                    Task.Files=cell(length(Task.Levels),1);
+                    for k=1:length(Task.Levels)
+                        Task.Files{k}=sprintf('%s_%03d',Name,Task.Levels(k));
+                    end
+                    B=BatchProducts('submit',B,Task);
+                end
+            else
+                Task.Files={Name};
+                B=BatchProducts('submit',B,Task);
+            end
+        end
+    end
+    
+    for k=1:size(Client,1)
+        i=Client(k,1);
+        j=Client(k,2);
+        Member=Connections.members{i,j};
+        MemberName=EnsembleNames{i};
+        if isfield(Member,'Derived') && Member.Derived.Ensemble
+            MemberName='ensemble';
+        end
+        Name=[OutDir '/' BatchName(MemberName) '_' BatchName(VariableNames{j})];
+        Task=BatchTask(Member,MemberName,VariableNames{j},CLims{j},cmap);
+        Levels=1;
+        Times=[];
+        if Member.NTimes>1
+            Levels=BatchLevels(Member.NTimes);
+            try
+                Connections=OpenMemberHandles(Connections,i);
+                Times=MemberTimes(Connections.members{i,j}.NcTBHandle,DateStringFormatInput);
+            catch
+                % the images are still good without their times
+            end
+        end
+        for t=Levels
+            % level 1 first; GetDataObject's first read goes to TheData{1}
+            if ~IsSliceLoaded(Connections,i,j,1)
+                Connections=GetDataObject(Connections,i,j,1,true);
+            end
+            if ~IsSliceLoaded(Connections,i,j,t)
+                Connections=GetDataObject(Connections,i,j,t,true);
+            end
+            Task.Data=Connections.members{i,j}.TheData{t};
+            if ~isreal(Task.Data),Task.Data=abs(Task.Data);end
+            if length(Times)>=t,Task.Times=Times(t);end
+            if Member.NTimes>1
+                Task.Files={sprintf('%s_%03d',Name,t)};
+            else
+                Task.Files={Name};
+            end
+            B=BatchProducts('submit',B,Task);
+        end
+    end
+    
+    Log=BatchProducts('finish',B);
+    
+    fid=fopen([OutDir '/products.txt'],'w');
+    fprintf(fid,'# file\tmember\tvariable\ttime (UTC)\tcmin\tcmax\tunits\n');
+    nfiles=0;
+    nfailed=0;
+    for k=1:length(Log)
+        if ~isempty(Log(k).Message),nfailed=nfailed+1;end
+        for m=1:length(Log(k).Files)
+            t='';
+            if length(Log(k).Times)>=m
+                t=datestr(Log(k).Times(m),'yyyy-mm-dd HH:MM:SS');
+            end
+            [~,f,x]=fileparts(Log(k).Files{m});
+            fprintf(fid,'%s%s\t%s\t%s\t%s\t%g\t%g\t%s\n',f,x,Log(k).Member,...
+                Log(k).Variable,t,Log(k).CLim(1),Log(k).CLim(2),Log(k).Units);
+            nfiles=nfiles+1;
+        end
+    end
+    fclose(fid);
+    setappdata(Handles.MainFigure,'Connections',Connections);
+    SetUIStatusMessage(sprintf('Wrote %d images to %s; %d task(s) failed.\n',nfiles,OutDir,nfailed))
+    
+end
+
+%%  BatchColorLimits
+function [Connections,CLim]=BatchColorLimits(Connections,EnsIndex,VarIndex)
+
+    % the color limits the GUI starts with for this field: its range
+    % at level 1, within ColorMin/ColorMax, out to ColorIncrement
+    global SSVizOpts
+    if ~IsSliceLoaded(Connections,EnsIndex,VarIndex,1)
+        Connections=GetDataObject(Connections,EnsIndex,VarIndex,1,true);
+    end
+    q=Connections.members{EnsIndex,VarIndex}.TheData{1};
+    if ~isreal(q),q=abs(q);end
+    Max=min([max(q) SSVizOpts.ColorMax]);
+    Min=max([min(q) SSVizOpts.ColorMin]);
+    CLim=[floor(Min/SSVizOpts.ColorIncrement) ceil(Max/SSVizOpts.ColorIncrement)]*SSVizOpts.ColorIncrement;
+
+end
+
+%%  BatchTask
+function Task=BatchTask(Member,MemberName,VariableName,CLim,cmap)
+
+    % a BatchProducts task with nothing to read or render yet
+    Task=struct('Url','','Var','','Levels',[],'Fac',1,'Perm',[],...
+                'Data',[],'Times',[],'DateFormat','','GridId',Member.GridId,...
+                'CLim',CLim,'CMap',cmap,'Files',{{}},...
+                'Member',MemberName,'Variable',VariableName,'Units',Member.Units);
+
+end
+
+%%  BatchList
+function idx=BatchList(List,Names,Default)
+
+    % indices into Names of the comma-separated names in List, or
+    % Default if List is empty
+    if isempty(List)
+        idx=Default(:)';
+        return
+    end
+    List=textscan(List,'%s','Delimiter',',');
+    List=strtrim(List{1});
+    idx=[];
+    for k=1:length(List)
+        i=find(strcmp(Names,List{k}),1);
+        if isempty(i)
+            SetUIStatusMessage(sprintf('* %s is not in this run; skipped.\n',List{k}))
+        else
+            idx(end+1)=i; %#ok<AGROW>
+        end
+    end
+
+end
+
+%%  BatchLevels
+function L=BatchLevels(NTimes)
+
+    % the time levels to render of a variable with NTimes levels
+    global SSVizOpts
+    L=SSVizOpts.BatchTimeLevels;
+    if isempty(L)
+        L=1:NTimes;
+    end
+    L=L(L>=1 & L<=NTimes & L==round(L));
+    L=unique(L(:)');
+
+end
+
+%%  BatchSlabs
+function Slabs=BatchSlabs(L,NNodes)
+
+    % splits the levels L into tasks of at most 8 levels, each read in
+    % one contiguous read of at most 64MB of doubles, as TimeMaxOfMember
+    % reads them
+    Span=max(1,floor(64*2^20/(8*NNodes)));
+    Slabs={};
+    k=1;
+    while k<=length(L)
+        m=k;
+        while m<length(L) && m-k<7 && L(m+1)-L(k)<Span
+            m=m+1;
+        end
+        Slabs{end+1}=L(k:m); %#ok<AGROW>
+        k=m+1;
+    end
+
+end
+
+%%  BatchName
+function s=BatchName(s)
+
+    % a member or variable name as part of a file name
+    s=regexprep(s,'[^A-Za-z0-9.-]+','_');
+    s=regexprep(s,'^_+|_+$','');
+
+end
+
 %%  SetTransparency
 %%% SetTransparency
 %%% SetTransparency
@@ -4341,6 +5203,9 @@ function ResetAxes(~,~)
     axis(axx)
     set(Handles.AxisLimits,'String',sprintf('%.2f  ',axx));
     setappdata(Handles.MainFigure,'BoundingBox',axx);
+    RefreshTriSurf(Handles);
+    Handles=RefreshVectors(Handles);
+    set(Handles.MainFigure,'UserData',Handles);
 
 end
 
@@ -4449,9 +5314,11 @@ function ShowMinimum(hObj,~)
     temp=findobj(Handles.MainAxes,'Tag','MinMarker');
     axes(Handles.MainAxes);
     if isempty(temp)
-        idx=GetNodesInView(TheGrid);
-        [Min,idx2]=min(Field(idx));
-        idx=idx(idx2);
+        [Min,~,idx]=GetMinMaxInView(TheGrid,Field,getappdata(Handles.TriSurf,'TileExtrema'));
+        if isempty(idx)
+            SetUIStatusMessage('No finite values in view; no minimum shown.')
+            return
+        end
         line(TheGrid.x(idx),TheGrid.y(idx),1,'Marker','o','Color',[1 0 0],...
             'MarkerSize',20,'Tag','MinMarker','LineWidth',3,'Clipping','on');
         line(TheGrid.x(idx),TheGrid.y(idx),1,'Marker','x','Color',[0 1 1],...
@@ -4502,9 +5369,11 @@ function ShowMaximum(hObj,~)
     temp=findobj(Handles.MainAxes,'Tag','MaxMarker');
     if isempty(temp)
         axes(Handles.MainAxes);
-        idx=GetNodesInView(TheGrid);
-        [Max,idx2]=max(Field(idx));
-        idx=idx(idx2);
+        [~,Max,~,idx]=GetMinMaxInView(TheGrid,Field,getappdata(Handles.TriSurf,'TileExtrema'));
+        if isempty(idx)
+            SetUIStatusMessage('No finite values in view; no maximum shown.')
+            return
+        end
         line(TheGrid.x(idx),TheGrid.y(idx),1,'Marker','o','Color',[0 0 1],...
             'MarkerSize',20,'Tag','MaxMarker','LineWidth',3,'Clipping','on');
         line(TheGrid.x(idx),TheGrid.y(idx),1,'Marker','x','Color',[1 1 0],...
@@ -4739,6 +5608,13 @@ function FindHydrograph(hObj,~)
                 return
             end
             % NodeNumber should be valid at this point....
+            % It is the model's node number; GridNode is its number in 
+            % the (possibly reordered) grid.
+            if isfield(TheGrid,'perm')
+                GridNode=find(TheGrid.perm==NodeNumber);
+            else
+                GridNode=NodeNumber;
+            end
             
         elseif strcmp(get(hObj,'Tag'),'TriSurf')
             
@@ -4756,7 +5632,12 @@ function FindHydrograph(hObj,~)
                     diffx=TheGrid.x(TheGrid.e(j,:))-x;
                     diffy=TheGrid.y(TheGrid.e(j,:))-y;
                     [~,imin]=min(diffx.^2+diffy.^2);
-                    NodeNumber=TheGrid.e(j,imin);
+                    GridNode=TheGrid.e(j,imin);
+                    if isfield(TheGrid,'perm')
+                        NodeNumber=TheGrid.perm(GridNode);
+                    else
+                        NodeNumber=GridNode;
+                    end
                     
                 else
                     SetUIStatusMessage('Location is out of model domain.')
@@ -4773,8 +5654,8 @@ function FindHydrograph(hObj,~)
             return
         end
 
-        xx=TheGrid.x(NodeNumber);
-        yy=TheGrid.y(NodeNumber);
+        xx=TheGrid.x(GridNode);
+        yy=TheGrid.y(GridNode);
         
         tic;
         
@@ -4863,7 +5744,12 @@ end
 %%% LoadNodeTimeSeries
 function Data=LoadNodeTimeSeries(VarIndex,NodeNumber) 
 
-    global Connections
+    global Connections SSVizOpts
+    
+    if SSVizOpts.NodeMajorStore
+        f=findobj(0,'Tag','MainVizAppFigure');
+        TempDataLocation=getappdata(f,'TempDataLocation');
+    end
 
     SetUIStatusMessage('Getting nodal timeseries ...')
 
@@ -4872,6 +5758,7 @@ function Data=LoadNodeTimeSeries(VarIndex,NodeNumber)
     mint=NaN;
     maxt=NaN;
     
+    Connections=OpenMemberHandles(Connections,1:length(Connections.EnsembleNames));
     for i=1:length(Connections.EnsembleNames)
 
         SetUIStatusMessage(sprintf('Getting nodal timeseries at node %d for ens=%s ...',NodeNumber,Connections.EnsembleNames{i}))
@@ -4882,8 +5769,22 @@ function Data=LoadNodeTimeSeries(VarIndex,NodeNumber)
                 
         fac=Connections.VariableUnitsFac{VarIndex};
         
-        qn=h.geovariable(varnameinfile);
-        q{i}=fac*qn.data(:,NodeNumber);
+        % one contiguous read from the local node-major copy if it has
+        % been built (see StartNodeMajorStore), else a strided read
+        % across every time level of the model output
+        q{i}=[];
+        if SSVizOpts.NodeMajorStore
+            try
+                q{i}=fac*NodeMajorStore('read',NodeMajorStore('file',TempDataLocation,h,varnameinfile),...
+                                        NodeNumber,NodeMajorStamp(i,VarIndex));
+            catch
+                q{i}=[];
+            end
+        end
+        if isempty(q{i})
+            qn=h.geovariable(varnameinfile);
+            q{i}=fac*qn.data(:,NodeNumber);
+        end
 
         time=h.geovariable('time');
         basedate=time.attribute('base_date');
@@ -4964,16 +5865,39 @@ function RecordAxisLimits(~,arg2)
     axx=axis;
     setappdata(Handles.MainFigure,'BoundingBox',axx);
     set(Handles.AxisLimits,'String',sprintf('%.2f  ',axx))
+    RefreshTriSurf(Handles);
+    Handles=RefreshVectors(Handles);
+    set(Handles.MainFigure,'UserData',Handles);
     RendererKludge;
 
 end
 
+%%  RefreshTriSurf
+function RefreshTriSurf(Handles)
+
+    % redraw the surface's elements for the current view (see DrawTriSurf)
+    global TheGrids
+
+    if ~isfield(Handles,'TriSurf') || ~ishandle(Handles.TriSurf)
+        return
+    end
+    GridId=getappdata(Handles.TriSurf,'GridId');
+    if isempty(GridId)
+        return
+    end
+    SSVizOpts=getappdata(Handles.MainFigure,'SSVizOpts');
+    if SSVizOpts.MeshLODElements<=0
+        return
+    end
+    e=SelectMeshLOD(TheGrids{GridId},axis(Handles.MainAxes),SSVizOpts.MeshLODElements);
+    set(Handles.TriSurf,'Faces',e);
+
+end
+
 %%  GetNodesInView
 function idx=GetNodesInView(TheGrid)
 
-    axx=axis;
-    idx=find(TheGrid.x<axx(2) & TheGrid.x>axx(1) & ...
-        TheGrid.y<axx(4) & TheGrid.y>axx(3));
+    idx=NodesInBox(TheGrid,axis);
 
 end
 
@@ -4987,11 +5911,12 @@ function idx=IsInView(x,y)
 end
 
 %%  GetMinMaxInView
-function [Min,Max]=GetMinMaxInView(TheGrid,TheField)
+function [Min,Max,iMin,iMax]=GetMinMaxInView(TheGrid,TheField,Summary)
 
-    idx=GetNodesInView(TheGrid);
-    Min=min(TheField(idx));
-    Max=max(TheField(idx));
+    % Summary is the per-tile summary of TheField kept with the drawn
+    % surface (see DrawTriSurf), if TheField is what is drawn
+    if ~exist('Summary','var'),Summary=[];end
+    [Min,Max,iMin,iMax]=ExtremaInBox(TheGrid,TheField,axis,Summary);
 
 end
 
@@ -5057,6 +5982,9 @@ end
 %%  SetColors
 function SetColors(Handles,minThisData,maxThisData,NumberOfColors,ColorIncrement)
 
+     % nothing finite in view; leave the color limits as they are
+     if isempty(minThisData) || isempty(maxThisData),return,end
+
      FieldMax=ceil(maxThisData/ColorIncrement)*ColorIncrement;
      FieldMin=floor(minThisData/ColorIncrement)*ColorIncrement;
 
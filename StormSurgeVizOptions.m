@@ -33,6 +33,14 @@ p.Debug=true;
 p.DisableContouring=false;
 p.LocalTimeOffset=0;
 p.UseStrTree=false;
+p.ReorderGrid=true;      % renumber grid nodes/elements along a Hilbert curve
+p.MeshLODElements=250000;  % most elements drawn per view; 0 for the full grid
+p.SliceCacheMB=2048;      % memory budget for time levels kept in memory
+p.PrefetchSlices=3;       % time levels read ahead while stepping; 0 for none
+p.NodeMajorStore=false;   % local node-major copies of time-dependent variables, for hydrographs
+p.ConnectionPoolSize=8;   % parallel workers connecting to ensemble members; 0 to connect in turn
+p.DerivedFields='mean spread p90 exceed inundation timemax';  % derived fields added to the variable list; '' for none
+p.ExceedanceLevel=1;      % water level, in the run's units, for the 'exceed' derived field
 p.UseGoogleMaps=true;
 p.UseShapeFiles=true;
 p.KeepScalarsAndVectorsInSync=true;
@@ -62,3 +70,12 @@ p.ForkAxes=false;
 p.UITest=false;
 
 p.BoundingBox=[];  %  [-100 -60 7 47];
+
+% batch product options (see BatchProducts)
+p.Batch=false;           % render the products to files, with no GUI
+p.BatchOutputDir='';     % default is TempDataLocation/products/<storm>_<advisory>
+p.BatchVariables='';     % comma-separated; '' for every scalar variable
+p.BatchMembers='';       % comma-separated; '' for every member
+p.BatchTimeLevels=[];    % [] for every time level
+p.BatchImageWidth=1600;  % pixels
+p.BatchWorkers=4;        % parallel pool size; 0 to render in turn
@@ -115,7 +115,9 @@ SSVizOpts.HOME = HOME;
 
 if SSVizOpts.UseStrTree
     f=[SSVizOpts.HOME '/extern/' jts];
-    if exist(f,'file')
+    if exist('strtreemex5','file')==3
+        % native strtree; the jts jar is not needed
+    elseif exist(f,'file')
         javaaddpath(f);
     else
         disp('Can''t add jts file to javaclasspath.   Disabling strtree searching.')
@@ -133,8 +135,10 @@ if isempty(which('shaperead'))
     SSVizOpts.UseShapeFiles=false;
 end
 
-if isempty(which('shapewrite'))
-    disp('Can''t locate MATLAB''s shapewrite.  Disabling shape file output.')
+% shape files are written by private/WriteShapeFile, without
+% shapewrite or the Mapping Toolbox
+if ~exist('WriteShapeFile','file')
+    disp('Can''t locate WriteShapeFile.  Disabling shape file output.')
     SSVizOpts.CanOutputShapeFiles=false;
 end
 
@@ -0,0 +1,42 @@
+function T=ConnectMembersTest(UrlBase,Ens,Files,VarNames,PoolSizes)
+% Call as:  T=ConnectMembersTest(UrlBase,Ens,Files,VarNames,PoolSizes)
+%
+% Times ConnectMembers on the member directories Ens (cell) under
+% UrlBase, each with the netCDF files Files (cell) of variables
+% VarNames (cell, as in ConnectMembers), once per pool size
+% in PoolSizes (0 connects in turn), and checks that every pool size
+% gathers the same metadata.  UrlBase can be a THREDDS dodsC url, or,
+% as a stand-in for one, a local http server of ensemble directories
+% that honours byte ranges (netCDF-Java reads plain http netCDF files
+% that way), e.g.
+%
+%   T=ConnectMembersTest('http://localhost:8000',...
+%         arrayfun(@(i)sprintf('ens%d',i),1:20,'UniformOutput',false),...
+%         {'maxele.63.nc','fort.63.nc'},{'zeta_max','zeta'},[0 4 8]);
+%
+% Run from the StormSurgeViz directory after StormSurgeViz_Init.
+
+if ~exist('PoolSizes','var'),PoolSizes=[0 8];end
+
+Urls=cell(length(Ens),length(Files));
+for i=1:length(Ens)
+    for j=1:length(Files)
+        Urls{i,j}=sprintf('%s/%s/%s',UrlBase,Ens{i},Files{j});
+    end
+end
+
+T=zeros(size(PoolSizes));
+Ref=[];
+for k=1:length(PoolSizes)
+    tic
+    Meta=ConnectMembers(Urls,VarNames,PoolSizes(k),@(m)[]);
+    T(k)=toc;
+    fprintf('PoolSize=%2d: %d members x %d files in %.1f secs, %d failed\n',...
+        PoolSizes(k),size(Urls,1),size(Urls,2),T(k),sum(~[Meta.Ok]));
+    Meta=rmfield(Meta,{'Handle','Message'});
+    if isempty(Ref)
+        Ref=Meta;
+    elseif ~isequaln(Ref,Meta)
+        fprintf('   metadata differs from PoolSize=%d\n',PoolSizes(1));
+    end
+end
@@ -0,0 +1,110 @@
+function Connections=DefineDerivedFields(Connections,Fields,ExceedanceLevel)
+% Call as:  Connections=DefineDerivedFields(Connections,Fields,ExceedanceLevel)
+%
+% Adds the derived fields named in Fields (SSVizOpts.DerivedFields, a
+% blank-separated list) to the variable list of the open run, as
+% scalar variables after the file variables.  Nothing is computed
+% here; GetDataObject evaluates a derived field when it is first shown
+% and keeps it like a file variable.  The fields are:
+%
+%    mean, min, max  - ensemble mean, minimum, maximum of Max Water Level
+%    spread          - ensemble standard deviation of Max Water Level
+%    pNN             - ensemble NN'th percentile of Max Water Level
+%    exceed          - fraction of members whose Max Water Level is
+%                      above ExceedanceLevel (in the run's units)
+%    inundation      - each member's Max Water Level as depth of water
+%                      over land (see ComputeInundation)
+%    timemax         - each member's maximum Water Level over time,
+%                      from the time levels of its Water Level file
+%
+% Ensemble fields are only added for runs of more than one member, and
+% a field whose source variable is not in the run is not added.  Each
+% derived member is a copy of its source member with a .Derived
+% struct:
+%    .Op       - 'ensemble', 'inundation' or 'timemax'
+%    .Code     - the ensemble statistic, as in EnsembleStats
+%    .Param    - its parameter
+%    .Source   - VarIndex of the source variable
+%    .Ensemble - true if the field is the same for every member
+
+if isempty(Fields),return,end
+Fields=textscan(lower(Fields),'%s');
+Fields=Fields{1};
+
+NEns=length(Connections.EnsembleNames);
+NVars=length(Connections.VariableNames);
+iMax=find(strcmp(Connections.VariableNames,'Max Water Level'),1);
+iWL=find(strcmp(Connections.VariableNames,'Water Level'),1);
+
+for k=1:length(Fields)
+    d=struct('Op','ensemble','Code',0,'Param',0,'Source',iMax,'Ensemble',true);
+    Units='';
+    f=Fields{k};
+    switch f
+        case 'mean'
+            d.Code=1;
+            Name='Ens Mean Max WL';
+        case 'min'
+            d.Code=2;
+            Name='Ens Min Max WL';
+        case 'max'
+            d.Code=3;
+            Name='Ens Max Max WL';
+        case 'spread'
+            d.Code=4;
+            Name='Ens Spread Max WL';
+        case 'exceed'
+            d.Code=6;
+            d.Param=ExceedanceLevel;
+            Name=sprintf('Prob Max WL > %g',ExceedanceLevel);
+            Units='Probability';
+        case 'inundation'
+            d.Op='inundation';
+            d.Ensemble=false;
+            Name='Max Inundation Depth';
+        case 'timemax'
+            d.Op='timemax';
+            d.Source=iWL;
+            d.Ensemble=false;
+            Name='Time Max WL';
+        otherwise
+            p=sscanf(f,'p%f');
+            if length(p)~=1 || p<0 || p>100
+                fprintf('SSViz++ Unknown derived field "%s" ignored.\n',f)
+                continue
+            end
+            d.Code=5;
+            d.Param=p;
+            Name=sprintf('Ens P%g Max WL',p);
+    end
+    if isempty(d.Source) || (d.Ensemble && NEns<2)
+        continue
+    end
+
+    j=NVars+1;
+    Connections.VariableNames{j}=Name;
+    Connections.VariableDisplayNames{j}=Name;
+    Connections.VariableTypes{1,j}='Scalar';
+    Connections.VariableUnitsFac{j}=1;     % the source data are scaled
+    for i=1:NEns
+        if d.Ensemble
+            Member=Connections.members{1,d.Source};
+        else
+            Member=Connections.members{i,d.Source};
+        end
+        if isempty(Member),continue,end
+        if isfield(Member,'TheData')
+            Member=rmfield(Member,'TheData');
+        end
+        Member.VariableDisplayName=Name;
+        if ~isempty(Units)
+            Member.Units=Units;
+        end
+        if strcmp(d.Op,'timemax')
+            Member.NTimes=1;
+        end
+        Member.Derived=d;
+        Connections.members{i,j}=Member;
+    end
+    NVars=j;
+end
@@ -19,48 +19,85 @@ function TheGrid=GetGridStructure(Member,id)
     TempDataLocation=getappdata(fig,'TempDataLocation');
     SSVizOpts=getappdata(fig,'SSVizOpts');
     
-    if ~exist([TempDataLocation '/' Member.GridHash '_FGS.mat'],'file')
-       TheGrid.name=['GridID.eq.' int2str(id)];
-       try 
-           v=Member.NcTBHandle.variables;
-           if any(strcmp(v,'element'))
-               TheGrid.e=double(Member.NcTBHandle.data('element'));
-               TheGrid.x=Member.NcTBHandle.data('x');
-               TheGrid.y=Member.NcTBHandle.data('y');
-               TheGrid.bnd=detbndy(TheGrid.e);
-           else
-               error('element variable not in netCDF')
-           end
-          
-           if any(strcmp(v,'depth'))
-               TheGrid.z=Member.NcTBHandle.data('depth');
-           end
-           
-       catch ME
-           
-           % see if the grid file exist locally in private; this is a
-           % fallback when the grid components are not in the solution
-           % netCDF files.
-%            if exist([HOME '/private/' Instance '_' GridName '.grd'],'file')
-%                TheGrid=grd_to_opnml('private/ncfs_nc6b.grd');
-%            else
-%                disp(['Cant find element list in ' v ' object.  This is Terminal.'])
-%                throw(ME);   
-%            end
-           
+    CacheFile=[TempDataLocation '/' Member.GridHash '_FGS.bin'];
+    MatFile=[TempDataLocation '/' Member.GridHash '_FGS.mat'];
+    
+    TheGrid=[];
+    resave=false;
+    if exist(CacheFile,'file')
+        SetUIStatusMessage('** Loading cached copy of grid structure ...\n')
+        TheGrid=ReadGridCache(CacheFile);
+    elseif exist(MatFile,'file')
+        % cached by an earlier version; rewritten as a binary cache below
+        SetUIStatusMessage('** Loading cached copy of grid structure ...\n')
+        load(MatFile);
+        resave=true;
+    end
+    if ~isempty(TheGrid) && ~CacheIsOfGrid(TheGrid,Member)
+        SetUIStatusMessage('** Cached grid structure is not of this grid; rebuilding it ...\n')
+        TheGrid=[];
+    end
+
+    if isempty(TheGrid)
+       TheGrid=ReadGridArrays(Member,id);
+       if isfield(TheGrid,'e')
+           TheGrid.bnd=detbndy(TheGrid.e);
+       end
+       % renumber nodes and elements for locality; data read from the
+       % model output is put in this order by GetDataObject
+       if SSVizOpts.ReorderGrid
+           TheGrid=ReorderGrid(TheGrid);
        end
        % add element areas and basis function arrays
        TheGrid=el_areas(TheGrid);
        TheGrid=belint(TheGrid);
+       TheGrid.elindex=ComputeElementIndex(TheGrid);
+       TheGrid.ee=ComputeElementNeighbors(TheGrid);
+       TheGrid.lod=ComputeMeshLOD(TheGrid);
+       TheGrid.nodeindex=ComputeNodeIndex(TheGrid);
        if SSVizOpts.UseStrTree
            if Debug,fprintf('SSViz++ Computing Strtree for grid %s\n',Member.GridHash);end
            TheGrid.strtree=ComputeStrTree(TheGrid);
        end
-       save([TempDataLocation '/' Member.GridHash '_FGS.mat'],'TheGrid') 
+       resave=true;
         
     else
-        SetUIStatusMessage('** Loading cached copy of grid structure ...\n')
-        load([TempDataLocation '/' Member.GridHash '_FGS.mat']);
+        if SSVizOpts.ReorderGrid && ~isfield(TheGrid,'perm')
+            % cached before grid reordering was available
+            TheGrid=ReorderGrid(TheGrid);
+            resave=resave || isfield(TheGrid,'perm');
+        end
+        if ~isfield(TheGrid,'elindex') || ...
+                (isstruct(TheGrid.elindex) && ~isfield(TheGrid.elindex,'unbinned'))
+            % cached before element indexing was available, or with an 
+            % index from an older findelemex5
+            TheGrid.elindex=ComputeElementIndex(TheGrid);
+            resave=resave || ~isempty(TheGrid.elindex);
+        end
+        if ~isfield(TheGrid,'ee')
+            % cached before the element neighbors were kept
+            TheGrid.ee=ComputeElementNeighbors(TheGrid);
+            resave=resave || ~isempty(TheGrid.ee);
+        end
+        if ~isfield(TheGrid,'lod')
+            % cached before the drawing hierarchy was available
+            TheGrid.lod=ComputeMeshLOD(TheGrid);
+            resave=true;
+        end
+        if ~isfield(TheGrid,'nodeindex')
+            TheGrid.nodeindex=ComputeNodeIndex(TheGrid);
+            resave=true;
+        end
+        if SSVizOpts.UseStrTree && ~(isfield(TheGrid,'strtree') && isstruct(TheGrid.strtree))
+            % a Java STRtree (strtreemex5 not built) is never cached, 
+            % so it is rebuilt each session without rewriting the cache
+            if Debug,fprintf('SSViz++ Computing Strtree for grid %s\n',Member.GridHash);end
+            TheGrid.strtree=ComputeStrTree(TheGrid);
+            resave=resave || isstruct(TheGrid.strtree);
+        end
+    end
+    if resave
+        WriteGridCache(CacheFile,TheGrid);
     end
 
 %    set(Handles.MainFigure,'Pointer',CurrentPointer);
@@ -68,3 +105,59 @@ function TheGrid=GetGridStructure(Member,id)
 
 end
 
+%%  CacheIsOfGrid
+function ok=CacheIsOfGrid(TheGrid,Member)
+
+   % a cached grid is used only if it was built under the member's
+   % GridHash (see GridFingerprint), and has as many elements, nodes
+   % and depths as the file; both are had without reading the grid
+   ok=isfield(TheGrid,'hash') && strcmp(TheGrid.hash,Member.GridHash);
+   if ~ok,return,end
+   try
+       nc=Member.NcTBHandle;
+       ok=size(TheGrid.e,1)==size(nc.variable{'element'},1) && ...
+          length(TheGrid.x)==max(size(nc.variable{'x'})) && ...
+          isfield(TheGrid,'z')==any(strcmp(nc.variables,'depth'));
+   catch
+       % sizes not available from this connection; the hash decides
+   end
+
+end
+
+%%  ReadGridArrays
+function TheGrid=ReadGridArrays(Member,id)
+
+   % e,x,y,z as read from the member's file, and .hash, the member's
+   % GridHash, that CacheIsOfGrid checks a cached copy against
+   TheGrid.name=['GridID.eq.' int2str(id)];
+   try 
+       v=Member.NcTBHandle.variables;
+       if any(strcmp(v,'element'))
+           TheGrid.e=double(Member.NcTBHandle.data('element'));
+           TheGrid.x=Member.NcTBHandle.data('x');
+           TheGrid.y=Member.NcTBHandle.data('y');
+       else
+           error('element variable not in netCDF')
+       end
+      
+       if any(strcmp(v,'depth'))
+           TheGrid.z=Member.NcTBHandle.data('depth');
+       end
+       
+   catch ME
+       
+       % see if the grid file exist locally in private; this is a
+       % fallback when the grid components are not in the solution
+       % netCDF files.
+%        if exist([HOME '/private/' Instance '_' GridName '.grd'],'file')
+%            TheGrid=grd_to_opnml('private/ncfs_nc6b.grd');
+%        else
+%            disp(['Cant find element list in ' v ' object.  This is Terminal.'])
+%            throw(ME);   
+%        end
+       
+   end
+   TheGrid.hash=Member.GridHash;
+
+end
+
@@ -0,0 +1,55 @@
+function GridHash=GridFingerprint(varargin)
+% Call as:  GridHash=GridFingerprint(nc)
+%      or:  GridHash=GridFingerprint(e,x,y[,z])
+%
+% Content-based identity of an ADCIRC grid, used to name the grid cache
+% (see GetGridStructure) so that a cache is reused for the same mesh
+% across storms, advisories and users, and never for a different one.
+%
+% With an ncgeodataset connection nc, the key is a hash of the element
+% and node counts and of NSamples evenly strided rows of element, x, y
+% and depth (if in the file), including the first and last rows.  The
+% depth is part of the key since it is cached with the grid; a mesh
+% with new bathymetry is a new grid.  Reading the whole mesh over
+% OPeNDAP just to name it would cost as much as building it; meshes of
+% the same size differing in any sampled row hash differently.
+% GetGridStructure stores the key with the cached grid as .hash, and
+% uses a cached grid only if its .hash and its element, node and depth
+% counts match the file's.  With the grid arrays e,x,y[,z], the hash
+% is over their full contents.
+%
+% The hash is the 16-hex-digit XXH64 from gridhashmex5, or, if that
+% has not been compiled, the first 16 hex digits of DataHash's MD5.
+
+NSamples=4096;
+
+if nargin==1
+    nc=varargin{1};
+    se=double(size(nc.variable{'element'}));
+    sx=double(size(nc.variable{'x'}));
+    ne=se(1);
+    nn=max(sx);
+    ie=1:max(1,floor(ne/NSamples)):ne;
+    in=1:max(1,floor(nn/NSamples)):nn;
+    args={[se sx],...
+          double(nc{'element'}(ie,:)),double(nc{'element'}(ne,:)),...
+          double(nc{'x'}(in)),double(nc{'x'}(nn)),...
+          double(nc{'y'}(in)),double(nc{'y'}(nn))};
+    if any(strcmp(nc.variables,'depth'))
+        args=[args {double(nc{'depth'}(in)),double(nc{'depth'}(nn))}];
+    end
+    % sampled arrays are hashed as columns, whatever orientation the
+    % netCDF interface returns them in
+    for i=2:length(args)
+        args{i}=args{i}(:);
+    end
+else
+    args=cellfun(@double,varargin,'UniformOutput',false);
+end
+
+if exist('gridhashmex5','file')==3
+    GridHash=gridhashmex5(args{:});
+else
+    GridHash=DataHash(args);
+    GridHash=GridHash(1:16);
+end
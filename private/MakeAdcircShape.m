@@ -72,6 +72,17 @@ else
     q(q<min(edges))=min(edges);
 end
 
+% With bandmex5, all elements are clipped against all bin edges in 
+% one pass and each bin's pieces are merged into its outline; the 
+% element splitting and boundary tracing below are the fallback.
+if exist('bandmex5','file')==3
+    SS=band_shapes(x,y,e,q,edges,bin_centers,FeatureName,PolygonLengthMinimum);
+    if nargout==3
+        spec=symbol_spec(FeatureName,bin_centers,edges);
+    end
+    return
+end
+
 % use a sparse matrix to keep track of which 
 % edges have been split by contour values; make it 
 % twice as big as the number of nodes in the grid.
@@ -494,21 +505,85 @@ end
 % create a symbol specification for plotting this shape file in MATLAB.  
 % this is specific to MATLAB
 if nargout==3
+    spec=symbol_spec(FeatureName,bin_centers,edges);
+end
+
+
+
+end % end of main function
+
+
+function spec=symbol_spec(FeatureName,bin_centers,edges)
+
     arg='makesymbolspec(''Polygon''';
     cmap=jet(length(bin_centers));
     % generate a spec file for mapview
-    for i=1:length(list)
+    for i=1:length(bin_centers)
         c=sprintf('[%f %f %f]',cmap(i,:));
         temp=sprintf('{\''%s\'',%.5f,\''%s\'',%s}',FeatureName,mean(edges(i:i+1)),'FaceColor',c);
         arg=sprintf('%s,%s',arg,temp);
     end
     spec=sprintf('%s)',arg);
     spec=eval(spec);
+
 end
 
 
+function SS=band_shapes(x,y,e,q,edges,bin_centers,FeatureName,PolygonLengthMinimum)
 
-end % end of main function
+    % one polygon per bin, whose parts are the bin's outer rings 
+    % (clockwise) and holes (counterclockwise); I(k,:)=[bin npts hole]
+    % for ring k of P, npts including the closing point
+    [P,I]=bandmex5(x,y,e,q,edges);
+    
+    last=cumsum(I(:,2)+1);
+    first=last-I(:,2);
+    keep=I(:,2)>=PolygonLengthMinimum;
+    
+    % a hole is kept only with the outer ring it lies in, the smallest
+    % of its band's outer rings containing it; the holes of a dropped
+    % ring would otherwise be written as parts with no outer ring
+    for ii=1:length(bin_centers)
+        h=find(I(:,1)==ii & I(:,3) & keep);
+        if isempty(h),continue,end
+        o=find(I(:,1)==ii & ~I(:,3));
+        box=zeros(length(o),4);
+        area=zeros(length(o),1);
+        for k=1:length(o)
+            r=first(o(k)):last(o(k));
+            box(k,:)=[min(P(r,1)) max(P(r,1)) min(P(r,2)) max(P(r,2))];
+            area(k)=polyarea(P(r,1),P(r,2));
+        end
+        for k=1:length(h)
+            px=P(first(h(k)),1);
+            py=P(first(h(k)),2);
+            c=find(px>=box(:,1) & px<=box(:,2) & py>=box(:,3) & py<=box(:,4));
+            in=false(size(c));
+            for m=1:length(c)
+                r=first(o(c(m))):last(o(c(m)));
+                in(m)=inpolygon(px,py,P(r,1),P(r,2));
+            end
+            c=c(in);
+            [~,m]=min(area(c));
+            keep(h(k))=~isempty(c) && keep(o(c(m)));
+        end
+    end
+    
+    SS=struct([]);
+    c=0;
+    for ii=1:length(bin_centers)
+        k=find(I(:,1)==ii & keep);
+        if isempty(k),continue,end
+        rows=cell2mat(arrayfun(@(i) first(i):last(i),k(:)','UniformOutput',false));
+        c=c+1;
+        SS(c).Geometry='Polygon';
+        SS(c).BoundingBox=[min(P(rows,1)) max(P(rows,1)); min(P(rows,2)) max(P(rows,2))];
+        SS(c).Lon=P(rows,1)';
+        SS(c).Lat=P(rows,2)';
+        SS(c).(FeatureName)=bin_centers(ii);
+    end
+
+end
 
 
 
@@ -0,0 +1,20 @@
+function t=MemberTimes(h,DateStringFormatInput)
+% Call as:  t=MemberTimes(h,DateStringFormatInput)
+%
+% Returns the datenums (UTC) of the time levels of the dataset h, an
+% ncgeodataset, from its time variable (seconds) and that variable's
+% base_date attribute, in DateStringFormatInput, or the date in its
+% units ('seconds since yyyy-mm-dd HH:MM:SS') if it has no base_date.
+% Used by the snapshot controls and by the batch products, which read
+% it on the worker that renders the member.
+
+time=h.geovariable('time');
+basedate=time.attribute('base_date');
+if isempty(basedate)
+    s=time.attribute('units');
+    p=strspl(s);
+    timebase_datenum=datenum([p{3} ' ' p{4}],DateStringFormatInput);
+else
+    timebase_datenum=datenum(basedate,DateStringFormatInput);
+end
+t=cast(time.data(:),'double')/86400+timebase_datenum;
@@ -0,0 +1,167 @@
+function varargout=NodeMajorStore(mode,varargin)
+% Call as:  fname=NodeMajorStore('file',TempDataLocation,h,VarName)
+%           stamp=NodeMajorStore('stamp',h,VarName)
+%           done=NodeMajorStore('append',fname,h,VarName,stamp)
+%           q=NodeMajorStore('read',fname,NodeNumber,stamp)
+%
+% Local node-major copy of a time-dependent nodal variable (e.g., zeta
+% in fort.63), so that the time series at a node is read from a few
+% contiguous runs of a local file instead of by a strided read across
+% every time level of the model output.
+%
+% 'file' gives the store's file name in TempDataLocation, keyed by the
+% location of the dataset h (or the location itself, for a member not
+% yet opened; see OpenMemberHandles) and the variable name.  Since a
+% location can be reused for different contents (a run redone, a local
+% file overwritten), 'stamp' identifies the contents themselves: a
+% hash of the sizes, the time vector, the first and last time levels
+% of VarName, and the file's date and size if h is a local file.  It
+% reads two time levels, so the caller computes it once per dataset
+% and session.  'append' reads the next slab of time levels from h,
+% with one contiguous time-slice read, and writes it to the store,
+% creating the store if needed; it returns true once every time level
+% is in the store.  A store whose sizes or stamp do not match h is
+% rebuilt.  'read' returns the ntimes x 1 series at NodeNumber (the
+% model's node number, single-precision values as in the model output,
+% before any units factor), or [] if the store is missing, incomplete
+% or not of the stamped contents.
+%
+% File layout (little-endian), version 2:
+%    char[8]   'SSVIZNMS'
+%    uint32    version
+%    uint32    B, the number of time levels per slab
+%    uint64    nnodes
+%    uint64    ntimes
+%    uint64    number of time levels written
+%    char[16]  stamp
+%    8 bytes   0
+%    slabs of B time levels (fewer in the last), each b x nnodes single,
+%    column-major, so each node's b values are contiguous; a series is
+%    ceil(ntimes/B) reads of b values
+%
+% Slabs are sized to SlabMB of single-precision values.
+
+Version=2;
+SlabMB=64;
+HeaderBytes=64;
+
+switch lower(mode)
+
+    case 'file'
+        [TempDataLocation,h,VarName]=varargin{:};
+        if ischar(h)
+            str=[h '|' VarName];
+        else
+            str=[h.location '|' VarName];
+        end
+        varargout{1}=sprintf('%s/nodemajor_%s.bin',TempDataLocation,Hash(str));
+
+    case 'stamp'
+        [h,VarName]=varargin{:};
+        sz=h.size(VarName);
+        nt=sz(1);
+        hv=h.geovariable(VarName);
+        time=h.geovariable('time');
+        parts={double(sz),double(time.data(:)),...
+               double(hv.data(1,:)),double(hv.data(nt,:))};
+        if exist(h.location,'file')==2
+            d=dir(h.location);
+            parts{end+1}=[d.datenum d.bytes];
+        end
+        varargout{1}=Hash(parts{:});
+
+    case 'append'
+        [fname,h,VarName,stamp]=varargin{:};
+        hv=h.geovariable(VarName);
+        sz=h.size(VarName);
+        nt=sz(1);
+        nn=sz(2);
+
+        [hdr,fid]=ReadHeader(fname,'r+',Version);
+        if isempty(hdr) || hdr.nn~=nn || hdr.nt~=nt || ~strcmp(hdr.stamp,stamp)
+            if fid>=0,fclose(fid);end
+            fid=fopen(fname,'w','ieee-le');
+            if fid<0
+                error('NodeMajorStore: could not open %s for writing',fname)
+            end
+            hdr.B=max(1,min(nt,floor(SlabMB*2^20/(4*nn))));
+            hdr.nn=nn;
+            hdr.nt=nt;
+            hdr.ndone=0;
+            fwrite(fid,'SSVIZNMS','char');
+            fwrite(fid,[Version hdr.B],'uint32');
+            fwrite(fid,[nn nt 0],'uint64');
+            fwrite(fid,stamp,'char');
+            fwrite(fid,zeros(1,24-length(stamp)),'uint8');
+        end
+
+        if hdr.ndone<nt
+            t1=hdr.ndone+1;
+            t2=min(nt,hdr.ndone+hdr.B);
+            d=hv.data(t1:t2,:);
+            fseek(fid,HeaderBytes+4*hdr.ndone*nn,'bof');
+            fwrite(fid,single(reshape(d,t2-t1+1,nn)),'single');
+            hdr.ndone=t2;
+            fseek(fid,32,'bof');
+            fwrite(fid,hdr.ndone,'uint64');
+        end
+        fclose(fid);
+        varargout{1}=hdr.ndone==nt;
+
+    case 'read'
+        [fname,NodeNumber,stamp]=varargin{:};
+        varargout{1}=[];
+        [hdr,fid]=ReadHeader(fname,'r',Version);
+        if isempty(hdr)
+            if fid>=0,fclose(fid);end
+            return
+        end
+        if ~strcmp(hdr.stamp,stamp) || hdr.ndone<hdr.nt || NodeNumber<1 || NodeNumber>hdr.nn
+            fclose(fid);
+            return
+        end
+        q=zeros(hdr.nt,1);
+        for t1=1:hdr.B:hdr.nt
+            b=min(hdr.B,hdr.nt-t1+1);
+            fseek(fid,HeaderBytes+4*((t1-1)*hdr.nn+(NodeNumber-1)*b),'bof');
+            q(t1:t1+b-1)=fread(fid,b,'single');
+        end
+        fclose(fid);
+        varargout{1}=q;
+
+    otherwise
+        error('NodeMajorStore: unknown mode %s',mode)
+end
+
+
+function [hdr,fid]=ReadHeader(fname,perm,Version)
+
+    % hdr is empty if fname is not a current store
+    hdr=[];
+    fid=fopen(fname,perm,'ieee-le');
+    if fid<0
+        return
+    end
+    magic=fread(fid,[1 8],'*char');
+    v=fread(fid,2,'uint32');
+    s=fread(fid,3,'uint64');
+    stamp=fread(fid,[1 16],'*char');
+    if ~strcmp(magic,'SSVIZNMS') || length(v)~=2 || v(1)~=Version || length(s)~=3
+        return
+    end
+    hdr.B=v(2);
+    hdr.nn=s(1);
+    hdr.nt=s(2);
+    hdr.ndone=s(3);
+    hdr.stamp=stamp(stamp>0);
+
+
+function key=Hash(varargin)
+
+    % 16 hex digits, as GridFingerprint
+    if exist('gridhashmex5','file')==3
+        key=gridhashmex5(varargin{:});
+    else
+        key=DataHash(varargin);
+        key=key(1:16);
+    end
@@ -0,0 +1,27 @@
+function Connections=OpenMemberHandles(Connections,EnsIndices)
+% Call as:  Connections=OpenMemberHandles(Connections,EnsIndices)
+%
+% Opens the dataset handles of ensemble members EnsIndices that were
+% connected on parallel workers (see ConnectMembers) and not yet used.
+% Until then a member's .NcTBHandle is its dataset url, so that it
+% reads as available; call this before using the handle as a dataset.
+% A handle that no longer opens is left empty, as if the member's
+% connection had failed at startup.  Derived fields keep their source's
+% url (see DefineDerivedFields); the source is opened in their place.
+
+for i=EnsIndices(:)'
+    for j=1:size(Connections.members,2)
+        Member=Connections.members{i,j};
+        if isempty(Member) || ~isfield(Member,'NcTBHandle') || ~ischar(Member.NcTBHandle) || ...
+                isfield(Member,'Derived')
+            continue
+        end
+        url=Member.NcTBHandle;
+        try
+            Connections.members{i,j}.NcTBHandle=ncgeodataset(url);
+        catch ME
+            SetUIStatusMessage(sprintf('***** Could not open %s connection: %s *****\n',url,ME.message))
+            Connections.members{i,j}.NcTBHandle=[];
+        end
+    end
+end
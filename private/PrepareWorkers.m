@@ -0,0 +1,13 @@
+function PrepareWorkers(pool)
+% Call as:  PrepareWorkers(pool)
+%
+% Gives the workers of the parallel pool the client's dynamic java path
+% (nctoolbox), so that they can open datasets; done once per pool, for
+% ConnectMembers and BatchProducts.
+
+persistent Prepared
+if isequal(Prepared,pool)
+    return
+end
+wait(parfevalOnAll(pool,@javaaddpath,0,javaclasspath('-dynamic')));
+Prepared=pool;
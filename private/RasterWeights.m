@@ -0,0 +1,52 @@
+function R=RasterWeights(TheGrid,BoundingBox,Width)
+% Call as:  R=RasterWeights(TheGrid,BoundingBox,Width)
+%
+% Locates the pixel centers of a raster Width pixels across the
+% BoundingBox [xmin xmax ymin ymax] ([] or NaN for the extent of the
+% grid) in TheGrid, and returns the nodes and linear basis weights of
+% the pixels that fall in the grid.  Any nodal field on the grid is
+% then rasterized by a weighted sum of three nodal values per pixel
+% (see BatchProducts), without drawing it.  Pixels are square in the
+% grid's coordinates, as the map axes are drawn (axis equal), and row
+% 1 of the raster is its top edge.
+%
+% The pixels are located by walking down each column of pixels (see
+% FINDELEM), once per grid and view, and the weights reused for every
+% member and time level on the grid.
+%
+% R has fields:
+%    .nx,.ny - raster size, in pixels
+%    .bbox   - [xmin xmax ymin ymax] of the outer edges of the raster
+%    .dx,.dy - pixel size
+%    .pix    - linear (column-major) indices of the pixels in the grid
+%    .n,.w   - length(pix) x 3 node numbers and weights of those pixels
+
+if isempty(BoundingBox) || any(isnan(BoundingBox))
+    BoundingBox=[min(TheGrid.x) max(TheGrid.x) min(TheGrid.y) max(TheGrid.y)];
+end
+x0=BoundingBox(1);x1=BoundingBox(2);
+y0=BoundingBox(3);y1=BoundingBox(4);
+
+R.nx=max(1,round(Width));
+R.dx=(x1-x0)/R.nx;
+R.ny=max(1,round((y1-y0)/R.dx));
+R.dy=(y1-y0)/R.ny;
+R.bbox=[x0 x1 y0 y1];
+
+[X,Y]=meshgrid(x0+((1:R.nx)-.5)*R.dx,y1-((1:R.ny)-.5)*R.dy);
+j=findelem(TheGrid,X(:),Y(:),'walk');
+
+R.pix=find(~isnan(j));
+j=j(R.pix);
+X=X(R.pix);
+Y=Y(R.pix);
+if exist('interpmex5','file')==3
+    [R.n,R.w]=interpmex5(double(TheGrid.e),TheGrid.ar,TheGrid.A,TheGrid.B,TheGrid.T,X,Y,j);
+else
+    fac=.5./TheGrid.ar(j);
+    R.n=double(TheGrid.e(j,:));
+    R.w=zeros(length(j),3);
+    for k=1:3
+        R.w(:,k)=(TheGrid.T(j,k)+TheGrid.B(j,k).*X+TheGrid.A(j,k).*Y).*fac;
+    end
+end
@@ -0,0 +1,74 @@
+function TheGrid=ReadGridCache(fname)
+% Call as:  TheGrid=ReadGridCache(fname)
+%
+% Reads a grid cache written by WriteGridCache (see it for the file
+% layout).  The section data are mapped with memmapfile rather than
+% parsed, so reading is bounded by the copy into MATLAB arrays, and
+% the file pages are shared through the OS cache by every session
+% reading the same grid.  Connectivity, boundary and permutations are
+% returned as doubles, as in a freshly built grid; the element
+% neighbors .ee and the struct-valued indexes keep the int32 their
+% kernels expect.  .A0 is
+% rederived from .T (T(:,1:2)=2*A0 exactly).
+%
+% An empty TheGrid is returned if the file is not a grid cache of the
+% current version, so the caller can rebuild it.
+
+Version=1;
+Classes={'double','int32','char'};
+
+TheGrid=[];
+fid=fopen(fname,'r','ieee-le');
+if fid<0
+    return
+end
+magic=fread(fid,[1 8],'*char');
+hdr=fread(fid,2,'uint32');
+if ~strcmp(magic,'SSVIZFGS') || length(hdr)~=2 || hdr(1)~=Version
+    fclose(fid);
+    fprintf('%s is not a version %d grid cache.\n',fname,Version);
+    return
+end
+nsec=hdr(2);
+names=cell(nsec,1);
+tab=zeros(nsec,4);   % class rows cols offset
+for i=1:nsec
+    n=fread(fid,[1 32],'*uint8');
+    names{i}=char(n(n>0));
+    c=fread(fid,2,'uint32');
+    d=fread(fid,3,'uint64');
+    tab(i,:)=[c(1) d'];
+end
+fclose(fid);
+
+for i=1:nsec
+    cls=Classes{tab(i,1)};
+    if strcmp(cls,'char')
+        mcls='uint8';
+    else
+        mcls=cls;
+    end
+    if tab(i,2)*tab(i,3)==0
+        val=zeros(tab(i,2),tab(i,3),mcls);
+    else
+        m=memmapfile(fname,'Offset',tab(i,4),'Repeat',1,...
+                     'Format',{mcls,[tab(i,2) tab(i,3)],'v'});
+        val=m.Data.v;
+    end
+    if strcmp(cls,'char')
+        val=char(val);
+    end
+    k=find(names{i}=='.',1);
+    if isempty(k)
+        if strcmp(cls,'int32') && ~strcmp(names{i},'ee')
+            val=double(val);
+        end
+        TheGrid.(names{i})=val;
+    else
+        TheGrid.(names{i}(1:k-1)).(names{i}(k+1:end))=val;
+    end
+end
+
+if isfield(TheGrid,'T')
+    TheGrid.A0=TheGrid.T(:,1:2)/2;
+end
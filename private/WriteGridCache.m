@@ -0,0 +1,108 @@
+function WriteGridCache(fname,TheGrid)
+% Call as:  WriteGridCache(fname,TheGrid)
+%
+% Writes a fem_grid_struct to the binary grid cache file fname, to be
+% read back with ReadGridCache.  Only what cannot be derived cheaply is
+% stored: connectivity, boundary and the element neighbors .ee as
+% int32, the nodal x,y,z, the element arrays .ar,.A,.B,.T used by the
+% element search, and the .hash of the grid it was built from (see
+% GridFingerprint).  .A0 is rederived on load; .dx, .dy and the EL_AREAS angle fields are not
+% used by StormSurgeViz and are not stored.  Structure-valued indexes
+% (.elindex, .nodeindex, the drawing hierarchy .lod, and .strtree when
+% built by strtreemex5) are stored field by field.  A Java strtree is not stored.
+%
+% File layout (little-endian), version 1:
+%    char[8]   'SSVIZFGS'
+%    uint32    version
+%    uint32    number of sections, nsec
+%    nsec x 64-byte section entries:
+%       char[32]  name, NUL padded ('elindex.start' for struct fields)
+%       uint32    class: 1=double, 2=int32, 3=char
+%       uint32    0
+%       uint64    rows
+%       uint64    cols
+%       uint64    byte offset of the data from the start of the file
+%    section data, column-major, each starting on an 8-byte boundary
+%
+% The file is written under a temporary name and then moved into
+% place, so concurrent sessions never read a partial cache.
+
+Version=1;
+Classes={'double','int32','char'};
+
+% top-level fields and the class they are stored as
+Fields={'name','char'
+        'hash','char'
+        'e','int32'
+        'x','double'
+        'y','double'
+        'z','double'
+        'bnd','int32'
+        'ar','double'
+        'A','double'
+        'B','double'
+        'T','double'
+        'ineg','int32'
+        'ee','int32'
+        'perm','int32'
+        'eperm','int32'};
+
+names={};vals={};
+for i=1:size(Fields,1)
+    if isfield(TheGrid,Fields{i,1})
+        names{end+1}=Fields{i,1}; %#ok<AGROW>
+        vals{end+1}=feval(Fields{i,2},TheGrid.(Fields{i,1})); %#ok<AGROW>
+    end
+end
+SubStructs={'elindex','strtree','lod','nodeindex'};
+for i=1:length(SubStructs)
+    if isfield(TheGrid,SubStructs{i}) && isstruct(TheGrid.(SubStructs{i}))
+        s=TheGrid.(SubStructs{i});
+        f=fieldnames(s);
+        for j=1:length(f)
+            names{end+1}=[SubStructs{i} '.' f{j}]; %#ok<AGROW>
+            vals{end+1}=s.(f{j}); %#ok<AGROW>
+        end
+    end
+end
+
+nsec=length(names);
+cls=zeros(nsec,1);
+off=zeros(nsec,1);
+BytesPer=[8 4 1];
+pos=16+64*nsec;
+for i=1:nsec
+    k=find(strcmp(class(vals{i}),Classes));
+    if isempty(k)
+        error('WriteGridCache: field %s has unsupported class %s',names{i},class(vals{i}))
+    end
+    cls(i)=k;
+    off(i)=pos;
+    pos=pos+ceil(numel(vals{i})*BytesPer(k)/8)*8;
+end
+
+tmpname=[fname '.' num2str(feature('getpid')) '.tmp'];
+fid=fopen(tmpname,'w','ieee-le');
+if fid<0
+    error('WriteGridCache: could not open %s for writing',tmpname)
+end
+fwrite(fid,'SSVIZFGS','char');
+fwrite(fid,[Version nsec],'uint32');
+for i=1:nsec
+    n=zeros(1,32,'uint8');
+    n(1:length(names{i}))=uint8(names{i});
+    fwrite(fid,n,'uint8');
+    fwrite(fid,[cls(i) 0],'uint32');
+    fwrite(fid,[size(vals{i},1) size(vals{i},2) off(i)],'uint64');
+end
+for i=1:nsec
+    fseek(fid,0,'eof');
+    fwrite(fid,zeros(1,off(i)-ftell(fid),'uint8'),'uint8');
+    if cls(i)==3
+        fwrite(fid,vals{i},'char');
+    else
+        fwrite(fid,vals{i},Classes{cls(i)});
+    end
+end
+fclose(fid);
+movefile(tmpname,fname,'f');
@@ -0,0 +1,116 @@
+function WriteShapeFile(SS,OutName)
+% Call as:  WriteShapeFile(SS,OutName)
+%
+% Writes the polygon structure SS from MakeAdcircShape to the ESRI
+% shapefile OutName.shp, with its index OutName.shx and attribute
+% table OutName.dbf.  Each record of SS is one polygon; its parts are
+% the NaN-separated pieces of .Lon,.Lat.  Every field of SS other than
+% .Geometry, .BoundingBox, .Lon and .Lat is written to the .dbf as a
+% numeric attribute.
+%
+% The caller builds SS whole; here each record is converted to its
+% parts and points only as it is written, so no second copy of the
+% shape set is made, and the Mapping Toolbox is not needed.
+%
+% File layouts follow the ESRI Shapefile Technical Description (1998):
+%    .shp/.shx  100-byte header (file code and length big-endian,
+%               the rest little-endian), then per record a big-endian
+%               record number and content length (in 16-bit words)
+%               and, for shape type 5, the little-endian box, part
+%               and point counts, part offsets and x,y points
+%    .dbf       dBase III table of N(19,8) fields
+
+ShapeType=5;   % polygon
+FieldWidth=19;
+FieldDecimals=8;
+
+f=fieldnames(SS);
+Attrs=f(~ismember(f,{'Geometry','BoundingBox','Lon','Lat'}));
+nrec=length(SS);
+
+fshp=fopen(sprintf('%s.shp',OutName),'w','ieee-le');
+fshx=fopen(sprintf('%s.shx',OutName),'w','ieee-le');
+fdbf=fopen(sprintf('%s.dbf',OutName),'w','ieee-le');
+if fshp<0 || fshx<0 || fdbf<0
+    error('Could not open shape files %s.* for writing.',OutName)
+end
+
+% headers are rewritten with the final lengths and box at the end
+WriteHeader(fshp,0,ShapeType,zeros(1,4));
+WriteHeader(fshx,0,ShapeType,zeros(1,4));
+
+% dbf header
+DbfHeaderLength=32+32*length(Attrs)+1;
+DbfRecordLength=1+FieldWidth*length(Attrs);
+d=clock;
+fwrite(fdbf,[3 d(1)-1900 d(2) d(3)],'uint8');
+fwrite(fdbf,nrec,'uint32');
+fwrite(fdbf,[DbfHeaderLength DbfRecordLength],'uint16');
+fwrite(fdbf,zeros(1,20),'uint8');
+for i=1:length(Attrs)
+    name=zeros(1,11);
+    n=min(10,length(Attrs{i}));
+    name(1:n)=double(Attrs{i}(1:n));
+    fwrite(fdbf,name,'uint8');
+    fwrite(fdbf,'N','uchar');
+    fwrite(fdbf,zeros(1,4),'uint8');
+    fwrite(fdbf,[FieldWidth FieldDecimals],'uint8');
+    fwrite(fdbf,zeros(1,14),'uint8');
+end
+fwrite(fdbf,13,'uint8');
+
+Box=[Inf Inf -Inf -Inf];
+offset=50;   % in 16-bit words
+for i=1:nrec
+    x=SS(i).Lon(:);
+    y=SS(i).Lat(:);
+    brk=isnan(x);
+    % part starts, 0-based into the points with the NaNs removed
+    start=find(~brk & [true;brk(1:end-1)]);
+    nbrk=cumsum(brk);
+    parts=start-1-nbrk(start);
+    x=x(~brk);
+    y=y(~brk);
+    np=length(parts);
+    npts=length(x);
+    rbox=[min(x) min(y) max(x) max(y)];
+    Box=[min(Box(1:2),rbox(1:2)) max(Box(3:4),rbox(3:4))];
+
+    len=(44+4*np+16*npts)/2;   % content length in 16-bit words
+    fwrite(fshx,[offset len],'int32',0,'ieee-be');
+    fwrite(fshp,[i len],'int32',0,'ieee-be');
+    fwrite(fshp,ShapeType,'int32');
+    fwrite(fshp,rbox,'double');
+    fwrite(fshp,[np npts],'int32');
+    fwrite(fshp,parts,'int32');
+    fwrite(fshp,[x y]','double');
+    offset=offset+4+len;
+
+    fwrite(fdbf,' ','uchar');
+    for j=1:length(Attrs)
+        fwrite(fdbf,sprintf('%*.*f',FieldWidth,FieldDecimals,SS(i).(Attrs{j})),'uchar');
+    end
+end
+fwrite(fdbf,26,'uint8');
+
+if nrec==0, Box=zeros(1,4); end
+WriteHeader(fshp,offset,ShapeType,Box);
+WriteHeader(fshx,50+4*nrec,ShapeType,Box);
+
+fclose(fshp);
+fclose(fshx);
+fclose(fdbf);
+
+end
+
+
+function WriteHeader(fid,len,ShapeType,Box)
+
+    % len is the file length in 16-bit words
+    frewind(fid);
+    fwrite(fid,[9994 0 0 0 0 0 len],'int32',0,'ieee-be');
+    fwrite(fid,[1000 ShapeType],'int32');
+    fwrite(fid,[Box 0 0 0 0],'double');
+    fseek(fid,0,'eof');
+
+end
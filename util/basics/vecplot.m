@@ -49,6 +49,11 @@ function  retval=vecplot(xin,yin,uin,vin,varargin)
 %                 'floating'; Default='fixed'.
 %    ScaleXor   - scale x-origin; Default=[].
 %    ScaleYor   - scale y-origin; Default=[].
+%    Spacing    - screen spacing (pixels) of the vectors drawn.  The
+%                 axes are split into cells this wide and the vector
+%                 nearest each cell center is drawn, so the vectors
+%                 are evenly spread over the view.  Overrides Stride.
+%                 Default=0, meaning Stride is used.
 %    Stride     - amount to stride over in drawing vectors. Default=1, 
 %                 meaning no stride.
 %    VecType    - vector drawing method, either 'arrow' or 'stick';
@@ -93,6 +98,7 @@ MaxThresh=Inf;
 ScaleLabel='m/s';
 ScaleType='fixed';
 Stride=1;
+Spacing=0;
 VecType='arrow';
 ScaleFac=1.;
 ScaleXor=[];
@@ -114,6 +120,9 @@ while k<length(varargin)
     case 'stride'
       Stride=varargin{k+1};
       varargin([k k+1])=[];
+    case 'spacing'
+      Spacing=varargin{k+1};
+      varargin([k k+1])=[];
     case 'scaletype'
       ScaleType=varargin{k+1};
       varargin([k k+1])=[];
@@ -186,7 +195,13 @@ pct10=(PctAxis/100)*xr;
 
 % determine striding, if needed
 [m,n]=size(xin);
-if Stride >1
+if Spacing>0
+   i=vecbin(xin,yin,uin,vin,[X1 X2 Y1 Y2],Spacing,MinThresh,MaxThresh);
+   x=xin(i);
+   y=yin(i);
+   u=uin(i);
+   v=vin(i);
+elseif Stride >1
    if any([m n]==1)
       i=1:Stride:length(xin);
       x=xin(i);
@@ -432,6 +447,34 @@ end
 set(gcf,'Pointer',CurrentPointer);
 
 
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%%%%%%%%%%%%  PRIVATE FUNCTION TO PICK VECTORS BY CELL  %%%%%%%%
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+function i=vecbin(x,y,u,v,axx,Spacing,MinThresh,MaxThresh)
+
+% one vector per Spacing x Spacing pixel cell of the current axes, 
+% the one nearest the cell center; vecbinmex5 does this in one pass
+% over the nodes
+pos=getpixelposition(gca);
+cells=max(1,round(pos(3:4)/Spacing));
+if exist('vecbinmex5','file')==3
+   i=vecbinmex5(x,y,u,v,axx,cells,[MinThresh MaxThresh]);
+   return
+end
+
+x=x(:);y=y(:);
+mag=sqrt(u(:).^2+v(:).^2);
+i=find(x>=axx(1) & x<=axx(2) & y>=axx(3) & y<=axx(4) & ...
+       mag>MinThresh & mag<MaxThresh);
+fx=(x(i)-axx(1))*cells(1)/(axx(2)-axx(1));
+fy=(y(i)-axx(3))*cells(2)/(axx(4)-axx(3));
+ix=min(cells(1)-1,floor(fx));
+iy=min(cells(2)-1,floor(fy));
+[~,o]=sort((fx-ix-.5).^2+(fy-iy-.5).^2);
+[~,k]=unique(iy(o)*cells(1)+ix(o),'first');
+i=i(o(k));
+
+
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %%%%%%%%%%%%  PRIVATE FUNCTION FOR VECPLOT HELP   %%%%%%%%%%%%%%%
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -474,6 +517,8 @@ switch arg
         str=[str sprintf('		               ''floating''; Default=''fixed''.\n')];
         str=[str sprintf('    ScaleXor  - scale x-origin; Default=[].\n')];
         str=[str sprintf('    ScaleYor  - scale y-origin; Default=[].\n')];
+        str=[str sprintf('    Spacing    - screen spacing (pixels) of the vectors drawn;\n')];
+        str=[str sprintf('		               overrides Stride. Default=0, meaning Stride is used.\n')];
         str=[str sprintf('    Stride     - amount to stride over in drawing vectors. Default=1,\n')];
         str=[str sprintf('		               meaning no stride. Stride=2 skips every other point.\n')];
         str=[str sprintf('    VecType    - vector drawing method, either ''arrow'' or ''stick'';\n')];
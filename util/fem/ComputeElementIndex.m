@@ -0,0 +1,30 @@
+function idx=ComputeElementIndex(fgs,TOL)
+% Call as:  idx=ComputeElementIndex(fgs);
+%
+% Builds a bucket index over the element bounding boxes for use by
+% FINDELEM and INTERP_SCALAR.  The index is built once per grid by
+% findelemex5 from the .ar,.A,.B,.T fields (see BELINT and EL_AREAS)
+% and is attached to the fem_grid_struct as .elindex.  Each point is 
+% then only tested against the elements in its bucket instead of 
+% against every element in the grid.
+%
+% TOL is the largest basis function tolerance the index will be queried
+% with; the default of 1e-4 covers FINDELEM, INTERP_SCALAR and 
+% FindElementsInStrTree.  An empty index is returned if the findelemex5
+% binary predates the 'index' mode (rerun makemex in util/mex).
+
+if ~exist('TOL','var')
+    TOL=1e-4;
+end
+
+ne=size(fgs.e,1);
+tic
+try
+    idx=findelemex5('index',fgs.ar,fgs.A,fgs.B,fgs.T,TOL);
+catch
+    fprintf('findelemex5 does not support element indexing.  Rebuild with makemex.\n');
+    idx=[];
+    return
+end
+t=toc;
+fprintf('Element index for %d elements computed in %.1f secs\n',ne,t);
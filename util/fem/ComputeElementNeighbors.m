@@ -0,0 +1,20 @@
+function ee=ComputeElementNeighbors(fgs)
+% Call as:  ee=ComputeElementNeighbors(fgs);
+%
+% Returns the element neighbors of the grid, ne x 3 int32: ee(k,j) is
+% the element across the edge from node j to node j+1 (3 to 1) of
+% element k, 0 on the boundary.  This is the .ee field of GRIDTOPOMEX5,
+% and is attached to the fem_grid_struct as .ee for the walking search
+% of FINDELEM.  An empty array is returned if gridtopomex5 is not built
+% (run makemex in util/mex).
+
+if exist('gridtopomex5','file')~=3
+    ee=[];
+    return
+end
+
+tic
+T=gridtopomex5(fgs.e,length(fgs.x));
+ee=T.ee;
+t=toc;
+fprintf('Element neighbors for %d elements computed in %.1f secs\n',size(fgs.e,1),t);
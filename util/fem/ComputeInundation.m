@@ -5,10 +5,15 @@ function NewZeta=ComputeInundation(FemGridStruct,Zeta)
 %mask(FemGridStruct.z<=0)=1;
 %NewZeta=(Zeta+FemGridStruct.z).*mask;
 
+if exist('ensstatmex5','file')==3 && isreal(Zeta)
+    % one pass, no full-grid temporaries (see EnsembleStats)
+    NewZeta=reshape(ensstatmex5({double(Zeta(:))},[1 0],double(FemGridStruct.z(:))),size(Zeta));
+    return
+end
+
 NewZeta=(Zeta+FemGridStruct.z);
 idx=FemGridStruct.z>=0;
 %NewZeta(idx)=Zeta(idx);
 
 NewZeta(idx)=NaN;
 
-
@@ -0,0 +1,124 @@
+function lod=ComputeMeshLOD(fgs,MinElements)
+% Call as:  lod=ComputeMeshLOD(fgs);
+%      or:  lod=ComputeMeshLOD(fgs,MinElements);
+%
+% Builds a level-of-detail hierarchy of the grid for drawing, attached
+% to the fem_grid_struct as .lod and queried with SELECTMESHLOD.
+% Level 1 is the grid itself; each coarser level is made by vertex
+% clustering: the nodes are binned into square cells twice as wide as
+% on the level before, each cell's nodes are collapsed onto the node
+% nearest their centroid, and the elements that collapse to an edge or
+% a point are dropped.  The coarse elements are grid node numbers, so
+% a nodal field is drawn on any level without resampling.  Levels are
+% added until fewer than MinElements (default 20000) are left, or
+% until a level no longer reduces the element count.
+%
+% On every level the elements are sorted into NTiles x NTiles spatial
+% tiles by centroid, with the bounding box of each tile, so that only
+% the tiles overlapping the view are gathered.
+%
+% The hierarchy is a structure of flat arrays (saved with the cached
+% grid structure):
+%    lod.order  - level 1 elements (rows of fgs.e) in tile order
+%    lod.e      - elements of levels 2..nlev in tile order, stacked
+%    lod.levels - nlev x 3, [number of elements, offset into lod.e,
+%                 cell size]; the offset of level 1 is 0 (into order)
+%    lod.tstart - (NTiles^2+1) x nlev, start of each tile's elements
+%                 within its level (1-based, CSR)
+%    lod.tbox   - (NTiles^2*nlev) x 4, [xmin xmax ymin ymax] of each
+%                 tile's elements, levels stacked
+%    lod.extent - [xmin xmax ymin ymax] of the grid
+%    lod.ntiles - NTiles
+
+if ~exist('MinElements','var')
+    MinElements=20000;
+end
+NTiles=64;
+MaxLevels=12;
+
+ne=size(fgs.e,1);
+tic
+
+x=fgs.x(:);
+y=fgs.y(:);
+extent=[min(x) max(x) min(y) max(y)];
+
+if isfield(fgs,'ar')
+    ar=abs(fgs.ar);
+else
+    ar=abs(x(fgs.e(:,1)).*(y(fgs.e(:,2))-y(fgs.e(:,3)))+ ...
+           x(fgs.e(:,2)).*(y(fgs.e(:,3))-y(fgs.e(:,1)))+ ...
+           x(fgs.e(:,3)).*(y(fgs.e(:,1))-y(fgs.e(:,2))))/2;
+end
+% level 2 cells are about twice the typical element side
+h=3*sqrt(median(ar));
+
+lod=struct;
+lod.ntiles=NTiles;
+lod.extent=extent;
+
+[order,tstart,tbox]=TileElements(fgs.e,x,y,extent,NTiles);
+lod.order=int32(order);
+lod.tstart=tstart;
+lod.tbox=tbox;
+lod.levels=[ne 0 0];
+lod.e=zeros(0,3,'int32');
+
+nl=ne;
+while nl>MinElements && size(lod.levels,1)<MaxLevels
+
+    % collapse each cell's nodes onto the one nearest their centroid
+    ix=floor((x-extent(1))/h);
+    iy=floor((y-extent(3))/h);
+    [~,~,c]=unique(ix*(max(iy)+1)+iy);
+    cnt=accumarray(c,1);
+    cx=accumarray(c,x)./cnt;
+    cy=accumarray(c,y)./cnt;
+    [~,o]=sort((x-cx(c)).^2+(y-cy(c)).^2);
+    [~,ia]=unique(c(o),'first');
+    rep=o(ia);
+
+    E=reshape(rep(c(fgs.e)),ne,3);
+    E=E(E(:,1)~=E(:,2) & E(:,2)~=E(:,3) & E(:,3)~=E(:,1),:);
+    [~,iu]=unique(sort(E,2),'rows');
+    E=E(sort(iu),:);
+
+    if size(E,1)>.9*nl
+        % cells no longer span elements, so clustering has stalled
+        h=2*h;
+        if h>max(extent(2)-extent(1),extent(4)-extent(3)),break,end
+        continue
+    end
+    nl=size(E,1);
+
+    [order,tstart,tbox]=TileElements(E,x,y,extent,NTiles);
+    lod.levels(end+1,:)=[nl size(lod.e,1) h];
+    lod.e=[lod.e;int32(E(order,:))];
+    lod.tstart(:,end+1)=tstart;
+    lod.tbox=[lod.tbox;tbox];
+    h=2*h;
+end
+
+t=toc;
+fprintf('Mesh LOD with %d levels (%d to %d elements) computed in %.1f secs\n',...
+    size(lod.levels,1),ne,nl,t);
+
+
+function [order,tstart,tbox]=TileElements(e,x,y,extent,NTiles)
+
+    % elements in tile order, by centroid
+    dx=(extent(2)-extent(1))/NTiles;
+    dy=(extent(4)-extent(3))/NTiles;
+    xe=x(e);
+    ye=y(e);
+    tx=min(NTiles-1,floor((mean(xe,2)-extent(1))/dx));
+    ty=min(NTiles-1,floor((mean(ye,2)-extent(3))/dy));
+    t=ty*NTiles+tx+1;
+    [t,order]=sort(t);
+
+    nt=NTiles^2;
+    tstart=cumsum([1;accumarray(t,1,[nt 1])]);
+    tbox=[accumarray(t,min(xe(order,:),[],2),[nt 1],@min,Inf) ...
+          accumarray(t,max(xe(order,:),[],2),[nt 1],@max,-Inf) ...
+          accumarray(t,min(ye(order,:),[],2),[nt 1],@min,Inf) ...
+          accumarray(t,max(ye(order,:),[],2),[nt 1],@max,-Inf)];
@@ -0,0 +1,38 @@
+function idx=ComputeNodeIndex(fgs)
+% Call as:  idx=ComputeNodeIndex(fgs);
+%
+% Builds a tile index over the grid nodes for viewport queries, attached
+% to the fem_grid_struct as .nodeindex and used by NODESINBOX and
+% EXTREMAINBOX.  The grid extent is split into NTiles x NTiles equal
+% tiles and the nodes are listed tile by tile, in increasing node
+% number within each tile.  A box query then takes the tiles inside
+% the box whole and tests only the nodes of the tiles on its edges.
+%
+%    idx.order  - node numbers in tile order
+%    idx.tstart - (NTiles^2+1) x 1, start of each tile's nodes in
+%                 order (1-based, CSR); tile t is column-major,
+%                 t=ty*NTiles+tx+1
+%    idx.extent - [xmin xmax ymin ymax] of the grid
+%    idx.ntiles - NTiles
+
+NTiles=128;
+
+x=fgs.x(:);
+y=fgs.y(:);
+extent=[min(x) max(x) min(y) max(y)];
+
+t=NodeTiles(x,y,extent,NTiles);
+[t,order]=sort(t);
+
+idx=struct;
+idx.order=int32(order);
+idx.tstart=cumsum([1;accumarray(t,1,[NTiles^2 1])]);
+idx.extent=extent;
+idx.ntiles=NTiles;
+
+
+function t=NodeTiles(x,y,extent,NTiles)
+
+    tx=min(NTiles-1,floor((x-extent(1))/((extent(2)-extent(1))/NTiles)));
+    ty=min(NTiles-1,floor((y-extent(3))/((extent(4)-extent(3))/NTiles)));
+    t=ty*NTiles+tx+1;
@@ -1,17 +1,30 @@
 function mystr=ComputeStrTree(fgs)
 % Call as:  StrTree=ComputeStrTree(fgs)
+%
+% Bulk-loads a packed STR R-tree over the (fuzzed) element envelopes 
+% in one call to strtreemex5.  The tree is a structure of flat arrays,
+% so it is saved and reloaded with the cached grid structure without
+% being rebuilt.  FindElementsInStrTree queries it.  If strtreemex5
+% has not been compiled, the JTS STRtree is built instead.
 
 % import java.io.ObjectOutputStream;
 % import java.io.FileOutputStream;
 
 ne=size(fgs.e,1);
 %fprintf('Computing STRtree for %d elements ... \n',ne);
+tic
+if exist('strtreemex5','file')==3
+    mystr=strtreemex5('build',fgs.x,fgs.y,fgs.e);
+    t=toc;
+    fprintf('STRtree for %d elements computed in %.1f secs\n',ne,t);
+    return
+end
+
 FuzzFac=100;
 xmin=min(fgs.x(fgs.e),[],2);    
 xmax=max(fgs.x(fgs.e),[],2);    
 ymin=min(fgs.y(fgs.e),[],2);    
 ymax=max(fgs.y(fgs.e),[],2);        
-tic
 mystr=com.vividsolutions.jts.index.strtree.STRtree;
 for j=1:ne
     %if mod(j-1,10000)==0,fprintf('%d\n',j),end
@@ -0,0 +1,81 @@
+function S=EnsembleStats(Z,ops,z)
+% S=EnsembleStats(Z,ops)
+% S=EnsembleStats(Z,ops,z)
+%
+% Nodal statistics over the ensemble members Z, a cell of nodal
+% vectors (or an nn x nm matrix, one column per member).  ops is k x 2,
+% one row [code param] per column of S (nn x k):
+%    1  mean                  5  param'th percentile (0-100)
+%    2  minimum               6  fraction of members above param
+%    3  maximum               7  number of members not NaN
+%    4  standard deviation
+% NaN members (dry nodes) are ignored, and count as not above param.
+% With the nodal depths z, each member value is first made the
+% inundation depth (see ComputeInundation).  ensstatmex5 takes every
+% statistic in one blocked pass over the members; otherwise the members
+% are gathered into a matrix here.
+
+if ~exist('z','var'),z=[];end
+
+if exist('ensstatmex5','file')==3
+    if isempty(z)
+        S=ensstatmex5(Z,ops);
+    else
+        S=ensstatmex5(Z,ops,double(z(:)));
+    end
+    return
+end
+
+if iscell(Z)
+    Z=cellfun(@(q)double(q(:)),Z,'UniformOutput',false);
+    Z=[Z{:}];
+end
+if ~isempty(z)
+    Z=Z+repmat(z(:),1,size(Z,2));
+    Z(z(:)>=0,:)=NaN;
+end
+
+[nn,nm]=size(Z);
+wet=~isnan(Z);
+n=sum(wet,2);
+Z0=Z;
+Z0(~wet)=0;
+S=NaN(nn,size(ops,1));
+for j=1:size(ops,1)
+    switch ops(j,1)
+        case 1
+            q=sum(Z0,2)./n;
+        case 2
+            q=min(Z,[],2);
+        case 3
+            q=max(Z,[],2);
+        case 4
+            % squares about the mean, in a second pass as ensstatmex5
+            m=sum(Z0,2)./n;
+            d=Z0-repmat(m,1,nm);
+            d(~wet)=0;
+            q=sqrt(max(sum(d.^2,2)./max(n-1,1),0));
+        case 5
+            % the k'th of n sorted values is the 100*(k-.5)/n
+            % percentile, linear between, flat beyond; NaNs sort last
+            Zs=sort(Z,2);
+            pos=min(max(ops(j,2)/100*n+.5,1),max(n,1));
+            lo=floor(pos);
+            hi=min(lo+1,max(n,1));
+            r=(1:nn)';
+            a=Zs(r+nn*(lo-1));
+            b=Zs(r+nn*(hi-1));
+            q=a+(pos-lo).*(b-a);
+            q(pos==lo)=a(pos==lo);
+        case 6
+            q=sum(Z>ops(j,2),2)/nm;
+        case 7
+            q=n;
+        otherwise
+            error('Unknown statistic code %g in EnsembleStats.',ops(j,1))
+    end
+    if ~any(ops(j,1)==[6 7])
+        q(n==0)=NaN;
+    end
+    S(:,j)=q;
+end
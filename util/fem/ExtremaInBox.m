@@ -0,0 +1,50 @@
+function [Min,Max,iMin,iMax]=ExtremaInBox(fgs,q,axx,S)
+% Call as:  [Min,Max,iMin,iMax]=ExtremaInBox(fgs,q,axx);
+%      or:  [Min,Max,iMin,iMax]=ExtremaInBox(fgs,q,axx,S);
+%
+% Minimum and maximum of the nodal field q over the nodes strictly
+% inside the box axx=[xmin xmax ymin ymax], NaNs ignored, and the
+% nodes iMin,iMax where they are taken (the lowest-numbered one on a
+% tie), as min(q(NodesInBox(fgs,axx))) would give.  With the per-tile
+% summary S of q from TILEEXTREMA, the tiles inside the box are read
+% from S and only the nodes of the tiles on its edges are visited, so
+% a query after a zoom costs as much as the box's perimeter.  Without
+% S, it is computed here.  Empty results if no node is in the box,
+% or if q is NaN at all of them.
+
+q=q(:);
+if ~isfield(fgs,'nodeindex') || ~isstruct(fgs.nodeindex)
+    idx=NodesInBox(fgs,axx);
+    [Min,k]=min(q(idx));
+    iMin=idx(k);
+    [Max,k]=max(q(idx));
+    iMax=idx(k);
+    [Min,Max,iMin,iMax]=DropNaN(Min,Max,iMin,iMax);
+    return
+end
+if ~exist('S','var') || isempty(S)
+    S=TileExtrema(fgs,q);
+end
+
+[idx,inner]=NodesInBox(fgs,axx);
+
+% candidate values and nodes: the edge-tile nodes and the inner-tile 
+% extremes, in node order so that min/max keep the first on a tie
+[nmin,k]=sort([idx(:);S(inner,3)]);
+vmin=[q(idx(:));S(inner,1)];
+vmin=vmin(k);
+[nmax,k]=sort([idx(:);S(inner,4)]);
+vmax=[q(idx(:));S(inner,2)];
+vmax=vmax(k);
+
+[Min,k]=min(vmin);
+iMin=nmin(k);
+[Max,k]=max(vmax);
+iMax=nmax(k);
+[Min,Max,iMin,iMax]=DropNaN(Min,Max,iMin,iMax);
+
+function [Min,Max,iMin,iMax]=DropNaN(Min,Max,iMin,iMax)
+% min/max of all NaNs is NaN at the first candidate; there is no
+% extreme to report
+if isempty(Min) || isnan(Min),Min=[];iMin=[];end
+if isempty(Max) || isnan(Max),Max=[];iMax=[];end
@@ -7,6 +7,14 @@ if ~exist('TOL')
     TOL=1e-4;
 end
 
+% native tree from strtreemex5; one batched call does the envelope
+% search and the basis function test for all points
+if isstruct(fgs.strtree)
+    j(:)=strtreemex5('query',fgs.strtree,points_x(:),points_y(:),...
+                     fgs.ar,fgs.A,fgs.B,fgs.T,TOL);
+    return
+end
+
 %%
 %tic;
 for i=1:m
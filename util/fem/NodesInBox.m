@@ -0,0 +1,60 @@
+function [idx,inner]=NodesInBox(fgs,axx)
+% Call as:  idx=NodesInBox(fgs,axx);
+%      or:  [idx,inner]=NodesInBox(fgs,axx);
+%
+% Returns the nodes strictly inside the box axx=[xmin xmax ymin ymax],
+% in increasing node number, from the tile index fgs.nodeindex (see
+% COMPUTENODEINDEX).  Only the nodes of the tiles on the edges of the
+% box are tested; the tiles inside it are taken whole.  With two
+% outputs, idx is only the nodes found in the edge tiles, unsorted, and
+% inner the tiles inside the box, for queries (see EXTREMAINBOX) that
+% have per-tile summaries for those.
+%
+% Without fgs.nodeindex, every node is tested.
+
+if ~isfield(fgs,'nodeindex') || ~isstruct(fgs.nodeindex)
+    idx=find(fgs.x<axx(2) & fgs.x>axx(1) & fgs.y<axx(4) & fgs.y>axx(3));
+    inner=[];
+    return
+end
+
+ni=fgs.nodeindex;
+N=ni.ntiles;
+dx=(ni.extent(2)-ni.extent(1))/N;
+dy=(ni.extent(4)-ni.extent(3))/N;
+
+% tiles overlapping the box, and those entirely inside it
+tx=max(0,floor((axx(1)-ni.extent(1))/dx)):min(N-1,floor((axx(2)-ni.extent(1))/dx));
+ty=max(0,floor((axx(3)-ni.extent(3))/dy)):min(N-1,floor((axx(4)-ni.extent(3))/dy));
+[TX,TY]=ndgrid(tx,ty);
+x0=ni.extent(1)+TX(:)*dx;
+y0=ni.extent(3)+TY(:)*dy;
+in=x0>axx(1) & x0+dx<axx(2) & y0>axx(3) & y0+dy<axx(4);
+t=TY(:)*N+TX(:)+1;
+
+edge=TileNodes(ni,t(~in));
+idx=edge(fgs.x(edge)<axx(2) & fgs.x(edge)>axx(1) & ...
+         fgs.y(edge)<axx(4) & fgs.y(edge)>axx(3));
+
+if nargout==2
+    inner=t(in);
+else
+    idx=sort([idx;TileNodes(ni,t(in))]);
+end
+
+
+function n=TileNodes(ni,t)
+
+    % nodes of the tiles t, concatenating the ranges of ni.order
+    ts=ni.tstart(t);
+    c=ni.tstart(t+1)-ts;
+    ts=ts(c>0);
+    c=c(c>0);
+    if isempty(c)
+        n=zeros(0,1);
+        return
+    end
+    k=ones(sum(c),1);
+    k(1)=ts(1);
+    k(cumsum(c(1:end-1))+1)=ts(2:end)-(ts(1:end-1)+c(1:end-1)-1);
+    n=double(ni.order(cumsum(k)));
@@ -0,0 +1,79 @@
+function fgs=ReorderGrid(fgs)
+% Call as:  fgs=ReorderGrid(fgs)
+%
+% Renumbers the nodes and elements of a fem_grid_struct along a
+% Hilbert curve (see gridordermex5), so that the per-element kernels
+% (contmex5, isopmex5, findelemex5, interp_scalar) gather nodal values
+% from nearby memory.  The node order within each element is kept, so
+% element areas and basis arrays are the same numbers, only reordered.
+%
+% The permutations are attached to the structure:
+%    fgs.perm  - original node number of each node, i.e. the new x is
+%                the original x(fgs.perm); a nodal field read from the
+%                model output is put on the grid as q(fgs.perm)
+%    fgs.eperm - original element number of each element
+%
+% Per-element fields from EL_AREAS and BELINT are reordered, and .bnd
+% is renumbered.  The element and node indexes, strtree and mesh LOD
+% refer to element or node numbers, so they are removed and must be
+% recomputed.  The grid is returned unchanged if gridordermex5 has not
+% been compiled, or if it has already been reordered.
+
+if isfield(fgs,'perm')
+    return
+end
+if exist('gridordermex5','file')~=3
+    fprintf('gridordermex5 not found.  Grid not reordered; rebuild with makemex.\n');
+    return
+end
+
+nn=length(fgs.x);
+ne=size(fgs.e,1);
+tic
+[perm,eperm]=gridordermex5(fgs.x,fgs.y,fgs.e);
+
+% iperm(i) is the new number of original node i
+iperm=zeros(nn,1);
+iperm(perm)=1:nn;
+
+fgs.e=reshape(iperm(fgs.e(eperm,:)),ne,3);
+nodefields={'x','y','z'};
+for i=1:length(nodefields)
+    if isfield(fgs,nodefields{i}) && length(fgs.(nodefields{i}))==nn
+        fgs.(nodefields{i})=fgs.(nodefields{i})(perm);
+    end
+end
+elemfields={'ar','A','B','T','A0','dx','dy','interiorangles','acute'};
+for i=1:length(elemfields)
+    if isfield(fgs,elemfields{i}) && size(fgs.(elemfields{i}),1)==ne
+        fgs.(elemfields{i})=fgs.(elemfields{i})(eperm,:);
+    end
+end
+if isfield(fgs,'bnd')
+    fgs.bnd=reshape(iperm(fgs.bnd),size(fgs.bnd));
+end
+if isfield(fgs,'ineg')
+    ieperm=zeros(ne,1);
+    ieperm(eperm)=1:ne;
+    fgs.ineg=sort(ieperm(fgs.ineg));
+end
+if isfield(fgs,'elindex')
+    fgs=rmfield(fgs,'elindex');
+end
+if isfield(fgs,'strtree')
+    fgs=rmfield(fgs,'strtree');
+end
+if isfield(fgs,'lod')
+    fgs=rmfield(fgs,'lod');
+end
+if isfield(fgs,'ee')
+    fgs=rmfield(fgs,'ee');
+end
+if isfield(fgs,'nodeindex')
+    fgs=rmfield(fgs,'nodeindex');
+end
+
+fgs.perm=perm;
+fgs.eperm=eperm;
+t=toc;
+fprintf('Grid with %d nodes, %d elements reordered in %.1f secs\n',nn,ne,t);
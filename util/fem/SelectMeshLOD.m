@@ -0,0 +1,53 @@
+function [e,level]=SelectMeshLOD(fgs,axx,MaxElements)
+% Call as:  [e,level]=SelectMeshLOD(fgs,axx,MaxElements);
+%
+% Returns the elements to draw for the view axx=[xmin xmax ymin ymax]
+% from the level-of-detail hierarchy fgs.lod (see COMPUTEMESHLOD): the
+% elements of the tiles overlapping the view, on the finest level that
+% has no more than MaxElements of them.  Zoomed in far enough, this is
+% the grid itself (level 1) restricted to the view; zoomed out, a
+% coarser level of the whole grid.  If even the coarsest level has
+% more than MaxElements in view, it is used.  e is in grid node
+% numbers, so it is drawn against fgs.x,fgs.y and any nodal field.
+%
+% Without fgs.lod, or with MaxElements<=0, the whole grid is returned.
+
+if ~isfield(fgs,'lod') || ~isstruct(fgs.lod) || MaxElements<=0
+    e=fgs.e;
+    level=1;
+    return
+end
+
+lod=fgs.lod;
+nt=lod.ntiles^2;
+nlev=size(lod.levels,1);
+
+for level=1:nlev
+    tbox=lod.tbox((level-1)*nt+(1:nt),:);
+    vis=find(tbox(:,1)<=axx(2) & tbox(:,2)>=axx(1) & ...
+             tbox(:,3)<=axx(4) & tbox(:,4)>=axx(3));
+    ts=lod.tstart(vis,level);
+    te=lod.tstart(vis+1,level)-1;
+    if sum(te-ts+1)<=MaxElements || level==nlev
+        break
+    end
+end
+
+% concatenate the tile ranges ts(i):te(i)
+n=te-ts+1;
+vis=n>0;
+ts=ts(vis);
+n=n(vis);
+idx=ones(sum(n),1);
+if ~isempty(idx)
+    idx(1)=ts(1);
+    k=cumsum(n(1:end-1))+1;
+    idx(k)=ts(2:end)-(ts(1:end-1)+n(1:end-1)-1);
+    idx=cumsum(idx);
+end
+
+if level==1
+    e=fgs.e(lod.order(idx),:);
+else
+    e=double(lod.e(lod.levels(level,2)+idx,:));
+end
@@ -0,0 +1,33 @@
+function S=TileExtrema(fgs,q)
+% Call as:  S=TileExtrema(fgs,q);
+%
+% Per-tile summary of the nodal field q over the tile index
+% fgs.nodeindex (see COMPUTENODEINDEX), for EXTREMAINBOX.  S is
+% NTiles^2 x 4, [min max argmin argmax] of each tile, NaNs ignored;
+% the arg columns are the lowest-numbered node taking the extreme
+% value.  Tiles with no nodes, or only NaNs, are NaN.  It costs one
+% pass over q, and is computed once per displayed field.
+
+ni=fgs.nodeindex;
+nt=ni.ntiles^2;
+o=double(ni.order);
+v=q(o);
+v=v(:);
+% tile of each entry of order
+nz=find(diff(ni.tstart)>0);
+t=zeros(length(o),1);
+t(ni.tstart(nz))=1;
+t=nz(cumsum(t));
+
+mn=accumarray(t,v,[nt 1],@min,NaN);
+mx=accumarray(t,v,[nt 1],@max,NaN);
+S=[mn mx NaN(nt,2)];
+
+% within a tile order is by node number, so the first hit is the
+% lowest-numbered node
+hit=find(v==mn(t));
+[u,k]=unique(t(hit),'first');
+S(u,3)=o(hit(k));
+hit=find(v==mx(t));
+[u,k]=unique(t(hit),'first');
+S(u,4)=o(hit(k));
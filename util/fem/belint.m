@@ -36,31 +36,40 @@ x=fem_grid_struct.x;
 y=fem_grid_struct.y;
 
 
-% COMPUTE GLOBAL DX,DY
-%
-dx=[x(e(:,2))-x(e(:,3)) x(e(:,3))-x(e(:,1)) x(e(:,1))-x(e(:,2))];
-dy=[y(e(:,2))-y(e(:,3)) y(e(:,3))-y(e(:,1)) y(e(:,1))-y(e(:,2))];
+if exist('belintmex5','file')==3
+   % one pass over the elements, no ne-length temporaries; the 
+   % arrays are the same numbers as below
+   [AR,A,B,T]=belintmex5(double(x),double(y),double(e));
+   A0=T(:,1:2)/2;
+   dx=-A;
+   dy=B;
+else
+   % COMPUTE GLOBAL DX,DY
+   %
+   dx=[x(e(:,2))-x(e(:,3)) x(e(:,3))-x(e(:,1)) x(e(:,1))-x(e(:,2))];
+   dy=[y(e(:,2))-y(e(:,3)) y(e(:,3))-y(e(:,1)) y(e(:,1))-y(e(:,2))];
 
-% COMPUTE ELEMENTAL AREAS
-%
-AR=(x(e(:,1)).*dy(:,1)+x(e(:,2)).*dy(:,2)+x(e(:,3)).*dy(:,3))/2.;
+   % COMPUTE ELEMENTAL AREAS
+   %
+   AR=(x(e(:,1)).*dy(:,1)+x(e(:,2)).*dy(:,2)+x(e(:,3)).*dy(:,3))/2.;
 
-% COMPUTE ARRAYS FOR ELEMENT FINDING 
-%
-n1 = e(:,1);
-n2 = e(:,2);
-n3 = e(:,3);
-A(:,1)=x(n3)-x(n2);
-A(:,2)=x(n1)-x(n3);
-A(:,3)=x(n2)-x(n1);
-B(:,1)=y(n2)-y(n3);
-B(:,2)=y(n3)-y(n1);
-B(:,3)=y(n1)-y(n2);
-A0(:,1)=.5*(x(n2).*y(n3)-x(n3).*y(n2));
-A0(:,2)=.5*(x(n3).*y(n1)-x(n1).*y(n3));
-T(:,1)=A0(:,1)*2;
-T(:,2)=A0(:,2)*2;
-T(:,3)=2*AR-T(:,1)-T(:,2);
+   % COMPUTE ARRAYS FOR ELEMENT FINDING 
+   %
+   n1 = e(:,1);
+   n2 = e(:,2);
+   n3 = e(:,3);
+   A(:,1)=x(n3)-x(n2);
+   A(:,2)=x(n1)-x(n3);
+   A(:,3)=x(n2)-x(n1);
+   B(:,1)=y(n2)-y(n3);
+   B(:,2)=y(n3)-y(n1);
+   B(:,3)=y(n1)-y(n2);
+   A0(:,1)=.5*(x(n2).*y(n3)-x(n3).*y(n2));
+   A0(:,2)=.5*(x(n3).*y(n1)-x(n1).*y(n3));
+   T(:,1)=A0(:,1)*2;
+   T(:,2)=A0(:,2)*2;
+   T(:,3)=2*AR-T(:,1)-T(:,2);
+end
 
 %Create return structure and attach element areas to ret_struct
 %
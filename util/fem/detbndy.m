@@ -13,7 +13,10 @@ function bnd=DetBnd(in)
 %         The output boundary list are pairs of node numbers, not 
 %         coordinates, describing the edges of elements on the 
 %         exterior of the domain, including islands.  The segments 
-%         are not connected.
+%         are not connected, except when gridtopomex5 is available:
+%         then they are in the direction of their element's edge,
+%         head to tail around each boundary, found in one hashed
+%         pass over the edges without the nn x nn sparse matrix.
 %
 %         Call as: bnd=DetBnd(e);
 %
@@ -43,6 +46,12 @@ elseif ncol==4
    in=in(:,2:4);
 end
 
+if exist('gridtopomex5','file')==3
+   T=gridtopomex5(double(in));
+   bnd=double(T.bnd);
+   return
+end
+
 % Form (i,j) connection list from .ele element list
 %
 i=[in(:,1);in(:,2);in(:,3)];
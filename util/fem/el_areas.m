@@ -71,47 +71,55 @@ y=OldFemGridStruct.y;
 %     NewFemGridStruct.ycart=y-NewFemGridStruct.try0;
 % end
 
-% COMPUTE GLOBAL DX,DY, Len, angles
-%
-i1=e(:,1);
-i2=e(:,2);
-i3=e(:,3);
-
-x1=x(i1);x2=x(i2);x3=x(i3);
-y1=y(i1);y2=y(i2);y3=y(i3);
-
-% coordinate deltas
-%
-dx23=x2-x3;
-dx31=x3-x1;
-dx12=x1-x2;
-dy23=y2-y3;
-dy31=y3-y1;
-dy12=y1-y2;
-
-% lengths of sides
-%
-a = sqrt(dx12.*dx12 + dy12.*dy12);  
-b = sqrt(dx31.*dx31 + dy31.*dy31);
-c = sqrt(dx23.*dx23 + dy23.*dy23);  
-
-% angles
-%
 if isfield(NewFemGridStruct,'interiorangles')
    NewFemGridStruct=rmfield(NewFemGridStruct,'interiorangles');
 end
-NewFemGridStruct.interiorangles(:,1)=acos((b.^2 + c.^2 - a.^2)./(2*b.*c))*180/pi;
-NewFemGridStruct.interiorangles(:,2)=acos((a.^2 + c.^2 - b.^2)./(2*a.*c))*180/pi;
-NewFemGridStruct.interiorangles(:,3)=acos((a.^2 + b.^2 - c.^2)./(2*a.*b))*180/pi;
-
-% cuteness of elements
-%
-%NewFemGridStruct.acute = (a+c>b) & (c+b>a) & (b+a>c);
-NewFemGridStruct.acute = all(NewFemGridStruct.interiorangles'<90)';
 
-% COMPUTE ELEMENTAL AREAS
-%
-NewFemGridStruct.ar = ( x1.*dy23 + x2.*dy31 + x3.*dy12 )/2.;
+if exist('belintmex5','file')==3
+   % one pass over the elements, no ne-length temporaries; the 
+   % areas and angles are the same numbers as below
+   [NewFemGridStruct.ar,NewFemGridStruct.interiorangles]=belintmex5(double(x),double(y),double(e),1);
+   NewFemGridStruct.acute = all(NewFemGridStruct.interiorangles'<90)';
+else
+   % COMPUTE GLOBAL DX,DY, Len, angles
+   %
+   i1=e(:,1);
+   i2=e(:,2);
+   i3=e(:,3);
+
+   x1=x(i1);x2=x(i2);x3=x(i3);
+   y1=y(i1);y2=y(i2);y3=y(i3);
+
+   % coordinate deltas
+   %
+   dx23=x2-x3;
+   dx31=x3-x1;
+   dx12=x1-x2;
+   dy23=y2-y3;
+   dy31=y3-y1;
+   dy12=y1-y2;
+
+   % lengths of sides
+   %
+   a = sqrt(dx12.*dx12 + dy12.*dy12);  
+   b = sqrt(dx31.*dx31 + dy31.*dy31);
+   c = sqrt(dx23.*dx23 + dy23.*dy23);  
+
+   % angles
+   %
+   NewFemGridStruct.interiorangles(:,1)=acos((b.^2 + c.^2 - a.^2)./(2*b.*c))*180/pi;
+   NewFemGridStruct.interiorangles(:,2)=acos((a.^2 + c.^2 - b.^2)./(2*a.*c))*180/pi;
+   NewFemGridStruct.interiorangles(:,3)=acos((a.^2 + b.^2 - c.^2)./(2*a.*b))*180/pi;
+
+   % cuteness of elements
+   %
+   %NewFemGridStruct.acute = (a+c>b) & (c+b>a) & (b+a>c);
+   NewFemGridStruct.acute = all(NewFemGridStruct.interiorangles'<90)';
+
+   % COMPUTE ELEMENTAL AREAS
+   %
+   NewFemGridStruct.ar = ( x1.*dy23 + x2.*dy31 + x3.*dy12 )/2.;
+end
 
 % ANY NEGATIVE OR ZERO AREAS ?
 %
@@ -23,6 +23,18 @@ function j=findelem(fem_grid_struct,xorig,yorig,jorig)
 %   	  EL_AREAS is run as:
 %   		 [new_struct,ineg]=el_areas(fem_grid_struct);
 %
+%   If the fem_grid_struct has an element index attached in the
+%   field .elindex (see COMPUTEELEMENTINDEX), only the elements in
+%   each point's bucket are searched.
+%
+%   For a sequence of nearby points (a transect, track or profile),
+%   FINDELEM(fem_grid_struct,x,y,'walk') starts each point's search
+%   from the element of the point before it and walks across the
+%   element neighbors toward it, a few element tests per point.  The
+%   neighbors are the field .ee (see COMPUTEELEMENTNEIGHBORS), or are
+%   computed by GRIDTOPOMEX5 if it is not there.  A walk that leaves
+%   the grid falls back to the indexed or full search.
+%
 %   INPUT : fem_grid_struct - (from LOADGRID, see FEM_GRID_STRUCT)
 %   	      xylist	       - points to find elements for [n x 2 double]
 %           OR 
@@ -34,6 +46,7 @@ function j=findelem(fem_grid_struct,xorig,yorig,jorig)
 %   CALL : >> j=findelem(fem_grid_struct)   for interactive
 %     OR   >> j=findelem(fem_grid_struct,xylist)
 %     OR   >> j=findelem(fem_grid_struct,x,y)        
+%     OR   >> j=findelem(fem_grid_struct,x,y,'walk')
 %
 %   Written by : Brian O. Blanton 
 %   Summer 1997
@@ -43,6 +56,7 @@ function j=findelem(fem_grid_struct,xorig,yorig,jorig)
 
 j=[];
 Debug=false;
+walk=false;
 
 % VERIFY INCOMING STRUCTURE
 %
@@ -64,6 +78,17 @@ if nargin==2
    xp=xorig(:,1);
    yp=xorig(:,2);
    jsearch=[];
+elseif nargin==4 && ischar(jorig)
+   if ~strcmpi(jorig,'walk')
+      error('Unknown search mode %s to FINDELEM.',jorig)
+   end
+   if ~all(size(xorig) == size(yorig))
+      error('Size of x,y must be the same.')
+   end
+   xp=xorig(:);
+   yp=yorig(:);
+   jsearch=[];
+   walk=true;
 elseif nargin==4
    % assume 4th arg is jsearch.  
 
@@ -122,7 +147,37 @@ ytemp=yp(ifind);
 
 j=NaN*ones(size(xp));
 
-if isempty(jsearch)
+if walk
+   if isfield(fem_grid_struct,'ee') && ~isempty(fem_grid_struct.ee)
+      ee=fem_grid_struct.ee;
+   else
+      ee=ComputeElementNeighbors(fem_grid_struct);
+   end
+   walk=~isempty(ee);
+end
+if isfield(fem_grid_struct,'elindex')
+   elindex=fem_grid_struct.elindex;
+else
+   elindex=[];
+end
+
+if walk
+   if Debug, disp('Calling findelemex5 walking search...'),end
+   jtemp=findelemex5(xtemp,ytemp,fem_grid_struct.ar,...
+                     fem_grid_struct.A,...
+                     fem_grid_struct.B,...
+                     fem_grid_struct.T,...
+                     tolerance,...
+                     elindex,ee);
+elseif isempty(jsearch) && ~isempty(elindex)
+   if Debug, disp('Calling findelemex5 with element index...'),end
+   jtemp=findelemex5(xtemp,ytemp,fem_grid_struct.ar,...
+                     fem_grid_struct.A,...
+                     fem_grid_struct.B,...
+                     fem_grid_struct.T,...
+                     tolerance,...
+                     elindex);
+elseif isempty(jsearch)
    if Debug, disp('Calling findelemex5...'),end
    jtemp=findelemex5(xtemp,ytemp,fem_grid_struct.ar,...
                      fem_grid_struct.A,...
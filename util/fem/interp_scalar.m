@@ -4,7 +4,9 @@ function [outq,jj]=interp_scalar(fem_grid_struct,q,x,y,j)
 %   in the fem_grid_struct onto the scattered points (x,y).
 %
 %     INPUT : fem_grid_struct (from LOADGRID, see FEM_GRID_STRUCT)
-%   	      q - scalar field to interpolate
+%   	      q - scalar field to interpolate; may be an nn x nt block
+%   	          (e.g., all time levels), in which case outq is 
+%   	          length(x) x nt and the points are located once
 %   	      x,y - points to interpolate to (optional)
 %   	      j - elements that contain x,y points (optional)
 %
@@ -86,7 +88,15 @@ end
 % live in, if not passed in
 %
 tolerance=1.e-6;
-if isempty(j)
+if isempty(j) && isfield(fem_grid_struct,'elindex') && ~isempty(fem_grid_struct.elindex)
+   j=findelemex5(x(:),y(:),fem_grid_struct.ar,...
+                     fem_grid_struct.A,...
+                     fem_grid_struct.B,...
+                     fem_grid_struct.T,...
+                     tolerance,...
+                     fem_grid_struct.elindex);
+   j=reshape(j,size(x));
+elseif isempty(j)
    disp('Computing elements within interp_scalar.')
    j=findelemex5(x,y,fem_grid_struct.ar,...
                      fem_grid_struct.A,...
@@ -95,28 +105,39 @@ if isempty(j)
                      tolerance);
 end
 
-% Only operate on points within domain.
-idx=find(~isnan(j));
-jdx=j(idx);
-
-ARI=.5./AR(jdx);
-ARI=ARI(:);
-A03 = AR(jdx)-A0(jdx,1) - A0(jdx,2);
-
-q1 = q(e(jdx,1));
-q2 = q(e(jdx,2));
-q3 = q(e(jdx,3));
-
-e1 = ARI.* (B(jdx,1).*q1+B(jdx,2).*q2+B(jdx,3).*q3);
-e2 = ARI.* (A(jdx,1).*q1+A(jdx,2).*q2+A(jdx,3).*q3);
-e3 = 2*ARI.* (A0(jdx,1).*q1+A0(jdx,2).*q2+A03.*q3);
+if exist('interpmex5','file')==3 && isfield(fem_grid_struct,'T')
+   % locate once, then every column of q in one pass
+   [n,w]=interpmex5(double(e),AR,A,B,fem_grid_struct.T,x(:),y(:),j(:));
+   outq=interpmex5(n,w,double(q));
+   if size(q,2)==1
+      outq=reshape(outq,size(x));
+   end
+else
+   % Only operate on points within domain.
+   idx=find(~isnan(j));
+   jdx=j(idx);
+
+   ARI=.5./AR(jdx);
+   ARI=ARI(:);
+   A03 = AR(jdx)-A0(jdx,1) - A0(jdx,2);
+
+   if size(q,2)==1
+      outq=NaN*ones(size(x));
+   else
+      outq=NaN*ones(numel(x),size(q,2));
+   end
+   for k=1:size(q,2)
+      q1 = q(e(jdx,1),k);
+      q2 = q(e(jdx,2),k);
+      q3 = q(e(jdx,3),k);
 
-% 
-%x=x(:);y=y(:);
-      
-outq=NaN*ones(size(x));
+      e1 = ARI.* (B(jdx,1).*q1+B(jdx,2).*q2+B(jdx,3).*q3);
+      e2 = ARI.* (A(jdx,1).*q1+A(jdx,2).*q2+A(jdx,3).*q3);
+      e3 = 2*ARI.* (A0(jdx,1).*q1+A0(jdx,2).*q2+A03.*q3);
 
-outq(idx) = e1.*x(idx) + e2.*y(idx) + e3;
+      outq(idx+(k-1)*numel(x)) = e1.*x(idx) + e2.*y(idx) + e3;
+   end
+end
 
 if nargin==0
    [x y j q]
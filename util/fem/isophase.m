@@ -19,6 +19,7 @@ function chandle=isophase(fem_grid_struct,Q,cval,varargin)
 % Written by : Brian O. Blanton
 %     24 Oct 2002: Converted to fem_grid_struct input and varargin
 %     18 Feb 2010: Fixed bug in contouring "0"  phase
+%     Oct 2026: all phases extracted in one isopmex5 call
 %
 
 
@@ -79,22 +80,34 @@ Qmax=max(Q);
 Qmin=min(Q);
 cval=cval(:);
  
-for kk=1:length(cval)
-  
-% Call cmex function isopmex5
-
-    C=isopmex5(x,y,e,Q,cval(kk));
+% Call cmex function isopmex5 once for all phases; lev indexes cval
+% for each row of C.  Older isopmex5 binaries take one phase at a 
+% time.
+try
+    [C,lev]=isopmex5(x,y,e,Q,cval);
+catch
+    C=zeros(0,2);lev=zeros(0,1);
+    for kk=1:length(cval)
+        Ck=isopmex5(x,y,e,Q,cval(kk));
+        C=[C;Ck];
+        lev=[lev;kk*ones(size(Ck,1),1)];
+    end
+end
+nrow=accumarray(lev(:),1,[length(cval) 1]);
+last=cumsum(nrow);
 
-    if ~isempty(C)
-        chandle(kk)=line(C(:,1),C(:,2),varargin{:});
+for kk=1:length(cval)
+    if nrow(kk)>0
+        rows=last(kk)-nrow(kk)+1:last(kk);
+        chandle(kk)=line(C(rows,1),C(rows,2),varargin{:});
         set(chandle(kk),'UserData',cval(kk));
         set(chandle(kk),'Tag','contour');
-        drawnow
     else
         disp([num2str(cval(kk)) ' not found.']);
         chandle(kk)=0;
     end 
 end 
+drawnow
 
 return
 %
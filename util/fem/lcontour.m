@@ -28,6 +28,8 @@ function h=lcontour(fem_grid_struct,Q,cval,varargin)
 % 07 Mar, 2004: moved drawing of contours outside of computational
 %               loop to speed up rendering of graphics over slow
 %               net connections
+% Oct 2026: all contour values computed in one contmex5 call, and
+%           segments joined into polylines
 % 
 % 
 % 
@@ -69,24 +71,43 @@ Qmin=min(Q);
 cval=cval(:);
 h=zeros(size(cval));
 
-for kk=1:length(cval)
-%parfor (kk=1:length(cval))
-   if (cval(kk) > Qmax) || (cval(kk) < Qmin)
-      disp(sprintf('%s not within range of scalar field.  Min = %f  :  Max = %f',num2str(cval(kk)),Qmin,Qmax));
-      h(kk)=NaN;
-   else
+% contour values within the range of the scalar
+inrange=~((cval > Qmax) | (cval < Qmin));
+for kk=find(~inrange)'
+   disp(sprintf('%s not within range of scalar field.  Min = %f  :  Max = %f',num2str(cval(kk)),Qmin,Qmax));
+   h(kk)=NaN;
+end
+kin=find(inrange);
    
-% Call cmex function contmex5
+% Call cmex function contmex5 once for all levels, stitching the
+% segments into NaN-separated polylines; I(i,:)=[level npts closed] 
+% for line i, level indexing cval(kin).  Older contmex5 binaries 
+% take one level at a time and return unstitched segments, which 
+% are laid out here as 2-point lines.
 %
-%keyboard
-
-      C=contmex5(x,y,e,Q,cval(kk));
-      if(size(C,1)*size(C,2)~=1)
-              X = [ C(:,1) C(:,3) NaN*ones(size(C(:,1)))]';
-              Y = [ C(:,2) C(:,4) NaN*ones(size(C(:,1)))]';
-              XX{kk} = X(:);
-              YY{kk} = Y(:);
-              len(kk)=length(X(:));
+if ~isempty(kin)
+   try
+      [P,I]=contmex5(x,y,e,Q,cval(kin),1);
+   catch
+      P=zeros(0,2);I=zeros(0,3);
+      for k=1:length(kin)
+         C=contmex5(x,y,e,Q,cval(kin(k)));
+         if(size(C,1)*size(C,2)~=1)
+            n=size(C,1);
+            X = [ C(:,1) C(:,3) NaN*ones(n,1)]';
+            Y = [ C(:,2) C(:,4) NaN*ones(n,1)]';
+            P=[P;X(:) Y(:)];
+            I=[I;k*ones(n,1) 2*ones(n,1) zeros(n,1)];
+         end
+      end
+   end
+   nrow=accumarray(I(:,1),I(:,2)+1,[length(kin) 1]);
+   last=cumsum(nrow);
+   for k=1:length(kin)
+      kk=kin(k);
+      if nrow(k)>0
+         XX{kk} = P(last(k)-nrow(k)+1:last(k),1);
+         YY{kk} = P(last(k)-nrow(k)+1:last(k),2);
       else
          disp(['CVal ' num2str(cval(kk)) ' within range but still invalid.']);
          h(kk)=NaN;
@@ -21,9 +21,21 @@ function D=read_adcirc_fort(varargin)
 %                      or as a DATENUM Gregorian date. Default=[];
 %          Compact   - Expect (or not) compact ADCIRC file format (0|1)
 %          HeaderOnly - return after reading header information   
+%          IndexOnly - return only the record offsets (D.offsets) of
+%                      all time steps, without reading any data
 %          IterStart - time step in fort file to start recording 
 %          IterEnd   - time step in fort file to stop recording
 %          Level     - sigma-level to extract from a 3-d file
+%          Offsets   - record offsets (D.offsets) from an earlier read
+%                      of FileName.  The time steps to read are seeked
+%                      to directly, instead of scanning the file up to
+%                      them.  Offsets found by a read are kept for the 
+%                      rest of the session and used for later reads of
+%                      the same (unchanged) file, so this is only needed
+%                      to reuse offsets saved from another session.
+%          ProgressFcn - function handle called with a status string
+%                      as the data are read (e.g., @SetUIStatusMessage).
+%                      Default=[];
 %          Stride    - number of step between saving output
 %          Strip     - number of steps to skip at beginning of file
 %          Verbose   - Verbose (or not) diagnostic output (0|1)
@@ -31,10 +43,19 @@ function D=read_adcirc_fort(varargin)
 % Output : The details of the output struct depend on the unit number. 
 %          The return structure for a fort.61 or fort.63 file is :
 %
-%          D.data  - matrix of data, one node per row
-%          D.t     - vector of times
-%          D.nodes - number of nodes
-%          D.dt    - output interval in fort.XX file
+%          D.zeta    - matrix of data, one node per row, one column
+%                      per time step read
+%          D.time    - vector of times (secs)
+%          D.iter    - vector of model time steps
+%          D.nodes   - number of nodes
+%          D.dt      - output interval in fort.XX file
+%          D.offsets - byte offsets in the file of time steps 
+%                      1..IterEnd
+%
+%          Vector units (62,64,72,74) return D.u,D.v instead of D.zeta, 
+%          and units 71,73 return D.pres.  The file is read by the
+%          streaming parsers READ_ADCIRC_FORT_MEX and 
+%          READ_ADCIRC_FORT_COMPACT_MEX (in util/mex).
 %
 % Call as: D=read_adcirc_fort('FileName',<filename>,...
 %                             'FortUnit',<fortunit>,...);
@@ -55,9 +76,12 @@ Compact=[];
 FileName='maxele.63';
 FortUnit=[];
 HeaderOnly=0;
+IndexOnly=0;
 IterStart=1;
 IterEnd=NaN;
 Level=-1;
+Offsets=[];
+ProgressFcn=[];
 Stride=1;
 Strip=0;
 Verbose=0;
@@ -92,6 +116,18 @@ else
         case 'headeronly',
           HeaderOnly=varargin{k+1};
           varargin([k k+1])=[];
+        case 'indexonly',
+          IndexOnly=varargin{k+1};
+          varargin([k k+1])=[];
+        case 'offsets',
+          Offsets=varargin{k+1};
+          varargin([k k+1])=[];
+        case 'progressfcn',
+          ProgressFcn=varargin{k+1};
+          if ~isempty(ProgressFcn) && ~isa(ProgressFcn,'function_handle')
+             error('ProgressFcn to READ_ADCIRC_FORT must be a function handle. Terminal.')
+          end
+          varargin([k k+1])=[];
         case 'iterstart',
           IterStart=varargin{k+1};
           varargin([k k+1])=[];
@@ -240,16 +276,47 @@ end
 
 fclose(fid);
 
+% record offsets are kept per file, keyed by its size and date, so that
+% a later read of the same file seeks to its time steps
+persistent OffsetCache
+if isempty(OffsetCache)
+   OffsetCache=containers.Map;
+end
+finfo=dir(FileName);
+if FileName(1)=='/' || any(FileName==':')
+   key=FileName;
+else
+   key=fullfile(pwd,FileName);
+end
+key=sprintf('%s|%d|%f',key,finfo.bytes,finfo.datenum);
+
+if IndexOnly
+   % no time steps to read; offsets of all of them
+   IterStart=NDSETS+1;
+   IterEnd=NDSETS;
+end
+
+% cached offsets from a read that stopped short of IterEnd are not
+% used; this read scans the file and caches the longer offsets
+if isempty(Offsets) && isKey(OffsetCache,key) && ...
+      length(OffsetCache(key))>=IterEnd
+   Offsets=OffsetCache(key);
+end
+
 if Compact==0
    if Verbose
       disp('calling ADCIRC output file reader ...')
    end
-   D=read_adcirc_fort_mex(FileName,str2num(FortUnit),Verbose,Stride,Strip,IterStart,IterEnd,Level);
+   D=read_adcirc_fort_mex(FileName,str2num(FortUnit),Verbose,Stride,Strip,IterStart,IterEnd,Level,Offsets,ProgressFcn);
 else
    if Verbose
       disp('calling compact ADCIRC  output file reader ...')
    end
-   D=read_adcirc_fort_compact_mex(FileName,str2num(FortUnit),Verbose,Stride,Strip,IterStart,IterEnd);
+   D=read_adcirc_fort_compact_mex(FileName,str2num(FortUnit),Verbose,Stride,Strip,IterStart,IterEnd,Offsets,ProgressFcn);
+end
+
+if length(D.offsets)>length(Offsets)
+   OffsetCache(key)=D.offsets;
 end
 
 D.NSTEP=NSTEP;
@@ -175,13 +175,14 @@ G=NaN*ones(nnodes,ncomps);
 if ~skipdataread
 
     disp('Scanning nodes ... ')
-    for i=1:nnodes
-        if (mod(i,10000)==1),disp(int2str(i)),end
-        n=fscanf(fid,'%d',1);
-        temp=fscanf(fid,'%e %f',[2 NcompsInFile])';
-        A(i,:)=temp(idx,1);
-        G(i,:)=temp(idx,2);
+    % one read of the whole table, one node per column: the node
+    % number, then the amplitude and phase of each constituent
+    temp=fscanf(fid,'%f',[1+2*NcompsInFile nnodes]);
+    if size(temp,2)<nnodes
+        error('%s ends after %d of %d nodes.',fname,size(temp,2),nnodes)
     end
+    A=temp(2*idx,:)';
+    G=temp(2*idx+1,:)';
     
     % if flag==1,output constituents into .s2c files
     if flag
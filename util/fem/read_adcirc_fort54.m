@@ -96,16 +96,18 @@ UG=NaN*ones(nnodes,ncomp);
 VA=NaN*ones(nnodes,ncomp);
 VG=NaN*ones(nnodes,ncomp);
 
-for i=1:nnodes
-   n=fscanf(fid,'%d',1);
-   for j=1:ncomp
-      temp=fscanf(fid,'%f %f %f %f',[1 4]);
-      UA(n,j)=temp(1);
-      UG(n,j)=temp(2);
-      VA(n,j)=temp(3);
-      VG(n,j)=temp(4);
-   end
+% one read of the whole table, one node per column: the node number,
+% then UA,UG,VA,VG of each constituent
+temp=fscanf(fid,'%f',[1+4*ncomp nnodes]);
+if size(temp,2)<nnodes
+   error('%s ends after %d of %d nodes.',fname,size(temp,2),nnodes)
 end
+n=temp(1,:);
+UA(n,:)=temp(4*(1:ncomp)-2,:)';
+UG(n,:)=temp(4*(1:ncomp)-1,:)';
+VA(n,:)=temp(4*(1:ncomp),:)';
+VG(n,:)=temp(4*(1:ncomp)+1,:)';
+clear temp
 
 % if flag==1,output comstituents into .v2c files
 if flag
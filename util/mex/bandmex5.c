@@ -0,0 +1,515 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "mex.h"
+#include "opnml_mex5_allocs.c"
+#include "opnml_mex5_hash.c"
+
+/* ---- band pieces, grown as they are found; the vertices of piece
+        i are pv[ps[i]..ps[i+1]-1], counterclockwise, and pb[i] its
+        0-based band ------------------------------------------------ */
+typedef struct {
+   int *pv;
+   int *ps;
+   int *pb;
+   int  npv,maxpv;
+   int  np,maxp;
+} piecelist;
+
+/* ---- band vertices: a mesh node, or the crossing of a mesh edge
+        by a band edge value, keyed as for contmex5 so that the two
+        elements sharing an edge share its crossings -------------- */
+typedef struct {
+   double *x;
+   double *y;
+   int     nv,maxv;
+   mxI64Hash h;
+} vertlist;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* PROTOTYPES */
+void clipelems(int,int,double *,double *,int *,double *,int,double *,
+               vertlist *,piecelist *);
+int  vertex(vertlist *,int,int,int,int,double *,double *,double *,double *,int);
+void addpiece(piecelist *,int *,int,int);
+void rings(vertlist *,piecelist *,int,double **,double **,int **,int *);
+
+/************************************************************
+
+  ####     ##     #####  ######  #    #    ##     #   #
+ #    #   #  #      #    #       #    #   #  #     # #
+ #       #    #     #    #####   #    #  #    #     #
+ #  ###  ######     #    #       # ## #  ######     #
+ #    #  #    #     #    #       ##  ##  #    #     #
+  ####   #    #     #    ######  #    #  #    #     #
+
+************************************************************/
+
+void mexFunction(int            nlhs,
+                 mxArray       *plhs[],
+		 int            nrhs,
+		 const mxArray *prhs[])
+{
+
+/* ---- bandmex5 will be called as :
+        [P,info]=bandmex5(x,y,ele,q,edges);
+
+        Filled contours of the nodal scalar q between the ascending
+        values edges(1..nb+1), as polygons per band.  Each element is
+        clipped against all the bands it spans in one pass, and the
+        pieces of a band are merged through the edges they share, so
+        what is left is the band's outline.  Elements with a NaN
+        node are left out.  Band k is edges(k)<=q<edges(k+1), except
+        that the last band includes edges(nb+1).
+
+        P is a 2-column [x y] list of closed rings (first point
+        repeated), each followed by a row of NaNs, ordered by band.
+        Outer rings are clockwise and holes counterclockwise, as in
+        the ESRI shapefile polygon type, so the rings of a band are
+        the parts of one shapefile polygon.  info has one row
+        [band npts hole] per ring, npts including the repeated
+        point.  ----------------------------------------------------- */
+
+   int i,j,k,nn,ne,nb,nr,npt,*ele,*rinfo;
+   double *x,*y,*q,*dele,*edges,*rx,*ry,*P,*info;
+   vertlist verts;
+   piecelist pcs;
+
+/* ---- check I/O arguments ----------------------------------------- */
+   if (nrhs != 5)
+      mexErrMsgTxt("bandmex5 requires 5 input arguments.");
+   else if (nlhs > 2)
+      mexErrMsgTxt("bandmex5 requires 1 or 2 output arguments.");
+
+/* ---- dereference input arrays ------------------------------------ */
+   x=mxGetPr(prhs[0]);
+   y=mxGetPr(prhs[1]);
+   dele=mxGetPr(prhs[2]);
+   q=mxGetPr(prhs[3]);
+   edges=mxGetPr(prhs[4]);
+   nn=mxGetM(prhs[0])*mxGetN(prhs[0]);
+   ne=mxGetM(prhs[2]);
+   nb=mxGetNumberOfElements(prhs[4])-1;
+   if (mxGetN(prhs[2]) != 3)
+      mexErrMsgTxt("Element list to bandmex5 must be ne x 3.");
+   if (mxGetM(prhs[3])*mxGetN(prhs[3]) != (mwSize)nn)
+      mexErrMsgTxt("q to bandmex5 must be the same length as x.");
+   if (nb<1)
+      mexErrMsgTxt("bandmex5 requires at least 2 band edges.");
+   for (k=0;k<nb;k++)
+      if (!(edges[k]<edges[k+1]))
+         mexErrMsgTxt("Band edges to bandmex5 must be increasing.");
+
+   ele=(int *)mxIvector(0,3*ne);
+   for (i=0;i<3*ne;i++){
+      ele[i]=((int)dele[i])-1;
+      if (ele[i]<0 || ele[i]>=nn)
+         mexErrMsgTxt("Element list references nodes not in x,y.");
+   }
+
+/* ---- start the lists at about one piece per element; they grow
+        as needed -------------------------------------------------- */
+   verts.maxv=nn+1024;
+   verts.nv=0;
+   verts.x=(double *)mxCalloc(verts.maxv,sizeof(double));
+   verts.y=(double *)mxCalloc(verts.maxv,sizeof(double));
+   mxI64HashInit(&verts.h,2*(size_t)nn+1024);
+   pcs.maxp=ne+1024;
+   pcs.maxpv=4*pcs.maxp;
+   pcs.np=pcs.npv=0;
+   pcs.pv=(int *)mxCalloc(pcs.maxpv,sizeof(int));
+   pcs.ps=(int *)mxCalloc(pcs.maxp+1,sizeof(int));
+   pcs.pb=(int *)mxCalloc(pcs.maxp,sizeof(int));
+
+   clipelems(ne,nn,x,y,ele,q,nb,edges,&verts,&pcs);
+   rings(&verts,&pcs,nb,&rx,&ry,&rinfo,&nr);
+
+/* ---- lay out the rings, reversed to the shapefile orientation ---- */
+   npt=0;
+   for (k=0;k<nr;k++)
+      npt+=rinfo[3*k+1]+1;
+   P=(double *)mxDvector(0,2*npt);
+   info=(double *)mxDvector(0,3*nr);
+   j=0;
+   for (k=0,i=0;k<nr;k++){
+      int n=rinfo[3*k+1],m;
+      for (m=n-1;m>=0;m--,j++){
+         P[j]=rx[i+m];
+         P[npt+j]=ry[i+m];
+      }
+      P[j]=P[npt+j]=mxGetNaN();
+      j++;
+      i+=n;
+      info[k]=(double)(rinfo[3*k]+1);
+      info[nr+k]=(double)n;
+      info[2*nr+k]=(double)rinfo[3*k+2];
+   }
+
+   plhs[0]=mxCreateDoubleMatrix(npt,2,mxREAL);
+   mxFree(mxGetPr(plhs[0]));
+   mxSetPr(plhs[0],P);
+   if (nlhs>1){
+      plhs[1]=mxCreateDoubleMatrix(nr,3,mxREAL);
+      mxFree(mxGetPr(plhs[1]));
+      mxSetPr(plhs[1],info);
+   }
+
+/* ---- No need to free memory allocated with "mxCalloc"; MATLAB
+   does this automatically.  The CMEX allocation functions in
+   "opnml_allocs.c" use mxCalloc. ----------------------------------- */
+   return;
+}
+
+/*----------------------------------------------------------------------
+
+   ####   #          #    #####   #####
+  #    #  #          #    #    #  #    #
+  #       #          #    #    #  #    #
+  #       #          #    #####   #####
+  #    #  #          #    #       #
+   ####   ######     #    #       #
+
+----------------------------------------------------------------------*/
+
+/* ---- the piece of an element in band b is where edges[b] <= q <=
+        edges[b+1], a convex polygon since q is linear.  Its
+        boundary is found by walking the element's sides
+        counterclockwise, keeping the nodes within the band and the
+        crossings of the band edges in the order met.  Pieces with
+        fewer than 3 vertices have no area.  An element flat at a
+        band edge value is given to the band above it. ------------ */
+#ifdef __STDC__
+   void clipelems(int ne,int nn,double *x,double *y,int *ele,double *q,
+                  int nb,double *edges,vertlist *verts,piecelist *pcs)
+#else
+   void clipelems(ne,nn,x,y,ele,q,nb,edges,verts,pcs)
+   int ne,nn,*ele,nb;
+   double *x,*y,*q,*edges;
+   vertlist *verts;
+   piecelist *pcs;
+#endif
+#define ELE(i,j,m) ele[i+m*j]
+{
+   int l,k,b,b0,b1,lo,hi,mid,m,na,nb2,n[3],pv[8],npv,flat;
+   double qa,qb,qmin,qmax,blo,bhi,area;
+
+   for (l=0;l<ne;l++){
+      n[0]=ELE(l,0,ne);
+      n[1]=ELE(l,1,ne);
+      n[2]=ELE(l,2,ne);
+      if (q[n[0]]!=q[n[0]] || q[n[1]]!=q[n[1]] || q[n[2]]!=q[n[2]])
+         continue;
+      area=(x[n[1]]-x[n[0]])*(y[n[2]]-y[n[0]])-(x[n[2]]-x[n[0]])*(y[n[1]]-y[n[0]]);
+      if (area<0.){            /* walk clockwise elements backward */
+         m=n[1];n[1]=n[2];n[2]=m;
+      }
+      qmin=qmax=q[n[0]];
+      for (k=1;k<3;k++){
+         if (q[n[k]]<qmin) qmin=q[n[k]];
+         if (q[n[k]]>qmax) qmax=q[n[k]];
+      }
+      if (qmax<edges[0] || qmin>edges[nb]) continue;
+
+      /* first band with edges[b+1]>=qmin, last with edges[b]<=qmax */
+      lo=0;hi=nb;
+      while (lo<hi){
+         mid=(lo+hi)/2;
+         if (edges[mid+1]<qmin) lo=mid+1;
+         else hi=mid;
+      }
+      b0=lo;
+      lo=b0;hi=nb;
+      while (lo<hi){
+         mid=(lo+hi)/2;
+         if (edges[mid]<=qmax) lo=mid+1;
+         else hi=mid;
+      }
+      b1=lo;
+
+      for (b=b0;b<b1;b++){
+         blo=edges[b];
+         bhi=edges[b+1];
+         npv=0;
+         flat=1;
+         for (k=0;k<3;k++){
+            na=n[k];
+            nb2=n[(k+1)%3];
+            qa=q[na];
+            qb=q[nb2];
+            if (qa>=blo && qa<=bhi){
+               pv[npv++]=vertex(verts,nn,nb,na,na,x,y,q,edges,0);
+               if (qa!=bhi) flat=0;
+            }
+            else
+               flat=0;
+            if (qa<qb){
+               if ((blo-qa)*(blo-qb)<0.)
+                  pv[npv++]=vertex(verts,nn,nb,na,nb2,x,y,q,edges,b);
+               if ((bhi-qa)*(bhi-qb)<0.)
+                  pv[npv++]=vertex(verts,nn,nb,na,nb2,x,y,q,edges,b+1);
+            }
+            else if (qa>qb){
+               if ((bhi-qa)*(bhi-qb)<0.)
+                  pv[npv++]=vertex(verts,nn,nb,na,nb2,x,y,q,edges,b+1);
+               if ((blo-qa)*(blo-qb)<0.)
+                  pv[npv++]=vertex(verts,nn,nb,na,nb2,x,y,q,edges,b);
+            }
+         }
+         if (npv<3) continue;
+         if (flat && b<nb-1) continue;
+         addpiece(pcs,pv,npv,b);
+      }
+   }
+}
+
+/* ---- vertex id for node na (na==nb2), or for the crossing of side
+        na-nb2 by edges[lev]; coordinates are computed from the side
+        in node-number order, so both elements on a side agree ----- */
+#ifdef __STDC__
+   int vertex(vertlist *verts,int nn,int nb,int na,int nb2,
+              double *x,double *y,double *q,double *edges,int lev)
+#else
+   int vertex(verts,nn,nb,na,nb2,x,y,q,edges,lev)
+   vertlist *verts;
+   int nn,nb,na,nb2,lev;
+   double *x,*y,*q,*edges;
+#endif
+{
+   int a,b,v;
+   long long key;
+   double fac;
+
+   if (na==nb2)
+      key=na;
+   else {
+      a=na<nb2?na:nb2;
+      b=na<nb2?nb2:na;
+      key=nn+((long long)a*nn+b)*(nb+1)+lev;
+   }
+   v=mxI64HashInsert(&verts->h,key,verts->nv);
+   if (v<verts->nv) return v;
+
+   if (verts->nv==verts->maxv){
+      verts->maxv*=2;
+      verts->x=(double *)mxRealloc(verts->x,verts->maxv*sizeof(double));
+      verts->y=(double *)mxRealloc(verts->y,verts->maxv*sizeof(double));
+   }
+   if (2*(verts->h.cnt+1)>verts->h.mask+1){
+      /* rehash into a table twice the size */
+      mxI64Hash h2;
+      size_t i;
+      mxI64HashInit(&h2,verts->h.mask+1);
+      for (i=0;i<=verts->h.mask;i++)
+         if (verts->h.key[i]!=-1)
+            mxI64HashInsert(&h2,verts->h.key[i],verts->h.val[i]);
+      mxFree(verts->h.key);
+      mxFree(verts->h.val);
+      verts->h=h2;
+   }
+   if (na==nb2){
+      verts->x[v]=x[na];
+      verts->y[v]=y[na];
+   }
+   else {
+      fac=(edges[lev]-q[a])/(q[b]-q[a]);
+      verts->x[v]=x[a]+(x[b]-x[a])*fac;
+      verts->y[v]=y[a]+(y[b]-y[a])*fac;
+   }
+   verts->nv++;
+   return v;
+}
+
+/* ---- append one piece, doubling the lists when they fill -------- */
+#ifdef __STDC__
+   void addpiece(piecelist *pcs,int *pv,int npv,int b)
+#else
+   void addpiece(pcs,pv,npv,b)
+   piecelist *pcs;
+   int *pv,npv,b;
+#endif
+{
+   int k;
+   if (pcs->np==pcs->maxp){
+      pcs->maxp*=2;
+      pcs->ps=(int *)mxRealloc(pcs->ps,(pcs->maxp+1)*sizeof(int));
+      pcs->pb=(int *)mxRealloc(pcs->pb,pcs->maxp*sizeof(int));
+   }
+   if (pcs->npv+npv>pcs->maxpv){
+      pcs->maxpv*=2;
+      pcs->pv=(int *)mxRealloc(pcs->pv,pcs->maxpv*sizeof(int));
+   }
+   pcs->ps[pcs->np]=pcs->npv;
+   for (k=0;k<npv;k++)
+      pcs->pv[pcs->npv++]=pv[k];
+   pcs->pb[pcs->np++]=b;
+   pcs->ps[pcs->np]=pcs->npv;
+}
+
+/*----------------------------------------------------------------------
+
+  #####      #    #    #   ####    ####
+  #    #     #    ##   #  #    #  #
+  #    #     #    # #  #  #        ####
+  #####      #    #  # #  #  ###       #
+  #   #      #    #   ##  #    #  #    #
+  #    #     #    #    #   ####    ####
+
+----------------------------------------------------------------------*/
+
+/* ---- merge the pieces of each band into its outline.  A side
+        shared by two pieces of a band is interior; the sides used
+        once are the outline, directed with the band on their left.
+        At a vertex where the outline touches itself, a ring turns
+        into the first outgoing side clockwise from the side it came
+        in on, so rings never cross.  Rings are returned in traced
+        (counterclockwise outer) order in rx,ry; rinfo has [band
+        npts hole] per ring, npts including the closing point. ---- */
+#ifdef __STDC__
+   void rings(vertlist *verts,piecelist *pcs,int nb,
+              double **rxp,double **ryp,int **rinfop,int *nrp)
+#else
+   void rings(verts,pcs,nb,rxp,ryp,rinfop,nrp)
+   vertlist *verts;
+   piecelist *pcs;
+   int nb,**rinfop,*nrp;
+   double **rxp,**ryp;
+#endif
+{
+   int nv=verts->nv,i,j,k,b,e,e0,en,v,va,vb,n,ns,nr=0,npt=0,maxr,maxpt;
+   int *start,*ord,*ea,*eb,*ecnt,*os,*oadj,*used,*rinfo;
+   long long key;
+   double *vx=verts->x,*vy=verts->y,*rx,*ry;
+   double ain,a,best,da,area;
+   mxI64Hash he;
+
+/* ---- pieces grouped by band (counting sort, keeps element order) */
+   start=(int *)mxIvector(0,nb+1);
+   ord=(int *)mxIvector(0,pcs->np);
+   for (i=0;i<pcs->np;i++)
+      start[pcs->pb[i]+1]++;
+   for (b=0;b<nb;b++)
+      start[b+1]+=start[b];
+   for (i=0;i<pcs->np;i++)
+      ord[start[pcs->pb[i]]++]=i;
+   for (b=nb;b>0;b--)
+      start[b]=start[b-1];
+   start[0]=0;
+
+   ea=(int *)mxIvector(0,pcs->npv);
+   eb=(int *)mxIvector(0,pcs->npv);
+   ecnt=(int *)mxIvector(0,pcs->npv);
+   os=(int *)mxIvector(0,nv+1);
+   oadj=(int *)mxIvector(0,pcs->npv);
+   used=(int *)mxIvector(0,pcs->npv);
+   maxr=1024;
+   maxpt=pcs->npv+1024;
+   rinfo=(int *)mxCalloc(3*maxr,sizeof(int));
+   rx=(double *)mxCalloc(maxpt,sizeof(double));
+   ry=(double *)mxCalloc(maxpt,sizeof(double));
+
+   for (b=0;b<nb;b++){
+      if (start[b+1]==start[b]) continue;
+
+/* ---- distinct sides of the band's pieces, with use counts ------- */
+      n=0;
+      for (k=start[b];k<start[b+1];k++)
+         n+=pcs->ps[ord[k]+1]-pcs->ps[ord[k]];
+      mxI64HashInit(&he,n);
+      ns=0;
+      for (k=start[b];k<start[b+1];k++){
+         i=ord[k];
+         for (j=pcs->ps[i];j<pcs->ps[i+1];j++){
+            va=pcs->pv[j];
+            vb=pcs->pv[j+1<pcs->ps[i+1]?j+1:pcs->ps[i]];
+            if (va==vb) continue;
+            key=va<vb?(long long)va*nv+vb:(long long)vb*nv+va;
+            e=mxI64HashInsert(&he,key,ns);
+            if (e==ns){
+               ea[ns]=va;
+               eb[ns]=vb;
+               ecnt[ns]=0;
+               ns++;
+            }
+            ecnt[e]++;
+         }
+      }
+      mxFree(he.key);
+      mxFree(he.val);
+
+/* ---- outgoing outline sides of each vertex, CSR style ----------- */
+      for (e=0;e<ns;e++)
+         if (ecnt[e]==1) os[ea[e]+1]++;
+      for (v=0;v<nv;v++)
+         os[v+1]+=os[v];
+      for (e=0;e<ns;e++){
+         used[e]=0;
+         if (ecnt[e]==1) oadj[os[ea[e]]++]=e;
+      }
+      for (v=nv;v>0;v--)
+         os[v]=os[v-1];
+      os[0]=0;
+
+/* ---- trace the rings -------------------------------------------- */
+      for (e0=0;e0<ns;e0++){
+         if (ecnt[e0]!=1 || used[e0]) continue;
+         if (nr==maxr){
+            maxr*=2;
+            rinfo=(int *)mxRealloc(rinfo,3*maxr*sizeof(int));
+         }
+         n=0;
+         area=0.;
+         e=e0;
+         while (1){
+            used[e]=1;
+            if (npt+n+1>=maxpt){
+               maxpt*=2;
+               rx=(double *)mxRealloc(rx,maxpt*sizeof(double));
+               ry=(double *)mxRealloc(ry,maxpt*sizeof(double));
+            }
+            rx[npt+n]=vx[ea[e]];
+            ry[npt+n]=vy[ea[e]];
+            n++;
+            area+=vx[ea[e]]*vy[eb[e]]-vx[eb[e]]*vy[ea[e]];
+            v=eb[e];
+            /* next side: first clockwise from the reverse of e */
+            en=-1;
+            if (os[v+1]-os[v]==1)
+               en=oadj[os[v]];
+            else {
+               ain=atan2(vy[ea[e]]-vy[v],vx[ea[e]]-vx[v]);
+               best=10.;
+               for (j=os[v];j<os[v+1];j++){
+                  a=atan2(vy[eb[oadj[j]]]-vy[v],vx[eb[oadj[j]]]-vx[v]);
+                  da=ain-a;
+                  while (da<=0.) da+=2*M_PI;
+                  while (da>2*M_PI) da-=2*M_PI;
+                  if (da<best){
+                     best=da;
+                     en=oadj[j];
+                  }
+               }
+            }
+            if (en==e0) break;
+            if (en<0 || used[en]) break;  /* open outline; shouldn't happen */
+            e=en;
+         }
+         rx[npt+n]=rx[npt];             /* close the ring */
+         ry[npt+n]=ry[npt];
+         n++;
+         rinfo[3*nr]=b;
+         rinfo[3*nr+1]=n;
+         rinfo[3*nr+2]=area<0.;
+         npt+=n;
+         nr++;
+      }
+      for (v=0;v<=nv;v++)
+         os[v]=0;
+   }
+   *rxp=rx;
+   *ryp=ry;
+   *rinfop=rinfo;
+   *nrp=nr;
+}
@@ -0,0 +1,165 @@
+#include <math.h>
+#include <stdio.h>
+#include "mex.h"
+#include "opnml_mex5_allocs.c"
+
+#define ELE(i,j,m) ele[i+m*j]
+#define AA(i,j,m) A[i+m*j]
+#define BB(i,j,m) B[i+m*j]
+#define TT(i,j,m) T[i+m*j]
+#define ANG(i,j,m) ang[i+m*j]
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* PROTOTYPES */
+mxArray *wrap(double *,int,int);
+
+/************************************************************
+
+  ####     ##     #####  ######  #    #    ##     #   #
+ #    #   #  #      #    #       #    #   #  #     # #
+ #       #    #     #    #####   #    #  #    #     #
+ #  ###  ######     #    #       # ## #  ######     #
+ #    #  #    #     #    #       ##  ##  #    #     #
+  ####   #    #     #    ######  #    #  #    #     #
+
+************************************************************/
+
+void mexFunction(int            nlhs,
+                 mxArray       *plhs[],
+		 int            nrhs,
+		 const mxArray *prhs[])
+{
+
+/* ---- belintmex5 will be called as :
+        [ar,A,B,T]=belintmex5(x,y,ele);    (BELINT)
+        [ar,ang]=belintmex5(x,y,ele,1);    (EL_AREAS)
+
+        ar is the ne x 1 element areas, A,B,T the ne x 3 element
+        finding arrays of BELINT, and ang the ne x 3 interior angles
+        (deg) of EL_AREAS, each computed with the same arithmetic as
+        the m-files so the results are the same numbers, provided
+        a*b+c is not contracted into a fused multiply-add (makemex 
+        builds this file with -ffp-contract=off).  The other
+        BELINT fields are A0=T(:,1:2)/2, dx=-A and dy=B.
+
+        Each element is computed in one pass over its three nodes,
+        with no ne-length temporaries, and elements are split over
+        the available cores when compiled with OpenMP (see makemex).
+        ------------------------------------------------------------ */
+
+   int i,k,n1,n2,n3,nn,ne,doang;
+   double *x,*y,*ele,*ar,*A,*B,*T,*ang;
+   double x1,x2,x3,y1,y2,y3,dy23,dy31,dy12,dx23,dx31,dx12,a,b,c;
+
+/* ---- check I/O arguments ----------------------------------------- */
+   if (nrhs != 3 && nrhs != 4)
+      mexErrMsgTxt("belintmex5 requires 3 or 4 input arguments.");
+   doang=(nrhs==4 && mxGetScalar(prhs[3])!=0.);
+   if (doang && nlhs != 2)
+      mexErrMsgTxt("belintmex5(x,y,ele,1) requires 2 output arguments.");
+   else if (!doang && nlhs != 4)
+      mexErrMsgTxt("belintmex5 requires 4 output arguments.");
+
+/* ---- dereference input arrays ------------------------------------ */
+   x=mxGetPr(prhs[0]);
+   y=mxGetPr(prhs[1]);
+   ele=mxGetPr(prhs[2]);
+   nn=mxGetM(prhs[0])*mxGetN(prhs[0]);
+   ne=mxGetM(prhs[2]);
+   if (mxGetN(prhs[2]) != 3)
+      mexErrMsgTxt("Element list to belintmex5 must be ne x 3.");
+   if (mxGetM(prhs[1])*mxGetN(prhs[1]) != (mwSize)nn)
+      mexErrMsgTxt("x and y to belintmex5 must be the same length.");
+
+/* ---- node numbers are checked before the parallel loop, which
+        cannot raise MATLAB errors ---------------------------------- */
+   for (i=0;i<3*ne;i++)
+      if (!(ele[i]>=1. && ele[i]<=(double)nn))
+         mexErrMsgTxt("Element list references nodes not in x,y.");
+
+   ar=(double *)mxDvector(0,ne);
+   A=B=T=ang=NULL;
+   if (doang)
+      ang=(double *)mxDvector(0,3*ne);
+   else{
+      A=(double *)mxDvector(0,3*ne);
+      B=(double *)mxDvector(0,3*ne);
+      T=(double *)mxDvector(0,3*ne);
+   }
+
+#pragma omp parallel for private(n1,n2,n3,x1,x2,x3,y1,y2,y3,dy23,dy31,dy12,dx23,dx31,dx12,a,b,c)
+   for (k=0;k<ne;k++){
+      n1=(int)ELE(k,0,ne)-1;
+      n2=(int)ELE(k,1,ne)-1;
+      n3=(int)ELE(k,2,ne)-1;
+      x1=x[n1];x2=x[n2];x3=x[n3];
+      y1=y[n1];y2=y[n2];y3=y[n3];
+      dy23=y2-y3;
+      dy31=y3-y1;
+      dy12=y1-y2;
+      ar[k]=(x1*dy23+x2*dy31+x3*dy12)/2.;
+      if (doang){
+         dx23=x2-x3;
+         dx31=x3-x1;
+         dx12=x1-x2;
+         a=sqrt(dx12*dx12+dy12*dy12);
+         b=sqrt(dx31*dx31+dy31*dy31);
+         c=sqrt(dx23*dx23+dy23*dy23);
+         ANG(k,0,ne)=acos((b*b+c*c-a*a)/(2*b*c))*180/M_PI;
+         ANG(k,1,ne)=acos((a*a+c*c-b*b)/(2*a*c))*180/M_PI;
+         ANG(k,2,ne)=acos((a*a+b*b-c*c)/(2*a*b))*180/M_PI;
+      }
+      else{
+         AA(k,0,ne)=x3-x2;
+         AA(k,1,ne)=x1-x3;
+         AA(k,2,ne)=x2-x1;
+         BB(k,0,ne)=dy23;
+         BB(k,1,ne)=dy31;
+         BB(k,2,ne)=dy12;
+         /* BELINT's 2*A0, which is exactly the unhalved product */
+         TT(k,0,ne)=x2*y3-x3*y2;
+         TT(k,1,ne)=x3*y1-x1*y3;
+         TT(k,2,ne)=2*ar[k]-TT(k,0,ne)-TT(k,1,ne);
+      }
+   }
+
+/* ---- Set elements of return matrices, pointed to by plhs[].  The
+        matrices are created empty and given the computed arrays, so
+        no second ne x 3 copy is ever allocated. ------------------- */
+   plhs[0]=wrap(ar,ne,1);
+   if (doang)
+      plhs[1]=wrap(ang,ne,3);
+   else{
+      plhs[1]=wrap(A,ne,3);
+      plhs[2]=wrap(B,ne,3);
+      plhs[3]=wrap(T,ne,3);
+   }
+
+/* ---- No need to free memory allocated with "mxCalloc"; MATLAB
+   does this automatically.  The CMEX allocation functions in
+   "opnml_allocs.c" use mxCalloc. ----------------------------------- */
+   return;
+}
+
+/*----------------------------------------------------------------------
+
+  #    #  #####     ##    #####
+  #    #  #    #   #  #   #    #
+  #    #  #    #  #    #  #    #
+  # ## #  #####   ######  #####
+  ##  ##  #   #   #    #  #
+  #    #  #    #  #    #  #
+
+----------------------------------------------------------------------*/
+mxArray *wrap(double *v,int m,int n)
+{
+   mxArray *a;
+   a=mxCreateDoubleMatrix(0,0,mxREAL);
+   mxSetPr(a,v);
+   mxSetM(a,m);
+   mxSetN(a,n);
+   return(a);
+}
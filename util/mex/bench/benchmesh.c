@@ -0,0 +1,274 @@
+/* benchmesh.c: deterministic synthetic ADCIRC-like grids for mexbench.
+
+   The grid is a coastal ocean basin, 98W to 62W and 10N to 45N, with
+   the land to the east of a wavy north-south coastline and a dozen
+   islands off it.  Nodes are on a jittered lattice whose columns are
+   graded about eight to one toward the coast, as ADCIRC grids are
+   refined toward the shore; each lattice cell is split into two
+   triangles, alternating diagonals, and the triangles on land or in
+   an island are dropped.  The depth falls from 4500 m offshore to a
+   few meters over land at the coast and at the islands.  The node
+   jitter comes from a fixed-seed generator, so a given element count
+   always gives the same grid, on any machine. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "benchmesh.h"
+
+#define X0     -98.
+#define X1     -62.
+#define Y0      10.
+#define Y1      45.
+#define XCOAST -72.
+#define NCDF   4096
+#define NISLE  12
+
+typedef struct { double x,y,rx,ry; } isle;
+
+double benchrand(unsigned long long *s)
+{
+   /* xorshift64* */
+   *s^=*s>>12;
+   *s^=*s<<25;
+   *s^=*s>>27;
+   return (double)((*s*2685821657736338717ULL)>>11)*(1./9007199254740992.);
+}
+
+double benchcoast(double y)
+{
+   return XCOAST+2.5*sin(.9*y)+1.2*sin(2.7*y+1.)+.5*sin(7.1*y);
+}
+
+/* ---- node density across the basin, highest at the coast ----------- */
+static double density(double x)
+{
+   double d=(x-XCOAST)/3.;
+   return 1.+7.*exp(-d*d);
+}
+
+/* ---- the islands; the same at every grid size ---------------------- */
+static void islands(isle *s)
+{
+   unsigned long long seed=0x5eed151e5ULL;
+   int i;
+   for (i=0;i<NISLE;i++){
+      s[i].y=Y0+2.+(Y1-Y0-4.)*benchrand(&seed);
+      s[i].x=benchcoast(s[i].y)-.6-3.4*benchrand(&seed);
+      s[i].rx=.2+.5*benchrand(&seed);
+      s[i].ry=s[i].rx*(.6+.8*benchrand(&seed));
+   }
+}
+
+static int onland(double x,double y,isle *s)
+{
+   int i;
+   double dx,dy;
+   if (x>benchcoast(y)) return 1;
+   for (i=0;i<NISLE;i++){
+      dx=(x-s[i].x)/s[i].rx;
+      dy=(y-s[i].y)/s[i].ry;
+      if (dx*dx+dy*dy<1.) return 1;
+   }
+   return 0;
+}
+
+void benchmesh(int netarget,bmesh *m)
+{
+   int i,j,k,n,nx,ny,nq,ne,nn,a,b,c,n1,n2,n3,n4,t[6];
+   int *keep,*num,*start,*fill,*n2e;
+   double *cdf,*col,x,y,xc,yc,dx,dy,d,f;
+   double *E;
+   unsigned long long seed=0x6e65766572ULL;
+   isle s[NISLE];
+
+   islands(s);
+
+/* ---- column positions from the inverse of the density's integral --- */
+   cdf=(double *)calloc(NCDF+1,sizeof(double));
+   for (i=1;i<=NCDF;i++){
+      x=X0+(X1-X0)*(i-.5)/NCDF;
+      cdf[i]=cdf[i-1]+density(x);
+   }
+   for (i=0;i<=NCDF;i++) cdf[i]/=cdf[NCDF];
+
+   /* the fraction of columns at sea sizes the lattice for netarget */
+   f=0.;
+   for (j=0;j<64;j++){
+      x=(benchcoast(Y0+(Y1-Y0)*(j+.5)/64.)-X0)/(X1-X0)*NCDF;
+      i=(int)x;
+      f+=cdf[i]+(x-i)*(cdf[i+1]-cdf[i]);
+   }
+   f/=64.;
+   n=(int)ceil(sqrt(netarget/(2.*f)))+1;
+   if (n<8) n=8;
+   nx=ny=n;
+
+   col=(double *)malloc(nx*sizeof(double));
+   for (i=0,k=0;i<nx;i++){
+      d=(double)i/(nx-1);
+      while (k<NCDF-1 && cdf[k+1]<d) k++;
+      col[i]=X0+(X1-X0)*(k+(cdf[k+1]>cdf[k] ? (d-cdf[k])/(cdf[k+1]-cdf[k]) : 0.))/NCDF;
+   }
+   col[0]=X0;
+   col[nx-1]=X1;
+   free(cdf);
+
+/* ---- jittered lattice ---------------------------------------------- */
+   nn=nx*ny;
+   m->x=(double *)malloc(nn*sizeof(double));
+   m->y=(double *)malloc(nn*sizeof(double));
+   dy=(Y1-Y0)/(ny-1);
+   for (j=0;j<ny;j++)
+      for (i=0;i<nx;i++){
+         x=col[i];
+         y=Y0+j*dy;
+         if (i>0 && i<nx-1){
+            dx=col[i]-col[i-1]<col[i+1]-col[i] ? col[i]-col[i-1] : col[i+1]-col[i];
+            x+=.3*(benchrand(&seed)-.5)*dx;
+         }
+         if (j>0 && j<ny-1)
+            y+=.3*(benchrand(&seed)-.5)*dy;
+         m->x[j*nx+i]=x;
+         m->y[j*nx+i]=y;
+      }
+   free(col);
+
+/* ---- two triangles per cell, those at sea kept ---------------------- */
+   nq=2*(nx-1)*(ny-1);
+   E=(double *)malloc(3*(size_t)nq*sizeof(double));
+   keep=(int *)calloc(nn,sizeof(int));
+   ne=0;
+   for (j=0;j<ny-1;j++)
+      for (i=0;i<nx-1;i++){
+         n1=j*nx+i;
+         n2=n1+1;
+         n3=n1+nx;
+         n4=n3+1;
+         if ((i+j)%2==0){
+            t[0]=n1; t[1]=n2; t[2]=n4;
+            t[3]=n1; t[4]=n4; t[5]=n3;
+         }
+         else {
+            t[0]=n1; t[1]=n2; t[2]=n3;
+            t[3]=n2; t[4]=n4; t[5]=n3;
+         }
+         for (k=0;k<6;k+=3){
+            xc=(m->x[t[k]]+m->x[t[k+1]]+m->x[t[k+2]])/3.;
+            yc=(m->y[t[k]]+m->y[t[k+1]]+m->y[t[k+2]])/3.;
+            if (onland(xc,yc,s)) continue;
+            E[3*ne]=t[k];
+            E[3*ne+1]=t[k+1];
+            E[3*ne+2]=t[k+2];
+            keep[t[k]]=keep[t[k+1]]=keep[t[k+2]]=1;
+            ne++;
+         }
+      }
+
+/* ---- number the nodes in use; element list to ne x 3, 1-based ------ */
+   num=(int *)malloc(nn*sizeof(int));
+   for (i=0,k=0;i<nn;i++){
+      num[i]=keep[i] ? k : -1;
+      if (keep[i]){
+         m->x[k]=m->x[i];
+         m->y[k]=m->y[i];
+         k++;
+      }
+   }
+   nn=k;
+   free(keep);
+   m->nn=nn;
+   m->ne=ne;
+   m->e=(double *)malloc(3*(size_t)ne*sizeof(double));
+   for (k=0;k<ne;k++)
+      for (j=0;j<3;j++)
+         m->e[k+(size_t)ne*j]=num[(int)E[3*k+j]]+1;
+   free(E);
+   free(num);
+
+/* ---- depth ---------------------------------------------------------- */
+   m->z=(double *)malloc(nn*sizeof(double));
+   m->xmin=m->ymin=1e30;
+   m->xmax=m->ymax=-1e30;
+   for (i=0;i<nn;i++){
+      x=m->x[i];
+      y=m->y[i];
+      d=benchcoast(y)-x;
+      m->z[i]=4500.*(1.-exp(-d/2.5))-3.;
+      for (k=0;k<NISLE;k++){
+         dx=(x-s[k].x)/s[k].rx;
+         dy=(y-s[k].y)/s[k].ry;
+         d=sqrt(dx*dx+dy*dy);
+         if (d<2. && 20.*(d-1.2)<m->z[i]) m->z[i]=20.*(d-1.2);
+      }
+      if (x<m->xmin) m->xmin=x;
+      if (x>m->xmax) m->xmax=x;
+      if (y<m->ymin) m->ymin=y;
+      if (y>m->ymax) m->ymax=y;
+   }
+
+/* ---- element arrays, as EL_AREAS and BELINT ------------------------- */
+   m->ar=(double *)malloc(ne*sizeof(double));
+   m->A=(double *)malloc(3*(size_t)ne*sizeof(double));
+   m->B=(double *)malloc(3*(size_t)ne*sizeof(double));
+   m->T=(double *)malloc(3*(size_t)ne*sizeof(double));
+   for (k=0;k<ne;k++){
+      double *px=m->x,*py=m->y;
+      a=(int)m->e[k]-1;
+      b=(int)m->e[k+ne]-1;
+      c=(int)m->e[k+2*(size_t)ne]-1;
+      m->ar[k]=(px[a]*(py[b]-py[c])+px[b]*(py[c]-py[a])+px[c]*(py[a]-py[b]))/2.;
+      m->A[k]=px[c]-px[b];
+      m->A[k+ne]=px[a]-px[c];
+      m->A[k+2*(size_t)ne]=px[b]-px[a];
+      m->B[k]=py[b]-py[c];
+      m->B[k+ne]=py[c]-py[a];
+      m->B[k+2*(size_t)ne]=py[a]-py[b];
+      m->T[k]=px[b]*py[c]-px[c]*py[b];
+      m->T[k+ne]=px[c]*py[a]-px[a]*py[c];
+      m->T[k+2*(size_t)ne]=2.*m->ar[k]-m->T[k]-m->T[k+ne];
+   }
+
+/* ---- element neighbors, through the elements of each node ----------- */
+   start=(int *)calloc(nn+1,sizeof(int));
+   fill=(int *)calloc(nn,sizeof(int));
+   n2e=(int *)malloc(3*(size_t)ne*sizeof(int));
+   for (k=0;k<3*ne;k++) start[(int)m->e[k]]++;
+   for (i=0;i<nn;i++) start[i+1]+=start[i];
+   for (k=0;k<ne;k++)
+      for (j=0;j<3;j++){
+         a=(int)m->e[k+(size_t)ne*j]-1;
+         n2e[start[a]+fill[a]++]=k;
+      }
+   m->ee=(int *)calloc(3*(size_t)ne,sizeof(int));
+   for (k=0;k<ne;k++)
+      for (j=0;j<3;j++){
+         a=(int)m->e[k+(size_t)ne*j]-1;
+         b=(int)m->e[k+(size_t)ne*((j+1)%3)];
+         /* the other element of edge a-b has b then a */
+         for (i=start[a];i<start[a+1];i++){
+            c=n2e[i];
+            if (c==k) continue;
+            if (m->e[c]==b || m->e[c+ne]==b || m->e[c+2*(size_t)ne]==b){
+               m->ee[k+(size_t)ne*j]=c+1;
+               break;
+            }
+         }
+      }
+   free(start);
+   free(fill);
+   free(n2e);
+}
+
+void benchmesh_free(bmesh *m)
+{
+   free(m->x);
+   free(m->y);
+   free(m->z);
+   free(m->e);
+   free(m->ar);
+   free(m->A);
+   free(m->B);
+   free(m->T);
+   free(m->ee);
+}
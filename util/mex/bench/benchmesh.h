@@ -0,0 +1,30 @@
+/* benchmesh.h: deterministic synthetic ADCIRC-like grids for mexbench */
+
+#ifndef _BENCHMESH_INCLUDED
+#define _BENCHMESH_INCLUDED
+
+/* A triangular grid as StormSurgeViz holds it: e is ne x 3 (1-based,
+   column-major, counter-clockwise), x,y in degrees, z the depth
+   (positive below the geoid, negative over land), and the element
+   arrays of EL_AREAS and BELINT (ar, A, B, T; ne and ne x 3) that the
+   element search uses.  ee is the element across each edge (ne x 3,
+   1-based, 0 on the boundary) as gridtopomex5 .ee. */
+typedef struct {
+   int nn,ne;
+   double *x,*y,*z,*e;
+   double *ar,*A,*B,*T;
+   int *ee;
+   double xmin,xmax,ymin,ymax;
+} bmesh;
+
+/* a grid of about ne elements; the same ne gives the same grid */
+void   benchmesh(int ne,bmesh *m);
+void   benchmesh_free(bmesh *m);
+
+/* the coastline; land is x > benchcoast(y) */
+double benchcoast(double y);
+
+/* deterministic uniform [0,1) numbers; seed *s with any nonzero value */
+double benchrand(unsigned long long *s);
+
+#endif  /* _BENCHMESH_INCLUDED */
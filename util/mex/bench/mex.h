@@ -0,0 +1,103 @@
+/* mex.h for mexbench: the part of the MATLAB MEX/mxArray API used by
+   the util/mex kernels, implemented in mexshim.c, so the kernels build
+   and run as plain C programs without MATLAB.  Arrays are 2-D and
+   column-major as in MATLAB.  The allocation calls are counted (see
+   mexbench_allocs) so the benchmark can report them per kernel call,
+   and what a call leaves allocated is freed after it (mexbench_release)
+   as MATLAB frees it on return from a MEX-file. */
+
+#ifndef mex_h
+#define mex_h
+
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef size_t mwSize;
+typedef size_t mwIndex;
+
+typedef enum {
+   mxUNKNOWN_CLASS,mxCELL_CLASS,mxSTRUCT_CLASS,mxLOGICAL_CLASS,
+   mxCHAR_CLASS,mxVOID_CLASS,mxDOUBLE_CLASS,mxSINGLE_CLASS,
+   mxINT8_CLASS,mxUINT8_CLASS,mxINT16_CLASS,mxUINT16_CLASS,
+   mxINT32_CLASS,mxUINT32_CLASS,mxINT64_CLASS,mxUINT64_CLASS
+} mxClassID;
+typedef enum {mxREAL,mxCOMPLEX} mxComplexity;
+typedef struct mxArray_tag mxArray;
+typedef unsigned short mxChar;
+
+/* ---- memory -------------------------------------------------------- */
+void *mxCalloc(size_t,size_t);
+void *mxMalloc(size_t);
+void *mxRealloc(void *,size_t);
+void  mxFree(void *);
+void  mexMakeMemoryPersistent(void *);
+void  mexMakeArrayPersistent(mxArray *);
+int   mexAtExit(void (*)(void));
+
+/* ---- numbers and messages ------------------------------------------ */
+double mxGetNaN(void);
+double mxGetInf(void);
+double mxGetEps(void);
+bool   mxIsNaN(double);
+bool   mxIsInf(double);
+bool   mxIsFinite(double);
+void   mexErrMsgTxt(const char *);
+void   mexErrMsgIdAndTxt(const char *,const char *,...);
+void   mexWarnMsgTxt(const char *);
+int    mexPrintf(const char *,...);
+int    mexCallMATLAB(int,mxArray **,int,mxArray **,const char *);
+int    mexEvalString(const char *);
+
+/* ---- arrays -------------------------------------------------------- */
+mxArray *mxCreateDoubleMatrix(size_t,size_t,mxComplexity);
+mxArray *mxCreateNumericMatrix(size_t,size_t,mxClassID,mxComplexity);
+mxArray *mxCreateDoubleScalar(double);
+mxArray *mxCreateLogicalScalar(bool);
+mxArray *mxCreateString(const char *);
+mxArray *mxCreateStructMatrix(size_t,size_t,int,const char **);
+mxArray *mxCreateCellMatrix(size_t,size_t);
+mxArray *mxDuplicateArray(const mxArray *);
+void     mxDestroyArray(mxArray *);
+
+double  *mxGetPr(const mxArray *);
+double  *mxGetPi(const mxArray *);
+void     mxSetPr(mxArray *,double *);
+void    *mxGetData(const mxArray *);
+void     mxSetData(mxArray *,void *);
+size_t   mxGetM(const mxArray *);
+size_t   mxGetN(const mxArray *);
+void     mxSetM(mxArray *,size_t);
+void     mxSetN(mxArray *,size_t);
+size_t   mxGetNumberOfElements(const mxArray *);
+size_t   mxGetNumberOfDimensions(const mxArray *);
+const size_t *mxGetDimensions(const mxArray *);
+size_t   mxGetElementSize(const mxArray *);
+double   mxGetScalar(const mxArray *);
+int      mxGetString(const mxArray *,char *,size_t);
+char    *mxArrayToString(const mxArray *);
+
+mxArray *mxGetField(const mxArray *,size_t,const char *);
+void     mxSetField(mxArray *,size_t,const char *,mxArray *);
+mxArray *mxGetCell(const mxArray *,size_t);
+void     mxSetCell(mxArray *,size_t,mxArray *);
+
+mxClassID mxGetClassID(const mxArray *);
+bool mxIsDouble(const mxArray *);
+bool mxIsSingle(const mxArray *);
+bool mxIsInt32(const mxArray *);
+bool mxIsUint32(const mxArray *);
+bool mxIsUint8(const mxArray *);
+bool mxIsChar(const mxArray *);
+bool mxIsStruct(const mxArray *);
+bool mxIsCell(const mxArray *);
+bool mxIsEmpty(const mxArray *);
+bool mxIsComplex(const mxArray *);
+bool mxIsLogical(const mxArray *);
+bool mxIsNumeric(const mxArray *);
+
+/* ---- mexbench only: allocation counters since the last reset, and
+        the release of what a kernel call left allocated ------------- */
+void mexbench_allocs(long *count,double *bytes,int reset);
+void mexbench_release(void);
+
+#endif  /* mex_h */
@@ -0,0 +1,474 @@
+/* mexbench.c: times one util/mex kernel on a synthetic grid.
+
+   Built once per kernel, linked with the kernel's .c, mexshim.c and
+   benchmesh.c (see mexbench.sh), with -DBENCH_KERNEL=<kernel name>:
+
+      mexbench <ne> [reps]
+
+   makes the benchmesh grid of about ne elements, calls the kernel's
+   mexFunction on it for each of its cases, reps times (default 3),
+   and writes one line per case to stdout:
+
+      {"kernel":"findelemex5","case":"index","ne":99904,"nn":50912,
+       "n":200000,"unit":"points/s","secs":0.012,"rate":1.6e+07,
+       "allocs":12,"alloc_mb":3.2,"rss_mb":48.1,"threads":8,
+       "check":"9f3ac0e1d2b4a657"}
+
+   secs is the fastest call and rate is n/secs; a case is called reps
+   times and then again until it has run for a quarter second, so
+   that the fast cases on small grids are timed over many calls.  allocs and
+   alloc_mb count the mxCalloc/mxMalloc/mxRealloc calls and the arrays
+   created in the last call, after any scratch a kernel keeps from call
+   to call has been made on the first, rss_mb is the process's peak resident size
+   after the case, and check is a hash of the outputs, so that a
+   change in a kernel's results shows as well as a change in its
+   speed.  The inputs depend only on ne.
+
+   Some cases also check their outputs, where a kernel has a property
+   that must hold on any grid; a case that fails its check is
+   reported on stderr and the exit status is 1. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/resource.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "mex.h"
+#include "benchmesh.h"
+
+#define STR2(s) #s
+#define STR(s)  STR2(s)
+#ifndef BENCH_KERNEL
+#error "compile with -DBENCH_KERNEL=<kernel name>"
+#endif
+#define KERNEL STR(BENCH_KERNEL)
+
+void mexFunction(int,mxArray **,int,const mxArray **);
+
+static int Reps=3;
+static bmesh M;
+
+/* ---- timing, memory, output hashing ---------------------------------- */
+static double now(void)
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC,&t);
+   return t.tv_sec+1e-9*t.tv_nsec;
+}
+
+static double peakrss(void)
+{
+   struct rusage r;
+   getrusage(RUSAGE_SELF,&r);
+   return r.ru_maxrss/1024.;      /* kB on Linux */
+}
+
+static unsigned long long hashout(int nlhs,mxArray **plhs)
+{
+   /* FNV-1a over the output values; NaNs and zeros of either sign
+      hash alike, structs and cells are not outputs of these kernels */
+   unsigned long long h=1469598103934665603ULL;
+   size_t i,k,n;
+   unsigned char *p;
+   double v;
+   int j;
+   for (j=0;j<nlhs;j++){
+      n=mxGetNumberOfElements(plhs[j]);
+      h^=(unsigned long long)n;
+      h*=1099511628211ULL;
+      if (!mxIsDouble(plhs[j])) continue;
+      for (i=0;i<n;i++){
+         v=mxGetPr(plhs[j])[i];
+         if (v!=v) v=NAN;
+         if (v==0.) v=0.;
+         p=(unsigned char *)&v;
+         for (k=0;k<sizeof(double);k++){
+            h^=p[k];
+            h*=1099511628211ULL;
+         }
+      }
+   }
+   return h;
+}
+
+/* ---- call the kernel reps times, and for MINTIME; report the fastest -- */
+#define MINTIME .25
+#define MAXREPS 1000
+
+static void bench(const char *name,const char *unit,double n,
+                  int nlhs,int nrhs,mxArray **prhs,mxArray **keep)
+{
+   mxArray *plhs[4];
+   double t,total=0.,best=1e30,bytes=0.;
+   long allocs=0;
+   unsigned long long check=0;
+   int r,j,last,threads=1;
+
+   for (r=0,last=0;!last;r++){
+      mexbench_allocs(NULL,NULL,1);
+      for (j=0;j<nlhs;j++) plhs[j]=NULL;
+      t=now();
+      mexFunction(nlhs,plhs,nrhs,(const mxArray **)prhs);
+      t=now()-t;
+      mexbench_release();
+      if (t<best) best=t;
+      total+=t;
+      last=r+1>=MAXREPS || (r+1>=Reps && total>=MINTIME);
+      mexbench_allocs(&allocs,&bytes,0);
+      if (r==0)
+         check=hashout(nlhs,plhs);
+      if (keep && last)
+         *keep=plhs[0];
+      else
+         mxDestroyArray(plhs[0]);
+      for (j=1;j<nlhs;j++) mxDestroyArray(plhs[j]);
+   }
+#ifdef _OPENMP
+   threads=omp_get_max_threads();
+#endif
+   printf("{\"kernel\":\"%s\",\"case\":\"%s\",\"ne\":%d,\"nn\":%d,"
+          "\"n\":%.0f,\"unit\":\"%s\",\"secs\":%.6g,\"rate\":%.6g,"
+          "\"allocs\":%ld,\"alloc_mb\":%.4g,\"rss_mb\":%.4g,\"threads\":%d,"
+          "\"check\":\"%016llx\"}\n",
+          KERNEL,name,M.ne,M.nn,n,unit,best,n/(best>0. ? best : 1e-9),
+          allocs,bytes/1048576.,peakrss(),threads,check);
+   fflush(stdout);
+}
+
+/* ---- inputs ---------------------------------------------------------- */
+static mxArray *dmat(const double *p,size_t m,size_t n)
+{
+   mxArray *a=mxCreateDoubleMatrix(m,n,mxREAL);
+   if (p) memcpy(mxGetPr(a),p,m*n*sizeof(double));
+   return a;
+}
+
+/* points uniform over the grid's bounding box; some are on land */
+static void boxpoints(int np,double x0,double x1,double y0,double y1,
+                      unsigned long long seed,mxArray **X,mxArray **Y)
+{
+   int i;
+   *X=dmat(NULL,np,1);
+   *Y=dmat(NULL,np,1);
+   for (i=0;i<np;i++){
+      mxGetPr(*X)[i]=x0+(x1-x0)*benchrand(&seed);
+      mxGetPr(*Y)[i]=y0+(y1-y0)*benchrand(&seed);
+   }
+}
+
+/* a transect from offshore to the coast and along it, as a profile or
+   storm track is sampled; it leaves the grid at the coastline */
+static void transect(int np,mxArray **X,mxArray **Y)
+{
+   int i;
+   double s,x,y,xa,ya,ym,yb;
+   *X=dmat(NULL,np,1);
+   *Y=dmat(NULL,np,1);
+   xa=M.xmin+.05*(M.xmax-M.xmin);
+   ya=M.ymin+.1*(M.ymax-M.ymin);
+   ym=M.ymin+.5*(M.ymax-M.ymin);
+   yb=M.ymin+.9*(M.ymax-M.ymin);
+   for (i=0;i<np;i++){
+      s=(double)i/(np-1);
+      if (s<.5){
+         y=ya+(ym-ya)*2.*s;
+         x=xa+(benchcoast(y)-.3-xa)*2.*s;
+      }
+      else {
+         y=ym+(yb-ym)*(2.*s-1.);
+         x=benchcoast(y)-.3+.5*sin(40.*s);
+      }
+      mxGetPr(*X)[i]=x;
+      mxGetPr(*Y)[i]=y;
+   }
+}
+
+/* a surge-like nodal field: a dome at the coast over waves; dry (NaN)
+   over land */
+static mxArray *surge(void)
+{
+   int i;
+   double x,y,xs,ys=30.,*q;
+   mxArray *Q=dmat(NULL,M.nn,1);
+   q=mxGetPr(Q);
+   xs=benchcoast(ys)-1.;
+   for (i=0;i<M.nn;i++){
+      x=M.x[i];
+      y=M.y[i];
+      q[i]=3.5*exp(-(x-xs)*(x-xs)/8.-(y-ys)*(y-ys)/4.)+
+           .4*sin(1.3*x)*cos(.9*y);
+      if (M.z[i]<-1.) q[i]=NAN;
+   }
+   return Q;
+}
+
+/* ---- the cases of each kernel ---------------------------------------- */
+static void findelemex5_cases(void)
+{
+   mxArray *in[9],*idx=NULL,*ee;
+   int np,k;
+
+   in[2]=dmat(M.ar,M.ne,1);
+   in[3]=dmat(M.A,M.ne,3);
+   in[4]=dmat(M.B,M.ne,3);
+   in[5]=dmat(M.T,M.ne,3);
+   in[6]=mxCreateDoubleScalar(1e-6);
+
+   /* every point against every element; few points on large grids */
+   np=(int)(5e7/M.ne);
+   if (np<50) np=50;
+   if (np>10000) np=10000;
+   boxpoints(np,M.xmin,M.xmax,M.ymin,M.ymax,11,&in[0],&in[1]);
+   bench("full","points/s",np,1,7,in,NULL);
+   mxDestroyArray(in[0]);
+   mxDestroyArray(in[1]);
+
+   /* the bucket index, built as ComputeElementIndex does */
+   {
+      mxArray *bi[6];
+      bi[0]=mxCreateString("index");
+      for (k=1;k<5;k++) bi[k]=in[k+1];
+      bi[5]=mxCreateDoubleScalar(1e-4);
+      bench("index_build","elements/s",M.ne,1,6,bi,&idx);
+      mxDestroyArray(bi[0]);
+      mxDestroyArray(bi[5]);
+   }
+
+   np=200000;
+   boxpoints(np,M.xmin,M.xmax,M.ymin,M.ymax,12,&in[0],&in[1]);
+   in[7]=idx;
+   bench("index","points/s",np,1,8,in,NULL);
+   mxDestroyArray(in[0]);
+   mxDestroyArray(in[1]);
+
+   ee=mxCreateNumericMatrix(M.ne,3,mxINT32_CLASS,mxREAL);
+   memcpy(mxGetData(ee),M.ee,3*(size_t)M.ne*sizeof(int));
+   transect(np,&in[0],&in[1]);
+   in[8]=ee;
+   bench("walk","points/s",np,1,9,in,NULL);
+
+   for (k=0;k<9;k++) mxDestroyArray(in[k]);
+}
+
+static void findelemex52_cases(void)
+{
+   mxArray *in[8];
+   int k,nj,np=20000;
+   double x0,x1,y0,y1,xc,yc,*js;
+
+   /* the elements near a stretch of coast, a candidate list as from a
+      previous search, and points over the same box */
+   y0=M.ymin+.45*(M.ymax-M.ymin);
+   y1=M.ymin+.55*(M.ymax-M.ymin);
+   x1=benchcoast(.5*(y0+y1));
+   x0=x1-.1*(M.xmax-M.xmin);
+   js=(double *)malloc(M.ne*sizeof(double));
+   nj=0;
+   for (k=0;k<M.ne;k++){
+      xc=(M.x[(int)M.e[k]-1]+M.x[(int)M.e[k+M.ne]-1]+M.x[(int)M.e[k+2*M.ne]-1])/3.;
+      yc=(M.y[(int)M.e[k]-1]+M.y[(int)M.e[k+M.ne]-1]+M.y[(int)M.e[k+2*M.ne]-1])/3.;
+      if (xc>=x0 && xc<=x1 && yc>=y0 && yc<=y1) js[nj++]=k+1;
+   }
+   boxpoints(np,x0,x1,y0,y1,21,&in[0],&in[1]);
+   in[2]=dmat(M.ar,M.ne,1);
+   in[3]=dmat(M.A,M.ne,3);
+   in[4]=dmat(M.B,M.ne,3);
+   in[5]=dmat(M.T,M.ne,3);
+   in[6]=dmat(js,nj,1);
+   in[7]=mxCreateDoubleScalar(1e-6);
+   free(js);
+   bench("jsearch","points/s",np,1,8,in,NULL);
+   for (k=0;k<8;k++) mxDestroyArray(in[k]);
+}
+
+/* the stitched lines of the wet/dry surge field must be NaN only
+   in their separator rows: dry elements give no segments */
+static int checklines(const mxArray *P)
+{
+   size_t i,m=mxGetM(P),bad=0,nline=0;
+   const double *p=mxGetPr(P);
+   int sep=1;
+   for (i=0;i<m;i++){
+      if (p[i]!=p[i] && p[m+i]!=p[m+i]){
+         if (sep) bad++;          /* empty line, or NaN first row */
+         sep=1;
+         nline++;
+      }
+      else {
+         if (p[i]!=p[i] || p[m+i]!=p[m+i]) bad++;
+         sep=0;
+      }
+   }
+   if (!sep) bad++;               /* last line not ended */
+   if (bad){
+      fprintf(stderr,"mexbench: %s: %lu bad rows in %lu stitched lines\n",
+              KERNEL,(unsigned long)bad,(unsigned long)nline);
+      return 1;
+   }
+   return 0;
+}
+
+static int contmex5_cases(void)
+{
+   mxArray *in[6],*pts=NULL;
+   int k,fail;
+   double cval[10]={-.5,-.25,0.,.25,.5,1.,1.5,2.,2.5,3.};
+
+   in[0]=dmat(M.x,M.nn,1);
+   in[1]=dmat(M.y,M.nn,1);
+   in[2]=dmat(M.e,M.ne,3);
+   in[3]=surge();
+   in[4]=dmat(cval,10,1);
+   in[5]=mxCreateDoubleScalar(1.);
+   bench("levels","elements/s",M.ne,2,5,in,NULL);
+   bench("stitch","elements/s",M.ne,2,6,in,&pts);
+   fail=checklines(pts);
+   mxDestroyArray(pts);
+   for (k=0;k<6;k++) mxDestroyArray(in[k]);
+   return fail;
+}
+
+static void isopmex5_cases(void)
+{
+   mxArray *in[5];
+   int i,k;
+   double cval[12],*q;
+
+   in[0]=dmat(M.x,M.nn,1);
+   in[1]=dmat(M.y,M.nn,1);
+   in[2]=dmat(M.e,M.ne,3);
+   /* a tidal phase (degrees) progressing up the coast */
+   in[3]=dmat(NULL,M.nn,1);
+   q=mxGetPr(in[3]);
+   for (i=0;i<M.nn;i++){
+      q[i]=fmod(25.*M.y[i]+8.*M.x[i]+40.*sin(.7*M.x[i]),360.);
+      if (q[i]<0.) q[i]+=360.;
+   }
+   for (k=0;k<12;k++) cval[k]=30.*k;
+   in[4]=dmat(cval,12,1);
+   bench("phases","elements/s",M.ne,2,5,in,NULL);
+   for (k=0;k<5;k++) mxDestroyArray(in[k]);
+}
+
+/* a lattice of m x m squares, each an up and a down triangle, with
+   every skip'th down triangle left out (all of them for skip 1); each
+   one left out inside is a hole, far more than a coastal grid has */
+static mxArray *holes(int m,int skip)
+{
+   int i,j,k,ne=0,nd=0;
+   double *e;
+   mxArray *E;
+   for (j=0;j<m;j++)
+      for (i=0;i<m;i++)
+         if (nd++%skip) ne++;
+   E=dmat(NULL,m*m+ne,3);
+   e=mxGetPr(E);
+   ne=m*m+ne;
+   k=nd=0;
+   for (j=0;j<m;j++)
+      for (i=0;i<m;i++){
+         /* nodes numbered by row, m+1 to a row */
+         e[k]=j*(m+1)+i+1;
+         e[k+ne]=j*(m+1)+i+2;
+         e[k+2*ne]=(j+1)*(m+1)+i+1;
+         k++;
+         if (nd++%skip==0) continue;
+         e[k]=j*(m+1)+i+2;
+         e[k+ne]=(j+1)*(m+1)+i+2;
+         e[k+2*ne]=(j+1)*(m+1)+i+1;
+         k++;
+      }
+   return E;
+}
+
+/* each edge of a grid is on one or two elements, so its 3*ne element
+   sides are twice its edges less its boundary edges */
+static int checktopo(const char *name,const mxArray *T,int ne)
+{
+   size_t ned=mxGetM(mxGetField(T,0,"edges"));
+   size_t nb=mxGetM(mxGetField(T,0,"bnd"));
+   const int *loops=(const int *)mxGetData(mxGetField(T,0,"loops"));
+   size_t nl=mxGetM(mxGetField(T,0,"loops"))-1;
+   if (2*ned-nb!=3*(size_t)ne || (size_t)loops[nl]!=nb){
+      fprintf(stderr,"mexbench: %s: %s: %lu edges, %lu boundary edges "
+              "for %d elements\n",KERNEL,name,(unsigned long)ned,
+              (unsigned long)nb,ne);
+      return 1;
+   }
+   return 0;
+}
+
+static int gridtopomex5_cases(void)
+{
+   mxArray *in[2],*T=NULL;
+   int m,fail;
+
+   in[0]=dmat(M.e,M.ne,3);
+   in[1]=mxCreateDoubleScalar(M.nn);
+   bench("grid","elements/s",M.ne,1,2,in,&T);
+   fail=checktopo("grid",T,M.ne);
+   mxDestroyArray(T);
+   mxDestroyArray(in[0]);
+
+   /* more holes than the kernel's first guess at the edge count */
+   m=(int)sqrt(M.ne/2.);
+   in[0]=holes(m,2);
+   mxDestroyArray(in[1]);
+   in[1]=mxCreateDoubleScalar((m+1)*(m+1));
+   bench("holes","elements/s",(double)mxGetM(in[0]),1,2,in,&T);
+   fail|=checktopo("holes",T,(int)mxGetM(in[0]));
+   mxDestroyArray(T);
+   mxDestroyArray(in[0]);
+
+   in[0]=holes(m,1);
+   bench("nodown","elements/s",(double)mxGetM(in[0]),1,2,in,&T);
+   fail|=checktopo("nodown",T,(int)mxGetM(in[0]));
+   mxDestroyArray(T);
+   mxDestroyArray(in[0]);
+   mxDestroyArray(in[1]);
+   return fail;
+}
+
+int main(int argc,char **argv)
+{
+   int ne,fail=0;
+   double t;
+
+   if (argc<2){
+      fprintf(stderr,"usage: %s ne [reps]\n",argv[0]);
+      return 1;
+   }
+   ne=atoi(argv[1]);
+   if (argc>2) Reps=atoi(argv[2]);
+   if (ne<100 || Reps<1){
+      fprintf(stderr,"%s: ne must be at least 100 and reps at least 1\n",argv[0]);
+      return 1;
+   }
+
+   t=now();
+   benchmesh(ne,&M);
+   fprintf(stderr,"%s: grid of %d elements, %d nodes in %.2f secs\n",
+           KERNEL,M.ne,M.nn,now()-t);
+
+   if (strcmp(KERNEL,"findelemex5")==0)
+      findelemex5_cases();
+   else if (strcmp(KERNEL,"findelemex52")==0)
+      findelemex52_cases();
+   else if (strcmp(KERNEL,"contmex5")==0)
+      fail=contmex5_cases();
+   else if (strcmp(KERNEL,"gridtopomex5")==0)
+      fail=gridtopomex5_cases();
+   else if (strcmp(KERNEL,"isopmex5")==0)
+      isopmex5_cases();
+   else {
+      fprintf(stderr,"mexbench: no cases for kernel %s\n",KERNEL);
+      return 1;
+   }
+
+   benchmesh_free(&M);
+   return fail;
+}
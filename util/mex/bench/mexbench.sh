@@ -0,0 +1,154 @@
+#!/bin/sh
+#
+# mexbench.sh: builds the util/mex kernels against the mex.h shim in
+# this directory and times them on synthetic grids, without MATLAB.
+#
+#   mexbench.sh [-k kernels] [-s sizes] [-r reps] [-o out] [-b base]
+#               [-t pct] [-n]
+#
+#   -k  kernels to run (default "findelemex5 findelemex52 contmex5
+#       gridtopomex5 isopmex5")
+#   -s  grid sizes, in elements (default "10000 100000 1000000 5000000")
+#   -r  calls per case, at least; the fastest is reported (default 3)
+#   -o  results file, one JSON object per line (default mexbench.jsonl);
+#       see mexbench.c for the fields
+#   -b  a results file from an earlier run to compare with; each case
+#       is reported FASTER or SLOWER when its rate differs by more than
+#       pct percent, and CHANGED when its outputs differ.  The exit
+#       status is 1 if any case is SLOWER or CHANGED, or if any kernel
+#       fails (see the output checks in mexbench.c).
+#   -t  the percentage for -b (default 10)
+#   -n  build without OpenMP
+#
+# The compiler is $CC (default cc) with $CFLAGS (default -O2).  The
+# kernels that makemex builds with OpenMP are built with -fopenmp
+# here, when the compiler has it; OMP_NUM_THREADS sets the threads.
+# Those it builds with -ffp-contract=off are built with it here.
+# To add a kernel, give it a _cases function in mexbench.c.
+#
+# A typical use, before and after a kernel change:
+#   ./mexbench.sh -o before.jsonl
+#   ./mexbench.sh -o after.jsonl -b before.jsonl
+
+KERNELS="findelemex5 findelemex52 contmex5 gridtopomex5 isopmex5"
+SIZES="10000 100000 1000000 5000000"
+REPS=3
+OUT=mexbench.jsonl
+BASE=
+TOL=10
+OMP=1
+FAIL=0
+OMPFILES="findelemex5 findelemex52 belintmex5 interpmex5 isopmex5"
+FPFILES="belintmex5"
+
+while getopts k:s:r:o:b:t:n opt; do
+   case $opt in
+      k) KERNELS=$OPTARG ;;
+      s) SIZES=$OPTARG ;;
+      r) REPS=$OPTARG ;;
+      o) OUT=$OPTARG ;;
+      b) BASE=$OPTARG ;;
+      t) TOL=$OPTARG ;;
+      n) OMP=0 ;;
+      *) sed -n '3,31p' "$0" | sed 's/^# \{0,1\}//'; exit 2 ;;
+   esac
+done
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+MEX=$(dirname "$HERE")
+CC=${CC:-cc}
+CFLAGS=${CFLAGS:--O2}
+BUILD=$(mktemp -d "${TMPDIR:-/tmp}/mexbench.XXXXXX") || exit 2
+trap 'rm -rf "$BUILD"' EXIT
+
+if [ -n "$BASE" ] && [ ! -r "$BASE" ]; then
+   echo "mexbench: cannot read baseline $BASE" >&2
+   exit 2
+fi
+
+# ---- OpenMP, if the compiler has it
+OMPFLAG=
+if [ $OMP = 1 ]; then
+   printf 'int main(void){return 0;}\n' > "$BUILD/omp.c"
+   if $CC -fopenmp "$BUILD/omp.c" -o "$BUILD/omp" 2>/dev/null; then
+      OMPFLAG=-fopenmp
+   else
+      echo "mexbench: $CC has no OpenMP; building single-threaded" >&2
+   fi
+fi
+
+# ---- build
+for k in $KERNELS; do
+   if [ ! -r "$MEX/$k.c" ]; then
+      echo "mexbench: no kernel $MEX/$k.c" >&2
+      exit 2
+   fi
+   flags=
+   case " $OMPFILES " in
+      *" $k "*) flags=$OMPFLAG ;;
+   esac
+   case " $FPFILES " in
+      *" $k "*) flags="$flags -ffp-contract=off" ;;
+   esac
+   echo "mexbench: building $k" >&2
+   $CC $CFLAGS $flags -DBENCH_KERNEL=$k -I"$HERE" -I"$MEX" \
+       "$HERE/mexbench.c" "$HERE/benchmesh.c" "$HERE/mexshim.c" "$MEX/$k.c" \
+       -lm -o "$BUILD/$k" || exit 2
+done
+
+# ---- run; each kernel and size in its own process, for its peak RSS
+: > "$OUT"
+for n in $SIZES; do
+   for k in $KERNELS; do
+      if ! "$BUILD/$k" "$n" "$REPS" >> "$OUT"; then
+         echo "mexbench: $k failed at $n elements" >&2
+         FAIL=1
+      fi
+   done
+done
+
+# ---- report, against the baseline if given
+awk -v base="$BASE" -v tol="$TOL" '
+function get(s,key,   i,v){
+   i=index(s,"\"" key "\":")
+   if (i==0) return ""
+   v=substr(s,i+length(key)+3)
+   sub(/[,}].*/,"",v)
+   gsub(/"/,"",v)
+   return v
+}
+BEGIN{
+   if (base!=""){
+      while ((getline s < base)>0){
+         k=get(s,"kernel") " " get(s,"case") " " get(s,"ne")
+         brate[k]=get(s,"rate")
+         bcheck[k]=get(s,"check")
+      }
+   }
+   printf "%-13s %-12s %8s %12s %-11s %9s %9s", \
+          "kernel","case","ne","rate","unit","allocs","rss_mb"
+   if (base!="") printf " %12s %7s", "base rate", "ratio"
+   printf "\n"
+}
+{
+   k=get($0,"kernel") " " get($0,"case") " " get($0,"ne")
+   printf "%-13s %-12s %8d %12.4g %-11s %9d %9.1f", get($0,"kernel"), \
+          get($0,"case"),get($0,"ne"),get($0,"rate"),get($0,"unit"), \
+          get($0,"allocs"),get($0,"rss_mb")
+   if (base!=""){
+      if (!(k in brate)){
+         printf " %12s %7s  NEW", "-", "-"
+      }
+      else {
+         r=get($0,"rate")/brate[k]
+         printf " %12.4g %7.3f", brate[k], r
+         if (r<1-tol/100){ printf "  SLOWER"; bad=1 }
+         else if (r>1+tol/100) printf "  FASTER"
+         if (get($0,"check")!=bcheck[k]){ printf "  CHANGED"; bad=1 }
+      }
+   }
+   printf "\n"
+}
+END{ exit bad }
+' "$OUT" || FAIL=1
+exit $FAIL
@@ -0,0 +1,439 @@
+/* mexshim.c: the MEX/mxArray calls declared in mex.h, on the C heap.
+   Enough of MATLAB's behavior for the util/mex kernels: arrays are
+   zeroed on creation, mxCalloc'ed memory may be handed to an array
+   with mxSetPr, memory a kernel leaves allocated is freed after the
+   call (mexbench_release, as MATLAB does on return from a MEX-file),
+   and an error ends the program (there is no MATLAB prompt to return
+   to).  Every mxCalloc/mxMalloc/mxRealloc and every array created is
+   counted, with its bytes. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include "mex.h"
+
+struct mxArray_tag {
+   mxClassID cls;
+   size_t m,n;
+   void *pr,*pi;
+   int nf;              /* struct fields, or 0 */
+   char **fn;
+   mxArray **fv;        /* struct field values, nf per element, or cells */
+};
+
+static long   NAllocs=0;
+static double NBytes=0.;
+
+/* ---- every block has a header; blocks from mxCalloc/mxMalloc are
+        listed until freed, handed to an array, or made persistent.
+        An array's data knows its array, so that mxFree(mxGetPr(a))
+        followed by mxSetPr(a,p), as the kernels do, is not freed
+        twice, and data replaced without it is not lost ------------- */
+typedef struct blk {
+   struct blk *prev,*next;
+   mxArray *owner;
+   size_t n;
+   int listed;
+   size_t pad;
+} blk;
+static blk Listed={&Listed,&Listed,NULL,0,0,0};
+
+#define HDR(p) ((blk *)(p)-1)
+
+static void unlist(blk *h)
+{
+   if (!h->listed) return;
+#ifdef _OPENMP
+#pragma omp critical (mexshim_list)
+#endif
+   {
+      h->prev->next=h->next;
+      h->next->prev=h->prev;
+   }
+   h->listed=0;
+}
+
+static void *blkalloc(size_t n,int zero,int listed)
+{
+   blk *h=(blk *)(zero ? calloc(1,sizeof(blk)+n) : malloc(sizeof(blk)+n));
+   if (h==NULL){
+      fprintf(stderr,"mexbench: out of memory (%.0f bytes)\n",(double)n);
+      exit(3);
+   }
+   h->listed=listed;
+   h->owner=NULL;
+   h->n=n;
+   if (listed){
+#ifdef _OPENMP
+#pragma omp critical (mexshim_list)
+#endif
+      {
+         h->next=Listed.next;
+         h->prev=&Listed;
+         Listed.next->prev=h;
+         Listed.next=h;
+      }
+   }
+   return h+1;
+}
+
+static void blkfree(void *p)
+{
+   if (p==NULL) return;
+   unlist(HDR(p));
+   if (HDR(p)->owner) HDR(p)->owner->pr=NULL;
+   free(HDR(p));
+}
+
+void mexbench_release(void)
+{
+   while (Listed.next!=&Listed)
+      blkfree(Listed.next+1);
+}
+
+static void count(size_t bytes)
+{
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+   NAllocs++;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+   NBytes+=(double)bytes;
+}
+
+void mexbench_allocs(long *n,double *bytes,int reset)
+{
+   if (n) *n=NAllocs;
+   if (bytes) *bytes=NBytes;
+   if (reset){
+      NAllocs=0;
+      NBytes=0.;
+   }
+}
+
+static size_t esize(mxClassID c)
+{
+   switch (c){
+      case mxDOUBLE_CLASS: case mxINT64_CLASS: case mxUINT64_CLASS:
+         return 8;
+      case mxSINGLE_CLASS: case mxINT32_CLASS: case mxUINT32_CLASS:
+         return 4;
+      case mxINT16_CLASS: case mxUINT16_CLASS: case mxCHAR_CLASS:
+         return 2;
+      default:
+         return 1;
+   }
+}
+
+/* struct and cell bookkeeping, not counted */
+static void *xcalloc(size_t n,size_t s)
+{
+   void *p=calloc(n ? n : 1,s ? s : 1);
+   if (p==NULL){
+      fprintf(stderr,"mexbench: out of memory (%.0f bytes)\n",(double)n*s);
+      exit(3);
+   }
+   return p;
+}
+
+/* ---- memory -------------------------------------------------------- */
+void *mxCalloc(size_t n,size_t s)
+{
+   count(n*s);
+   return blkalloc(n*s,1,1);
+}
+
+void *mxMalloc(size_t n)
+{
+   count(n);
+   return blkalloc(n,0,1);
+}
+
+void *mxRealloc(void *p,size_t n)
+{
+   void *q;
+   count(n);
+   q=blkalloc(n,0,1);
+   if (p){
+      memcpy(q,p,HDR(p)->n<n ? HDR(p)->n : n);
+      blkfree(p);
+   }
+   return q;
+}
+
+void mxFree(void *p)                       { blkfree(p); }
+void mexMakeMemoryPersistent(void *p)      { if (p) unlist(HDR(p)); }
+void mexMakeArrayPersistent(mxArray *a)    { (void)a; }
+int  mexAtExit(void (*f)(void))            { (void)f; return 0; }
+
+/* ---- numbers and messages ------------------------------------------ */
+double mxGetNaN(void)      { return NAN; }
+double mxGetInf(void)      { return INFINITY; }
+double mxGetEps(void)      { return 2.220446049250313e-16; }
+bool   mxIsNaN(double x)   { return isnan(x); }
+bool   mxIsInf(double x)   { return isinf(x); }
+bool   mxIsFinite(double x){ return isfinite(x); }
+
+void mexErrMsgTxt(const char *s)
+{
+   fprintf(stderr,"mexbench: kernel error: %s\n",s);
+   exit(2);
+}
+
+void mexErrMsgIdAndTxt(const char *id,const char *f,...)
+{
+   va_list a;
+   fprintf(stderr,"mexbench: kernel error %s: ",id);
+   va_start(a,f);
+   vfprintf(stderr,f,a);
+   va_end(a);
+   fprintf(stderr,"\n");
+   exit(2);
+}
+
+void mexWarnMsgTxt(const char *s)
+{
+   fprintf(stderr,"mexbench: kernel warning: %s\n",s);
+}
+
+int mexPrintf(const char *f,...)
+{
+   va_list a;
+   int r;
+   va_start(a,f);
+   r=vfprintf(stderr,f,a);
+   va_end(a);
+   return r;
+}
+
+int mexCallMATLAB(int nl,mxArray **l,int nr,mxArray **r,const char *f)
+{
+   (void)nl; (void)l; (void)nr; (void)r;
+   fprintf(stderr,"mexbench: kernel called MATLAB function %s\n",f);
+   return 1;
+}
+
+int mexEvalString(const char *s) { (void)s; return 0; }
+
+/* ---- arrays -------------------------------------------------------- */
+static mxArray *newarray(mxClassID c,size_t m,size_t n)
+{
+   mxArray *a=(mxArray *)xcalloc(1,sizeof(mxArray));
+   count(sizeof(mxArray));
+   a->cls=c;
+   a->m=m;
+   a->n=n;
+   return a;
+}
+
+mxArray *mxCreateNumericMatrix(size_t m,size_t n,mxClassID c,mxComplexity x)
+{
+   mxArray *a=newarray(c,m,n);
+   count(m*n*esize(c));
+   a->pr=blkalloc(m*n*esize(c),1,0);
+   HDR(a->pr)->owner=a;
+   if (x==mxCOMPLEX){
+      count(m*n*esize(c));
+      a->pi=blkalloc(m*n*esize(c),1,0);
+   }
+   return a;
+}
+
+mxArray *mxCreateDoubleMatrix(size_t m,size_t n,mxComplexity x)
+{
+   return mxCreateNumericMatrix(m,n,mxDOUBLE_CLASS,x);
+}
+
+mxArray *mxCreateDoubleScalar(double v)
+{
+   mxArray *a=mxCreateDoubleMatrix(1,1,mxREAL);
+   *(double *)a->pr=v;
+   return a;
+}
+
+mxArray *mxCreateLogicalScalar(bool v)
+{
+   mxArray *a=mxCreateNumericMatrix(1,1,mxLOGICAL_CLASS,mxREAL);
+   *(unsigned char *)a->pr=(unsigned char)v;
+   return a;
+}
+
+mxArray *mxCreateString(const char *s)
+{
+   size_t i,n=strlen(s);
+   mxArray *a=mxCreateNumericMatrix(1,n,mxCHAR_CLASS,mxREAL);
+   for (i=0;i<n;i++) ((mxChar *)a->pr)[i]=(mxChar)s[i];
+   return a;
+}
+
+mxArray *mxCreateStructMatrix(size_t m,size_t n,int nf,const char **f)
+{
+   int i;
+   mxArray *a=newarray(mxSTRUCT_CLASS,m,n);
+   a->nf=nf;
+   a->fn=(char **)xcalloc(nf,sizeof(char *));
+   a->fv=(mxArray **)xcalloc((size_t)nf*m*n,sizeof(mxArray *));
+   for (i=0;i<nf;i++){
+      a->fn[i]=(char *)xcalloc(strlen(f[i])+1,1);
+      strcpy(a->fn[i],f[i]);
+   }
+   return a;
+}
+
+mxArray *mxCreateCellMatrix(size_t m,size_t n)
+{
+   mxArray *a=newarray(mxCELL_CLASS,m,n);
+   a->fv=(mxArray **)xcalloc(m*n,sizeof(mxArray *));
+   return a;
+}
+
+mxArray *mxDuplicateArray(const mxArray *s)
+{
+   size_t i,k;
+   mxArray *a;
+   if (s->cls==mxSTRUCT_CLASS){
+      a=mxCreateStructMatrix(s->m,s->n,s->nf,(const char **)s->fn);
+      for (k=0;k<s->m*s->n*s->nf;k++)
+         if (s->fv[k]) a->fv[k]=mxDuplicateArray(s->fv[k]);
+      return a;
+   }
+   if (s->cls==mxCELL_CLASS){
+      a=mxCreateCellMatrix(s->m,s->n);
+      for (i=0;i<s->m*s->n;i++)
+         if (s->fv[i]) a->fv[i]=mxDuplicateArray(s->fv[i]);
+      return a;
+   }
+   a=mxCreateNumericMatrix(s->m,s->n,s->cls,s->pi ? mxCOMPLEX : mxREAL);
+   memcpy(a->pr,s->pr,s->m*s->n*esize(s->cls));
+   if (s->pi) memcpy(a->pi,s->pi,s->m*s->n*esize(s->cls));
+   return a;
+}
+
+void mxDestroyArray(mxArray *a)
+{
+   size_t k,n;
+   int i;
+   if (a==NULL) return;
+   if (a->cls==mxSTRUCT_CLASS || a->cls==mxCELL_CLASS){
+      n=a->m*a->n*(a->cls==mxSTRUCT_CLASS ? (size_t)a->nf : 1);
+      for (k=0;k<n;k++) mxDestroyArray(a->fv[k]);
+      free(a->fv);
+      for (i=0;i<a->nf;i++) free(a->fn[i]);
+      free(a->fn);
+   }
+   blkfree(a->pr);
+   blkfree(a->pi);
+   free(a);
+}
+
+double *mxGetPr(const mxArray *a)          { return (double *)a->pr; }
+double *mxGetPi(const mxArray *a)          { return (double *)a->pi; }
+void    mxSetPr(mxArray *a,double *p)      { mxSetData(a,p); }
+void   *mxGetData(const mxArray *a)        { return a->pr; }
+
+/* the array owns memory handed to it; its own, if not already freed
+   by the kernel, is freed */
+void mxSetData(mxArray *a,void *p)
+{
+   if (p==a->pr) return;
+   blkfree(a->pr);
+   a->pr=p;
+   if (p){
+      unlist(HDR(p));
+      HDR(p)->owner=a;
+   }
+}
+
+size_t  mxGetM(const mxArray *a)           { return a->m; }
+size_t  mxGetN(const mxArray *a)           { return a->n; }
+void    mxSetM(mxArray *a,size_t m)        { a->m=m; }
+void    mxSetN(mxArray *a,size_t n)        { a->n=n; }
+size_t  mxGetNumberOfElements(const mxArray *a) { return a->m*a->n; }
+size_t  mxGetNumberOfDimensions(const mxArray *a) { (void)a; return 2; }
+size_t  mxGetElementSize(const mxArray *a) { return esize(a->cls); }
+
+const size_t *mxGetDimensions(const mxArray *a)
+{
+   static size_t d[2];
+   d[0]=a->m;
+   d[1]=a->n;
+   return d;
+}
+
+double mxGetScalar(const mxArray *a)
+{
+   if (a->m*a->n==0 || a->pr==NULL) return 0.;
+   switch (a->cls){
+      case mxDOUBLE_CLASS:  return *(double *)a->pr;
+      case mxSINGLE_CLASS:  return *(float *)a->pr;
+      case mxINT32_CLASS:   return *(int *)a->pr;
+      case mxUINT32_CLASS:  return *(unsigned int *)a->pr;
+      case mxCHAR_CLASS:    return *(mxChar *)a->pr;
+      case mxLOGICAL_CLASS:
+      case mxUINT8_CLASS:   return *(unsigned char *)a->pr;
+      default:              return 0.;
+   }
+}
+
+int mxGetString(const mxArray *a,char *b,size_t l)
+{
+   size_t i,n=a->m*a->n;
+   if (a->cls!=mxCHAR_CLASS || l==0) return 1;
+   for (i=0;i<n && i+1<l;i++) b[i]=(char)((mxChar *)a->pr)[i];
+   b[i]=0;
+   return n+1>l;
+}
+
+char *mxArrayToString(const mxArray *a)
+{
+   char *b=(char *)mxCalloc(a->m*a->n+1,1);
+   mxGetString(a,b,a->m*a->n+1);
+   return b;
+}
+
+static int fieldindex(const mxArray *a,const char *f)
+{
+   int i;
+   for (i=0;i<a->nf;i++)
+      if (strcmp(a->fn[i],f)==0) return i;
+   return -1;
+}
+
+mxArray *mxGetField(const mxArray *a,size_t k,const char *f)
+{
+   int i;
+   if (a->cls!=mxSTRUCT_CLASS) return NULL;
+   i=fieldindex(a,f);
+   return i<0 ? NULL : a->fv[k*a->nf+i];
+}
+
+void mxSetField(mxArray *a,size_t k,const char *f,mxArray *v)
+{
+   int i=fieldindex(a,f);
+   if (i<0){
+      fprintf(stderr,"mexbench: no field %s in struct\n",f);
+      exit(3);
+   }
+   a->fv[k*a->nf+i]=v;
+}
+
+mxArray *mxGetCell(const mxArray *a,size_t i)      { return a->fv[i]; }
+void     mxSetCell(mxArray *a,size_t i,mxArray *v) { a->fv[i]=v; }
+
+mxClassID mxGetClassID(const mxArray *a) { return a->cls; }
+bool mxIsDouble(const mxArray *a)  { return a->cls==mxDOUBLE_CLASS; }
+bool mxIsSingle(const mxArray *a)  { return a->cls==mxSINGLE_CLASS; }
+bool mxIsInt32(const mxArray *a)   { return a->cls==mxINT32_CLASS; }
+bool mxIsUint32(const mxArray *a)  { return a->cls==mxUINT32_CLASS; }
+bool mxIsUint8(const mxArray *a)   { return a->cls==mxUINT8_CLASS; }
+bool mxIsChar(const mxArray *a)    { return a->cls==mxCHAR_CLASS; }
+bool mxIsStruct(const mxArray *a)  { return a->cls==mxSTRUCT_CLASS; }
+bool mxIsCell(const mxArray *a)    { return a->cls==mxCELL_CLASS; }
+bool mxIsEmpty(const mxArray *a)   { return a->m*a->n==0; }
+bool mxIsComplex(const mxArray *a) { return a->pi!=NULL; }
+bool mxIsLogical(const mxArray *a) { return a->cls==mxLOGICAL_CLASS; }
+bool mxIsNumeric(const mxArray *a) { return a->cls>=mxDOUBLE_CLASS; }
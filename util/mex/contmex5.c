@@ -1,17 +1,83 @@
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "mex.h"
 #include "opnml_mex5_allocs.c"
+#include "opnml_mex5_hash.c"
+#include "opnml_mex5_arena.c"
+
+/* ---- segment list, grown as segments are found; seg holds the
+        rows [x1 y1 x2 y2], column-major so that it becomes cmat in
+        place, lev the 0-based index into the caller's cval vector.  
+        When stitching, key holds the mesh entity each endpoint lies 
+        on (see NODEKEY/EDGEKEY) ----------------------------------- */
+typedef struct {
+   mxEmit     seg;
+   int       *lev;
+   long long *key;
+   int     cnt;
+   int     max;
+} seglist;
+
+/* ---- contour value and its position in the caller's cval -------- */
+typedef struct {
+   double v;
+   int    i;
+} cvlevel;
+
+/* ---- polylines from stitching; pts holds vertex ids, -1 ending 
+        each line, info 3 ints [lev npts closed] per line ---------- */
+typedef struct {
+   int *pts;
+   int *info;
+   int  npts;
+   int  nline;
+} linelist;
 
 /* PROTOTYPES */
 void isopts(int,
+            int,
             double *,
             double *,
             int *,
             double *,
+            int,
+            cvlevel *,
+            int,
+            seglist *);
+void addseg(seglist *,
+            double,
+            double,
             double,
+            double,
+            int,
+            long long,
+            long long);
+void stitch(seglist *,
+            int,
+            double *,
+            double *,
+            int,
+            int *,
+            double **,
             double **,
-            int *);
+            linelist *);
+void walkline(int,
+              int,
+              int,
+              int *,
+              int *,
+              int *,
+              int *,
+              int *,
+              linelist *);
+int cvcomp(const void *,
+           const void *);
+
+/* ---- scratch kept from call to call, so that contouring a series
+        of fields on one grid reuses the same memory --------------- */
+static mxArena Scratch=MXARENA_PERSISTENT;
+static void FreeScratch(void) { mxArenaFree(&Scratch); }
 
 /************************************************************
 
@@ -31,19 +97,44 @@ void mexFunction(int            nlhs,
 {
 
 /* ---- contmex5 will be called as :
-        cmat=contmex5(x,y,ele,q,cval); ---------------------------- */
+        cmat=contmex5(x,y,ele,q,cval);
+     or [cmat,lev]=contmex5(x,y,ele,q,cval);
+     or [pts,info]=contmex5(x,y,ele,q,cval,1);
+
+        cval may be a vector of contour values; all values are 
+        contoured in one pass over the elements.  cmat rows are 
+        grouped by contour value in the order given in cval, and 
+        within each value are in element order, so the rows for 
+        cval(k) are exactly those of contmex5(x,y,ele,q,cval(k)).
+        lev(i) is the index into cval of row i of cmat.  If no 
+        segments are found, cmat is returned as before (1x1) and 
+        lev is empty.
+
+        With a nonzero 6th argument the segments are stitched into
+        polylines through the mesh nodes and edges they end on.  
+        pts is a 2-column [x y] list of the lines, each followed by 
+        a row of NaNs; shared endpoints appear once per line, and 
+        duplicate and zero-length segments, and those in elements
+        with a NaN nodal value, are dropped.  info has 
+        one row [lev npts closed] per line, grouped by contour value
+        as for cmat; npts excludes the NaN row, and closed rings 
+        repeat their first point at the end. ----------------------- */
 
-   int cnt,*ele,i,j,nn,ne;
+   int cnt,*ele,i,j,k,nn,ne,nc,nfin,stitchit;
+   int *start,*ord;
    double *x, *y, *q;
    double *cval,*dele;
-   double **cmat,*newcmat;
-   int nrl,nrh,ncl,nch ;
+   double *newcmat,*newlev;
+   double *vx,*vy;
+   cvlevel *cv;
+   seglist segs;
+   linelist lines;
      
 /* ---- check I/O arguments ----------------------------------------- */
-   if (nrhs != 5) 
-      mexErrMsgTxt("contmex5 requires 5 input arguments.");
-   else if (nlhs != 1) 
-      mexErrMsgTxt("contmex5 requires 1 output arguments.");
+   if (nrhs != 5 && nrhs != 6) 
+      mexErrMsgTxt("contmex5 requires 5 or 6 input arguments.");
+   else if (nlhs > 2) 
+      mexErrMsgTxt("contmex5 requires 1 or 2 output arguments.");
 
 /* ---- dereference input arrays ------------------------------------ */
    x=mxGetPr(prhs[0]);
@@ -53,46 +144,97 @@ void mexFunction(int            nlhs,
    cval=mxGetPr(prhs[4]);
    nn=mxGetM(prhs[0]);
    ne=mxGetM(prhs[2]);   
-   
+   nc=mxGetNumberOfElements(prhs[4]);
+   if (nc<1)
+      mexErrMsgTxt("contmex5 requires at least one contour value.");
+   stitchit=(nrhs==6 && mxGetScalar(prhs[5])!=0.);
+   mexAtExit(FreeScratch);
+   mxArenaReset(&Scratch);
 
 /* ---- allocate space for int representation of dele &
         convert double element representation to int  &
         shift node numbers toward 0 by 1 for proper indexing -------- */
-   ele=(int *)mxIvector(0,3*ne);
+   ele=(int *)mxArenaAlloc(&Scratch,3*(size_t)ne*sizeof(int));
    for (i=0;i<3*ne;i++)
       ele[i]=((int)dele[i])-1;
    
-/* ---- allocate space for contour list cmat following NRC 
-        allocation style
-        double **mxDmatrix(int nrl,int nrh,int ncl,int nch)
-        cmat= mxDmatrix(     0,     ne-1,    0,      3) ------------- */
-   nrl=0;
-   nrh=6*ne;
-   ncl=0;
-   nch=3;
-   cmat=(double **) mxDmatrix(nrl,nrh,ncl,nch);
+/* ---- sort the contour values so that each element only visits 
+        the values within its range; NaN values go to the end ------ */
+   cv=(cvlevel *)mxArenaAlloc(&Scratch,nc*sizeof(cvlevel));
+   for (k=0;k<nc;k++){
+      cv[k].v=cval[k];
+      cv[k].i=k;
+   }
+   qsort(cv,nc,sizeof(cvlevel),cvcomp);
+   for (nfin=0;nfin<nc&&cv[nfin].v==cv[nfin].v;nfin++);
   
-   isopts(ne,x,y,ele,q,cval[0],cmat,&cnt); 
-   
-   if(cnt!=0){
-      newcmat=(double *) mxDvector(0,4*cnt-1);
-      for (j=0;j<4;j++)
-	 for (i=0;i<cnt;i++)
-            newcmat[cnt*j+i]=cmat[i][j];
-      /* ---- Set elements of return matrix, pointed to by plhs[0] -------- */
-      plhs[0]=mxCreateDoubleMatrix(cnt,4,mxREAL); 
-      mxFree(mxGetPr(plhs[0])); 
-      mxSetPr(plhs[0],newcmat);
+/* ---- start the segment list at about one segment per element per
+        20 contour values; addseg grows it as needed ---------------- */
+   segs.max=ne/20*nc+1024;
+   segs.cnt=0;
+   mxEmitInit(&segs.seg,4,segs.max);
+   segs.lev=(int *)mxMalloc(segs.max*sizeof(int));
+   if (stitchit)
+      segs.key=(long long *)mxMalloc(2*segs.max*sizeof(long long));
+   else
+      segs.key=NULL;
+  
+   isopts(ne,nn,x,y,ele,q,nc,cv,nfin,&segs); 
+   cnt=segs.cnt;
+
+/* ---- group the segments by contour value (counting sort on lev,
+        which keeps element order within each value); ord[k] is the
+        segment in position k -------------------------------------- */
+   start=(int *)mxArenaCalloc(&Scratch,nc+1,sizeof(int));
+   ord=(int *)mxArenaAlloc(&Scratch,(cnt+1)*sizeof(int));
+   for (i=0;i<cnt;i++)
+      start[segs.lev[i]+1]++;
+   for (k=0;k<nc;k++)
+      start[k+1]+=start[k];
+   for (i=0;i<cnt;i++)
+      ord[start[segs.lev[i]]++]=i;
+
+   if (stitchit){
+      stitch(&segs,nn,x,y,nc,ord,&vx,&vy,&lines);
+      plhs[0]=mxCreateDoubleMatrix(lines.npts+lines.nline,2,mxREAL); 
+      newcmat=mxGetPr(plhs[0]);
+      for (i=0;i<lines.npts+lines.nline;i++){
+         j=lines.pts[i];
+         newcmat[i]=j<0?mxGetNaN():vx[j];
+         newcmat[lines.npts+lines.nline+i]=j<0?mxGetNaN():vy[j];
+      }
+      if (nlhs>1){
+         plhs[1]=mxCreateDoubleMatrix(lines.nline,3,mxREAL); 
+         newlev=mxGetPr(plhs[1]);
+         for (k=0;k<lines.nline;k++)
+            for (j=0;j<3;j++)
+               newlev[lines.nline*j+k]=(double)lines.info[3*k+j];
+      }
+   }
+   else if(cnt!=0){
+      if (nlhs>1){
+         plhs[1]=mxCreateDoubleMatrix(cnt,1,mxREAL); 
+         newlev=mxGetPr(plhs[1]);
+         for (k=0;k<cnt;k++)
+            newlev[k]=(double)(segs.lev[ord[k]]+1);
+      }
+      /* ---- put the rows in level order where they are, and hand 
+              the segment list to plhs[0] as it stands ------------- */
+      mxEmitPermute(&segs.seg,ord);
+      plhs[0]=mxEmitArray(&segs.seg);
    }
    else {
       plhs[0]=mxCreateDoubleMatrix(1,1,mxREAL); 
       mxFree(mxGetPr(plhs[0])); 
       mxSetPr(plhs[0],NULL);  
+      if (nlhs>1)
+         plhs[1]=mxCreateDoubleMatrix(0,1,mxREAL); 
    }
          
 /* ---- No need to free memory allocated with "mxCalloc"; MATLAB 
    does this automatically.  The CMEX allocation functions in 
-   "opnml_allocs.c" use mxCalloc. ----------------------------------- */ 
+   "opnml_allocs.c" use mxCalloc.  Scratch is persistent, and is 
+   reused by the next call. ----------------------------------------- */ 
    return;   
 }
 
@@ -108,28 +250,35 @@ void mexFunction(int            nlhs,
 ----------------------------------------------------------------------*/
    
 #ifdef __STDC__
-   void isopts(int ne,
+   void isopts(int ne,int nn,
                double *x, double *y,
                int *ele,double *q,
-               double cval,
-               double **cmat,int *cnt)
+               int nc,cvlevel *cv,int nfin,
+               seglist *segs)
 #else
-   void isopts(ne,x,y,ele,q,cval,cmat,cnt)
-   int ne;
-   double *x, *y, *q,cval,**cmat;
-   int *ele,*cnt;
+   void isopts(ne,nn,x,y,ele,q,nc,cv,nfin,segs)
+   int ne,nn,nc,nfin;
+   double *x, *y, *q;
+   int *ele;
+   cvlevel *cv;
+   seglist *segs;
 #endif
 #define ELE(i,j,m) ele[i+m*j]
 #define TOL 1.e-10
+#define NODEKEY(a) ((long long)(a)*nn+(a))
+#define EDGEKEY(a,b) ((a)<(b)?(long long)(a)*nn+(b):(long long)(b)*nn+(a))
 {
 
 /* ---- ELE is defined to perform the following array 
         element extraction     ELE(i,j,m) ele[i+m*j] ---------------- */
-   int count=0,k;
+/* ---- NODEKEY and EDGEKEY name the mesh node or edge a segment 
+        endpoint lies on; they are only formed when stitching ------- */
+   int k,l,lo,hi,mid,lend,pass,keys=segs->key!=NULL;
+   long long ka=0,kb=0;
    int n0,n1,n2;
    double s0,s1,s2;
    double xa,xb,ya,yb;
-   double fac;
+   double fac,cval;
    double x0,x1,x2;
    double y0,y1,y2;
    
@@ -168,80 +317,297 @@ void mexFunction(int            nlhs,
       x2=x[n2];
       y2=y[n2];
       
-      if(cval<s0)goto L10;   /* cval < element min ------------------ */
-      if(cval>s2)goto L10;   /* cval > element max ------------------ */
-      
-      if (fabs(s0-s1)<TOL&&          /*  Contour on side n0 -> n1 --- */
-          fabs(s0-cval)<TOL){           
-         cmat[count][0]=x0;      
-         cmat[count][1]=y0;
-         cmat[count][2]=x1;
-         cmat[count][3]=y1;
-         count++;
-      }
-      else if (fabs(s1-s2)<TOL&&     /*  Contour on side n1 -> n2 --- */
-               fabs(s1-cval)<TOL){           
-         cmat[count][0]=x1;      
-         cmat[count][1]=y1; 
-         cmat[count][2]=x2;
-         cmat[count][3]=y2;
-         count++;
-      }
-      else if (fabs(s0-s2)<TOL&&     /*  Contour on side n2 -> n0 --- */
-               fabs(s2-cval)<TOL){           
-         cmat[count][0]=x2;      
-         cmat[count][1]=y2; 
-         cmat[count][2]=x0;
-         cmat[count][3]=y0;
-         count++;
+/* ---- Range of sorted contour values [l,lend) that can cross this
+        element.  With a NaN nodal value the range tests below are 
+        not ordered, so every value is visited, as a per-value call 
+        would. ----------------------------------------------------- */
+      if (s0==s0&&s1==s1&&s2==s2){
+         lo=0;
+         hi=nfin;
+         while (lo<hi){             /* first value with !(cval<s0) */
+            mid=(lo+hi)/2;
+            if (cv[mid].v<s0) lo=mid+1;
+            else hi=mid;
+         }
+         l=lo;
+         hi=nfin;
+         while (lo<hi){             /* first value with cval>s2 --- */
+            mid=(lo+hi)/2;
+            if (cv[mid].v>s2) hi=mid;
+            else lo=mid+1;
+         }
+         lend=lo;
       }
-      else if (fabs(s0-s2)<TOL){    /*  Contour over entire element - */
-         cmat[count][0]=x0;
-         cmat[count][1]=y0;
-         cmat[count][2]=x1;
-         cmat[count][3]=y1;
-         count++;
-         cmat[count][0]=x1;
-         cmat[count][1]=y1;
-         cmat[count][2]=x2;
-         cmat[count][3]=y2;
-         count++;
-         cmat[count][0]=x2;
-         cmat[count][1]=y2;
-         cmat[count][2]=x0;
-         cmat[count][3]=y0;
-         count++;
+      else {
+         l=0;
+         lend=nfin;
       }
-      else {                        /*  Contour within  element ----- */
-         fac=(cval-s0)/(s2-s0);
-         xa=x0+(x2-x0)*fac;
-         ya=y0+(y2-y0)*fac;
-         if(cval<s1){
-            if(s0!=s1) fac=(cval-s0)/(s1-s0);
-            else fac=1.0;
-            xb=x0+(x1-x0)*fac;
-            yb=y0+(y1-y0)*fac;
+      
+      for (pass=0;pass<2;pass++){
+         if (pass==1){              /* then any NaN contour values - */
+            l=nfin;
+            lend=nc;
+         }
+         for (;l<lend;l++){
+            cval=cv[l].v;
+      
+            if(cval<s0)continue;   /* cval < element min ---------- */
+            if(cval>s2)continue;   /* cval > element max ---------- */
+      
+            if (fabs(s0-s1)<TOL&&          /*  Contour on side n0 -> n1 */
+                fabs(s0-cval)<TOL){           
+               if (keys){ka=NODEKEY(n0);kb=NODEKEY(n1);}
+               addseg(segs,x0,y0,x1,y1,cv[l].i,ka,kb);
+            }
+            else if (fabs(s1-s2)<TOL&&     /*  Contour on side n1 -> n2 */
+                     fabs(s1-cval)<TOL){           
+               if (keys){ka=NODEKEY(n1);kb=NODEKEY(n2);}
+               addseg(segs,x1,y1,x2,y2,cv[l].i,ka,kb);
+            }
+            else if (fabs(s0-s2)<TOL&&     /*  Contour on side n2 -> n0 */
+                     fabs(s2-cval)<TOL){           
+               if (keys){ka=NODEKEY(n2);kb=NODEKEY(n0);}
+               addseg(segs,x2,y2,x0,y0,cv[l].i,ka,kb);
+            }
+            else if (fabs(s0-s2)<TOL){    /*  Contour over entire element */
+               addseg(segs,x0,y0,x1,y1,cv[l].i,NODEKEY(n0),NODEKEY(n1));
+               addseg(segs,x1,y1,x2,y2,cv[l].i,NODEKEY(n1),NODEKEY(n2));
+               addseg(segs,x2,y2,x0,y0,cv[l].i,NODEKEY(n2),NODEKEY(n0));
+            }
+            else {                        /*  Contour within element */
+               fac=(cval-s0)/(s2-s0);
+               xa=x0+(x2-x0)*fac;
+               ya=y0+(y2-y0)*fac;
+               if (keys)
+                  ka=fac==0.?NODEKEY(n0):fac==1.?NODEKEY(n2):EDGEKEY(n0,n2);
+               if(cval<s1){
+                  if(s0!=s1) fac=(cval-s0)/(s1-s0);
+                  else fac=1.0;
+                  xb=x0+(x1-x0)*fac;
+                  yb=y0+(y1-y0)*fac;
+                  if (keys)
+                     kb=fac==0.?NODEKEY(n0):fac==1.?NODEKEY(n1):EDGEKEY(n0,n1);
+               }
+               else{
+                  if(s1!=s2) fac=(cval-s1)/(s2-s1);
+                  else fac=1.0;
+                  xb=x1+(x2-x1)*fac;
+                  yb=y1+(y2-y1)*fac;
+                  if (keys)
+                     kb=fac==0.?NODEKEY(n1):fac==1.?NODEKEY(n2):EDGEKEY(n1,n2);
+               } 
+               addseg(segs,xa,ya,xb,yb,cv[l].i,ka,kb);
+            }
          }
-         else{
-            if(s1!=s2) fac=(cval-s1)/(s2-s1);
-            else fac=1.0;
-            xb=x1+(x2-x1)*fac;
-            yb=y1+(y2-y1)*fac;
-         } 
-         cmat[count][0]=xa;
-         cmat[count][1]=ya;
-         cmat[count][2]=xb;
-         cmat[count][3]=yb;
-         count++;
       }
-      L10: continue;
    }
-   *cnt=count;
    return;
 }
 
+/* ---- append one segment, doubling the list when it fills.  When
+        stitching, a segment with a non-finite endpoint (from an 
+        element with a NaN nodal value, i.e. dry) is dropped, so 
+        that it is neither keyed nor joined into a line ----------- */
+#ifdef __STDC__
+   void addseg(seglist *segs,
+               double xa,double ya,
+               double xb,double yb,
+               int lev,long long ka,long long kb)
+#else
+   void addseg(segs,xa,ya,xb,yb,lev,ka,kb)
+   seglist *segs;
+   double xa,ya,xb,yb;
+   int lev;
+   long long ka,kb;
+#endif
+{
+   size_t i;
+   if (segs->key&&!(mxIsFinite(xa)&&mxIsFinite(ya)&&
+                    mxIsFinite(xb)&&mxIsFinite(yb)))
+      return;
+   if (segs->cnt==segs->max){
+      segs->max*=2;
+      segs->lev=(int *)mxRealloc(segs->lev,segs->max*sizeof(int));
+      if (segs->key)
+         segs->key=(long long *)mxRealloc(segs->key,2*segs->max*sizeof(long long));
+   }
+   if (segs->key){
+      segs->key[2*segs->cnt]=ka;
+      segs->key[2*segs->cnt+1]=kb;
+   }
+   i=mxEmitRow(&segs->seg);
+   MXEMIT(&segs->seg,i,0)=xa;
+   MXEMIT(&segs->seg,i,1)=ya;
+   MXEMIT(&segs->seg,i,2)=xb;
+   MXEMIT(&segs->seg,i,3)=yb;
+   segs->lev[segs->cnt++]=lev;
+}
    
-   
-   
-   
-   
+/* ---- join the segments, taken in the level-grouped order ord, 
+        into polylines.  Endpoints with the same level and mesh key
+        are one vertex, so each level's segments form a graph; lines 
+        run between vertices whose degree is not 2, and the edges 
+        left over form closed rings.  vx,vy return the vertex 
+        coordinates; vertices at a node take the node's coordinates,
+        since x0+(x2-x0)*fac with fac=1 can differ from x2 in the 
+        last bit ---------------------------------------------------- */
+#ifdef __STDC__
+   void stitch(seglist *segs,
+               int nn,double *x,double *y,
+               int nc,int *ord,
+               double **vxp,double **vyp,
+               linelist *lines)
+#else
+   void stitch(segs,nn,x,y,nc,ord,vxp,vyp,lines)
+   seglist *segs;
+   int nn,nc,*ord;
+   double *x,*y,**vxp,**vyp;
+   linelist *lines;
+#endif
+{
+   int cnt=segs->cnt,nv=0,ned=0;
+   int i,j,k,e,v,va,vb,lev,vs,ve,es,ee;
+   int *vlev,*ea,*eb,*as,*adj,*used;
+   long long key;
+   double *vx,*vy;
+   mxI64Hash hv,he;
+
+   vx=(double *)mxArenaAlloc(&Scratch,(2*cnt+1)*sizeof(double));
+   vy=(double *)mxArenaAlloc(&Scratch,(2*cnt+1)*sizeof(double));
+   vlev=(int *)mxArenaAlloc(&Scratch,(2*cnt+1)*sizeof(int));
+   ea=(int *)mxArenaAlloc(&Scratch,(cnt+1)*sizeof(int));
+   eb=(int *)mxArenaAlloc(&Scratch,(cnt+1)*sizeof(int));
+   mxI64HashInit(&hv,2*cnt);
+   mxI64HashInit(&he,cnt);
+
+/* ---- number the vertices and keep each distinct segment once ---- */
+   for (k=0;k<cnt;k++){
+      i=ord[k];
+      lev=segs->lev[i];
+      for (j=0;j<2;j++){
+         key=segs->key[2*i+j];
+         v=mxI64HashInsert(&hv,key*nc+lev,nv);
+         if (v==nv){
+            if (key/nn==key%nn){
+               vx[nv]=x[key%nn];
+               vy[nv]=y[key%nn];
+            }
+            else {
+               vx[nv]=MXEMIT(&segs->seg,i,2*j);
+               vy[nv]=MXEMIT(&segs->seg,i,2*j+1);
+            }
+            vlev[nv]=lev;
+            nv++;
+         }
+         if (j==0) va=v;
+         else vb=v;
+      }
+      if (va==vb) continue;           /* zero length ------------- */
+      key=va<vb?(long long)va*2*cnt+vb:(long long)vb*2*cnt+va;
+      if (mxI64HashInsert(&he,key,ned)!=ned) continue;  /* duplicate */
+      ea[ned]=va;
+      eb[ned]=vb;
+      ned++;
+   }
+
+/* ---- vertex to edge adjacency, CSR style ------------------------ */
+   as=(int *)mxArenaCalloc(&Scratch,nv+2,sizeof(int));
+   adj=(int *)mxArenaAlloc(&Scratch,(2*ned+1)*sizeof(int));
+   used=(int *)mxArenaCalloc(&Scratch,ned+1,sizeof(int));
+   for (e=0;e<ned;e++){
+      as[ea[e]+1]++;
+      as[eb[e]+1]++;
+   }
+   for (v=0;v<nv;v++)
+      as[v+1]+=as[v];
+   for (e=0;e<ned;e++){
+      adj[as[ea[e]]++]=e;
+      adj[as[eb[e]]++]=e;
+   }
+   for (v=nv;v>0;v--)
+      as[v]=as[v-1];
+   as[0]=0;
+
+/* ---- each line contributes at most one point more than its 
+        edges, plus its NaN row ------------------------------------ */
+   lines->pts=(int *)mxArenaAlloc(&Scratch,(3*ned+1)*sizeof(int));
+   lines->info=(int *)mxArenaAlloc(&Scratch,(3*ned+1)*sizeof(int));
+   lines->npts=0;
+   lines->nline=0;
+
+/* ---- vertices and edges are numbered in level order, so walk one
+        level at a time to keep the lines grouped by level --------- */
+   vs=0;
+   es=0;
+   while (vs<nv){
+      lev=vlev[vs];
+      for (ve=vs;ve<nv&&vlev[ve]==lev;ve++);
+      for (ee=es;ee<ned&&vlev[ea[ee]]==lev;ee++);
+      for (v=vs;v<ve;v++){           /* open lines ---------------- */
+         if (as[v+1]-as[v]==2) continue;
+         for (k=as[v];k<as[v+1];k++)
+            if (!used[adj[k]])
+               walkline(v,adj[k],lev,ea,eb,as,adj,used,lines);
+      }
+      for (e=es;e<ee;e++)            /* closed rings -------------- */
+         if (!used[e])
+            walkline(ea[e],e,lev,ea,eb,as,adj,used,lines);
+      vs=ve;
+      es=ee;
+   }
+   *vxp=vx;
+   *vyp=vy;
+}
+
+/* ---- follow edges from vertex v0 along edge e through vertices of
+        degree 2, appending the line to lines ---------------------- */
+#ifdef __STDC__
+   void walkline(int v0,int e,int lev,
+                 int *ea,int *eb,int *as,int *adj,int *used,
+                 linelist *lines)
+#else
+   void walkline(v0,e,lev,ea,eb,as,adj,used,lines)
+   int v0,e,lev,*ea,*eb,*as,*adj,*used;
+   linelist *lines;
+#endif
+{
+   int p=lines->npts+lines->nline,n=1,v=v0,w;
+   lines->pts[p++]=v0;
+   for (;;){
+      used[e]=1;
+      w=ea[e]==v?eb[e]:ea[e];
+      lines->pts[p++]=w;
+      n++;
+      if (w==v0||as[w+1]-as[w]!=2) break;
+      e=adj[as[w]]==e?adj[as[w]+1]:adj[as[w]];
+      if (used[e]) break;
+      v=w;
+   }
+   lines->pts[p]=-1;
+   lines->info[3*lines->nline]=lev+1;
+   lines->info[3*lines->nline+1]=n;
+   lines->info[3*lines->nline+2]=w==v0;
+   lines->npts+=n;
+   lines->nline++;
+}
+
+/* ---- qsort comparison: ascending value, NaN last, ties by position 
+        in cval --------------------------------------------------- */
+#ifdef __STDC__
+   int cvcomp(const void *a,const void *b)
+#else
+   int cvcomp(a,b)
+   void *a,*b;
+#endif
+{
+   const cvlevel *ca=(const cvlevel *)a;
+   const cvlevel *cb=(const cvlevel *)b;
+   int na=ca->v!=ca->v,nb=cb->v!=cb->v;
+   if (na!=nb) return na-nb;
+   if (!na){
+      if (ca->v<cb->v) return -1;
+      if (ca->v>cb->v) return 1;
+   }
+   return ca->i-cb->i;
+}
+   
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include <math.h>
+#include <stdio.h>
+#include "mex.h"
+#include "opnml_mex5_allocs.c"
+
+#define ELE(i,j,m) ele[(i)+(m)*(j)]
+
+/* PROTOTYPES */
+int ele2nei(int,int,int *,double *,double *,int *,int *,double *);
+
+/************************************************************
+
+  ####     ##     #####  ######  #    #    ##     #   #
+ #    #   #  #      #    #       #    #   #  #     # #
+ #       #    #     #    #####   #    #  #    #     #
+ #  ###  ######     #    #       # ## #  ######     #
+ #    #  #    #     #    #       ##  ##  #    #     #
+  ####   #    #     #    ######  #    #  #    #     #
+
+************************************************************/
+
+void mexFunction(int            nlhs,
+                 mxArray       *plhs[],
+		 int            nrhs,
+		 const mxArray *prhs[])
+{
+
+/* ---- ele2neimex5 will be called as :
+        nei=ele2neimex5(e,x,y);
+
+        The neighbor list of the triangular grid e (ne x 3) on the
+        nodes x,y: row i of nei (nn x maxnei) is the nodes sharing
+        an edge with node i, in counter-clockwise order about it,
+        padded with 0, as in a .nei file.  The nodes of each node's
+        elements are gathered by one count, prefix sum and fill over
+        the elements, then sorted by angle, which also drops the
+        repeats (each interior edge is on two elements).  --------- */
+
+   int i,k,nn,ne,maxnei,*ele,*start,*adj;
+   double *dele,*x,*y,*nei,*ang;
+
+/* ---- check I/O arguments ----------------------------------------- */
+   if (nrhs != 3)
+      mexErrMsgTxt("ele2neimex5 requires 3 input arguments.");
+   else if (nlhs > 1)
+      mexErrMsgTxt("ele2neimex5 requires 1 output argument.");
+
+/* ---- dereference input arrays ------------------------------------ */
+   dele=mxGetPr(prhs[0]);
+   x=mxGetPr(prhs[1]);
+   y=mxGetPr(prhs[2]);
+   ne=mxGetM(prhs[0]);
+   nn=mxGetNumberOfElements(prhs[1]);
+   if (mxGetN(prhs[0]) != 3)
+      mexErrMsgTxt("Element list to ele2neimex5 must be ne x 3.");
+   if (mxGetNumberOfElements(prhs[2]) != (mwSize)nn)
+      mexErrMsgTxt("x,y to ele2neimex5 must be the same length.");
+
+   ele=(int *)mxIvector(0,IMAX(3*ne,1)-1);
+   for (i=0;i<3*ne;i++){
+      ele[i]=((int)dele[i])-1;
+      if (ele[i]<0 || ele[i]>=nn)
+         mexErrMsgTxt("Element list references nodes not in x,y.");
+   }
+
+/* ---- each element gives each of its nodes the other two ---------- */
+   start=(int *)mxIvector(0,nn);
+   adj=(int *)mxIvector(0,IMAX(6*ne,1)-1);
+   ang=(double *)mxDvector(0,IMAX(6*ne,1)-1);
+   maxnei=ele2nei(nn,ne,ele,x,y,start,adj,ang);
+
+   plhs[0]=mxCreateDoubleMatrix(nn,maxnei,mxREAL);
+   nei=mxGetPr(plhs[0]);
+   for (i=0;i<nn;i++)
+      for (k=start[i];k<start[i+1];k++)
+         nei[i+nn*(k-start[i])]=(double)(adj[k]+1);
+
+   mxFree(ele);
+   mxFree(adj);
+   mxFree(ang);
+   mxFree(start);
+   return;
+}
+
+/*----------------------------------------------------------------------
+
+  ######  #       ######   #####  #    #  ######     #
+  #       #       #       #     # ##   #  #          #
+  #####   #       #####        #  # #  #  #####      #
+  #       #       #          #    #  # #  #          #
+  #       #       #        #      #   ##  #          #
+  ######  ######  ######  ####### #    #  ######     #
+
+  Fills start (nn+1) and adj with each node's neighbors, sorted by
+  angle and without repeats, and returns the most of any node.
+  adj and ang are 6*ne long; the lists are compacted in place.
+----------------------------------------------------------------------*/
+
+#ifdef __STDC__
+int ele2nei(int nn,int ne,int *ele,double *x,double *y,
+            int *start,int *adj,double *ang)
+#else
+int ele2nei(nn,ne,ele,x,y,start,adj,ang)
+int nn,ne,*ele,*start,*adj;
+double *x,*y,*ang;
+#endif
+{
+   int i,j,k,a,m,n,p,t,maxnei=0,*fill;
+   double s;
+
+   for (i=0;i<3*ne;i++) start[ele[i]+1]+=2;
+   for (i=0;i<nn;i++) start[i+1]+=start[i];
+   fill=(int *)mxIvector(0,IMAX(nn,1)-1);
+   for (k=0;k<ne;k++)
+      for (j=0;j<3;j++){
+         a=ELE(k,j,ne);
+         adj[start[a]+fill[a]++]=ELE(k,(j+1)%3,ne);
+         adj[start[a]+fill[a]++]=ELE(k,(j+2)%3,ne);
+      }
+   mxFree(fill);
+
+   /* ---- sort each list by angle, drop repeats, compact ---- */
+   p=0;
+   for (i=0;i<nn;i++){
+      m=start[i];
+      n=start[i+1]-m;
+      for (k=0;k<n;k++)
+         ang[m+k]=atan2(y[adj[m+k]]-y[i],x[adj[m+k]]-x[i]);
+      for (k=1;k<n;k++){
+         s=ang[m+k];
+         t=adj[m+k];
+         for (j=k-1;j>=0 && (ang[m+j]>s || (ang[m+j]==s && adj[m+j]>t));j--){
+            ang[m+j+1]=ang[m+j];
+            adj[m+j+1]=adj[m+j];
+         }
+         ang[m+j+1]=s;
+         adj[m+j+1]=t;
+      }
+      start[i]=p;
+      for (k=0;k<n;k++)
+         if (k==0 || adj[m+k]!=adj[m+k-1])
+            adj[p++]=adj[m+k];
+      if (p-start[i]>maxnei) maxnei=p-start[i];
+   }
+   start[nn]=p;
+   return(maxnei);
+}
@@ -0,0 +1,278 @@
+#include <math.h>
+#include <stdio.h>
+#include "mex.h"
+#include "opnml_mex5_allocs.c"
+
+/* ---- statistic codes; ops(:,1) ---------------------------------- */
+#define ENS_MEAN    1
+#define ENS_MIN     2
+#define ENS_MAX     3
+#define ENS_STD     4
+#define ENS_PRCTILE 5
+#define ENS_EXCEED  6
+#define ENS_COUNT   7
+
+/* ---- nodes per block; a block of all members is transposed into
+        a node-major buffer that stays in cache while every statistic
+        is taken from it ------------------------------------------- */
+#define ENSBLOCK 256
+
+/* PROTOTYPES */
+void ensstat(int,int,double **,double *,int,double *,double *,double *);
+void enssort(int,double *);
+
+/************************************************************
+
+  ####     ##     #####  ######  #    #    ##     #   #
+ #    #   #  #      #    #       #    #   #  #     # #
+ #       #    #     #    #####   #    #  #    #     #
+ #  ###  ######     #    #       # ## #  ######     #
+ #    #  #    #     #    #       ##  ##  #    #     #
+  ####   #    #     #    ######  #    #  #    #     #
+
+************************************************************/
+
+void mexFunction(int            nlhs,
+                 mxArray       *plhs[],
+		 int            nrhs,
+		 const mxArray *prhs[])
+{
+
+/* ---- ensstatmex5 will be called as :
+        S=ensstatmex5(Z,ops);
+     or S=ensstatmex5(Z,ops,z);
+
+        Nodal statistics over the ensemble members Z, a cell of nm
+        nodal vectors (or an nn x nm matrix, one column per member),
+        all taken in one pass over the members.  ops is k x 2, one
+        row [code param] per column of S (nn x k):
+           1  mean               4  standard deviation
+           2  minimum            5  param'th percentile (0-100), as
+           3  maximum               PRCTILE
+           6  fraction of the nm members above param; members that
+              are NaN at a node (dry) count as not above it
+           7  number of members that are not NaN at a node
+        Other statistics ignore NaN members, and are NaN at nodes
+        where all members are.  With the nodal depths z, each member
+        value is first made the inundation depth, value+z where z<0
+        and NaN elsewhere (as ComputeInundation).  Member values are
+        never copied whole; they are read in blocks of nodes.  ---- */
+
+   mwSize nn,nm,nops,i,j;
+   int iscell;
+   double *ops,*z=NULL,*S,**zz;
+   const mxArray *Zi;
+
+/* ---- check I/O arguments ----------------------------------------- */
+   if (nrhs != 2 && nrhs != 3)
+      mexErrMsgTxt("ensstatmex5 requires 2 or 3 input arguments.");
+   else if (nlhs > 1)
+      mexErrMsgTxt("ensstatmex5 requires 1 output argument.");
+
+   iscell=mxIsCell(prhs[0]);
+   if (iscell){
+      nm=mxGetNumberOfElements(prhs[0]);
+      nn=nm>0 && mxGetCell(prhs[0],0) ? mxGetNumberOfElements(mxGetCell(prhs[0],0)) : 0;
+   }
+   else {
+      nn=mxGetM(prhs[0]);
+      nm=mxGetN(prhs[0]);
+   }
+   if (nm<1)
+      mexErrMsgTxt("Z to ensstatmex5 has no members.");
+
+   nops=mxGetM(prhs[1]);
+   if (nops<1 || mxGetN(prhs[1]) != 2)
+      mexErrMsgTxt("ops to ensstatmex5 must be k x 2, [code param].");
+   ops=mxGetPr(prhs[1]);
+   for (j=0;j<nops;j++)
+      if (ops[j]<ENS_MEAN || ops[j]>ENS_COUNT)
+         mexErrMsgTxt("Unknown statistic code in ops to ensstatmex5.");
+
+   if (nrhs == 3){
+      if (mxGetNumberOfElements(prhs[2]) != nn)
+         mexErrMsgTxt("z to ensstatmex5 must be the length of the members.");
+      z=mxGetPr(prhs[2]);
+   }
+
+/* ---- dereference the members ------------------------------------- */
+   zz=(double **)mxCalloc(nm,sizeof(double *));
+   for (i=0;i<nm;i++){
+      if (iscell){
+         Zi=mxGetCell(prhs[0],i);
+         if (Zi==NULL || !mxIsDouble(Zi) || mxIsComplex(Zi) ||
+             mxGetNumberOfElements(Zi) != nn)
+            mexErrMsgTxt("Members of Z to ensstatmex5 must be real double vectors of one length.");
+         zz[i]=mxGetPr(Zi);
+      }
+      else {
+         if (!mxIsDouble(prhs[0]) || mxIsComplex(prhs[0]))
+            mexErrMsgTxt("Z to ensstatmex5 must be real double.");
+         zz[i]=mxGetPr(prhs[0])+(size_t)nn*i;
+      }
+   }
+
+   plhs[0]=mxCreateDoubleMatrix(nn,nops,mxREAL);
+   S=mxGetPr(plhs[0]);
+
+   ensstat(nn,nm,zz,z,nops,ops,ops+nops,S);
+
+   mxFree(zz);
+   return;
+}
+
+/*----------------------------------------------------------------------
+
+  ######  #    #   ####    ####    #####    ##     #####
+  #       ##   #  #       #          #     #  #      #
+  #####   # #  #   ####    ####      #    #    #     #
+  #       #  # #       #       #     #    ######     #
+  #       #   ##  #    #  #    #     #    #    #     #
+  ######  #    #   ####    ####      #    #    #     #
+
+----------------------------------------------------------------------*/
+
+#ifdef __STDC__
+void ensstat(int nn,int nm,double **zz,double *z,int nops,
+             double *code,double *param,double *S)
+#else
+void ensstat(nn,nm,zz,z,nops,code,param,S)
+int nn,nm,nops;
+double **zz,*z,*code,*param,*S;
+#endif
+{
+   int b,nb,i,j,k,n,nsort,nstd,lo;
+   double *buf,*v,*srt,q,d,sum,ss,mn,mx,pos,NaN=mxGetNaN();
+
+   /* only the percentiles need the members in order, and only the
+      standard deviation a second pass */
+   nsort=nstd=0;
+   for (j=0;j<nops;j++){
+      if ((int)code[j]==ENS_PRCTILE) nsort=1;
+      if ((int)code[j]==ENS_STD) nstd=1;
+   }
+
+   buf=(double *)mxDvector(0,ENSBLOCK*nm-1);
+   srt=(double *)mxDvector(0,nm-1);
+
+   for (b=0;b<nn;b+=ENSBLOCK){
+      nb=nn-b<ENSBLOCK ? nn-b : ENSBLOCK;
+
+      /* ---- member-major in, node-major in the buffer ---- */
+      for (k=0;k<nm;k++){
+         v=zz[k]+b;
+         for (i=0;i<nb;i++){
+            q=v[i];
+            if (z)
+               q=z[b+i]<0. ? q+z[b+i] : NaN;
+            buf[i*nm+k]=q;
+         }
+      }
+
+      for (i=0;i<nb;i++){
+         v=buf+i*nm;
+
+         /* ---- one pass for the mean and extremes ---- */
+         n=0;
+         sum=0.;
+         mn=mxGetInf();
+         mx=-mn;
+         for (k=0;k<nm;k++){
+            q=v[k];
+            if (q!=q) continue;
+            if (nsort) srt[n]=q;
+            n++;
+            sum+=q;
+            if (q<mn) mn=q;
+            if (q>mx) mx=q;
+         }
+         if (nsort && n>1) enssort(n,srt);
+
+         /* ---- squares about the mean in a second pass over the
+                 buffer; sum2-sum*sum/n cancels to noise, or below
+                 zero, where the spread is small against the mean ---- */
+         ss=0.;
+         if (nstd && n>1){
+            q=sum/n;
+            for (k=0;k<nm;k++){
+               if (v[k]!=v[k]) continue;
+               d=v[k]-q;
+               ss+=d*d;
+            }
+         }
+
+         for (j=0;j<nops;j++){
+            switch ((int)code[j]){
+               case ENS_MEAN:
+                  q=n ? sum/n : NaN;
+                  break;
+               case ENS_MIN:
+                  q=n ? mn : NaN;
+                  break;
+               case ENS_MAX:
+                  q=n ? mx : NaN;
+                  break;
+               case ENS_STD:
+                  /* sample standard deviation, as STD */
+                  if (n==0)
+                     q=NaN;
+                  else if (n==1)
+                     q=0.;
+                  else
+                     q=ss>0. ? sqrt(ss/(n-1)) : 0.;
+                  break;
+               case ENS_PRCTILE:
+                  /* the k'th of n sorted values is the 100*(k-.5)/n
+                     percentile, linear between, flat beyond */
+                  if (n==0){
+                     q=NaN;
+                     break;
+                  }
+                  pos=param[j]/100.*n-.5;
+                  if (pos<=0.)
+                     q=srt[0];
+                  else if (pos>=n-1)
+                     q=srt[n-1];
+                  else {
+                     lo=(int)pos;
+                     q=srt[lo]+(pos-lo)*(srt[lo+1]-srt[lo]);
+                  }
+                  break;
+               case ENS_EXCEED:
+                  q=0.;
+                  for (k=0;k<nm;k++)
+                     if (v[k]>param[j]) q+=1.;
+                  q/=nm;
+                  break;
+               case ENS_COUNT:
+                  q=(double)n;
+                  break;
+               default:
+                  q=NaN;
+            }
+            S[b+i+(size_t)nn*j]=q;
+         }
+      }
+   }
+
+   mxFree(buf);
+   mxFree(srt);
+}
+
+/* ---- insertion sort; ensembles are tens of members --------------- */
+#ifdef __STDC__
+void enssort(int n,double *a)
+#else
+void enssort(n,a)
+int n;
+double *a;
+#endif
+{
+   int i,k;
+   double t;
+   for (i=1;i<n;i++){
+      t=a[i];
+      for (k=i-1;k>=0 && a[k]>t;k--) a[k+1]=a[k];
+      a[k+1]=t;
+   }
+}
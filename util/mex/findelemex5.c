@@ -2,6 +2,27 @@
 #include <stdio.h>
 #include "mex.h"
 #include "opnml_mex5_allocs.c"
+#include "opnml_mex5_arena.c"
+
+/* PROTOTYPES */
+int  inelem(int,double,double,double *,double *,double *,double *,
+            int,double,double);
+void buildindex(int,double *,double *,double *,double *,double,
+                mxArray **);
+void findindexed(int,double *,double *,double *,double *,double *,
+                 double *,int,double,const mxArray *,double *);
+void findwalk(int,double *,double *,double *,double *,double *,
+              double *,int,double,const mxArray *,int *,double *);
+
+/* ---- fields of the element index structure returned by
+        idx=findelemex5('index',AR,A,B,T,tolerance) ---------------- */
+static const char *IndexFields[]={"bbox","nbins","tol","ne",
+                                  "start","list","unbinned"};
+
+/* ---- scratch kept from call to call, for the int copy of double
+        element neighbors when a track is walked a piece at a time - */
+static mxArena Scratch=MXARENA_PERSISTENT;
+static void FreeScratch(void) { mxArenaFree(&Scratch); }
 
 /************************************************************
 
@@ -19,6 +40,8 @@
 #define AA(i,j,m) A[i+m*j]
 #define BB(i,j,m) B[i+m*j]
 #define TT(i,j,m) T[i+m*j]
+/* ---- true for finite doubles; mx* calls are avoided in threads ---- */
+#define ISFINITE(a) ((a)-(a)==0.)
 
 void mexFunction(int            nlhs,
                  mxArray       *plhs[],
@@ -27,23 +50,45 @@ void mexFunction(int            nlhs,
 {
 
 /* ---- findelemex will be called as :
-        j_el=findelemex(xp,yp,AR,A,B,T); ---------------------------- */
+        j_el=findelemex(xp,yp,AR,A,B,T,tolerance);
+     or, to build a bucket index over the elements, once per grid :
+        idx=findelemex('index',AR,A,B,T,tolerance);
+     and then to search only the elements in each point's bucket :
+        j_el=findelemex(xp,yp,AR,A,B,T,tolerance,idx);
+     or, for a sequence of nearby points (a track or transect), to
+     walk from each point's element to the next across the element
+     neighbors ee (ne x 3, as gridtopomex5 .ee), with idx ([] for
+     none) used only when a walk leaves the grid :
+        j_el=findelemex(xp,yp,AR,A,B,T,tolerance,idx,ee); ---------- */
 /* ---- xp,yp are NOT nodal coordinates; they are the points we are 
         finding elements for.  Nodal coordinates have already been 
         accounted for in A,B,T                                      ----- */
 
-   int ip,j,np,nl,nh,ne;
+   int ip,j,np,ne;
    double *xp, *yp;
    double *AR,*A,*B,*T;
    double *fnd;
    double NaN=mxGetNaN();
-   double fac,S1,S2,S3,ONE,ZERO;
+   double ONE,ZERO;
    double tol,*tolerance;
+   int *ee;
+   const mxArray *idx=NULL;
 
+/* ---- index build mode -------------------------------------------- */
+   if (nrhs > 0 && mxIsChar(prhs[0])){
+      if (nrhs != 6)
+         mexErrMsgTxt("findelemex5('index',...) requires 6 input arguments.");
+      else if (nlhs != 1)
+         mexErrMsgTxt("findelemex5('index',...) requires 1 output argument.");
+      ne=mxGetM(prhs[1]);
+      buildindex(ne,mxGetPr(prhs[1]),mxGetPr(prhs[2]),mxGetPr(prhs[3]),
+                 mxGetPr(prhs[4]),mxGetScalar(prhs[5]),&plhs[0]);
+      return;
+   }
      
 /* ---- check I/O arguments ----------------------------------------- */
-   if (nrhs != 7) 
-      mexErrMsgTxt("findelemex requires 7 input arguments.");
+   if (nrhs < 7 || nrhs > 9)
+      mexErrMsgTxt("findelemex requires 7, 8 or 9 input arguments.");
    else if (nlhs != 1) 
       mexErrMsgTxt("findelemex requires 1 output arguments.");
 
@@ -61,37 +106,361 @@ void mexFunction(int            nlhs,
    np=mxGetM(prhs[0]);
    ne=mxGetM(prhs[2]);   
    
-/* ---- allocate space for list containing element numbers following NRC 
-        allocation style
-        double *mxDvector(int nl,int nh)
-        fnd= (double *) mxDvector(0,np); ---------------------------- */
-   fnd= (double *) mxDvector(0,np);
+/* ---- the element numbers are found straight into the returned
+        matrix, pointed to by plhs[0] ------------------------------- */
+   plhs[0]=mxCreateDoubleMatrix(np,1,mxREAL); 
+   fnd=mxGetPr(plhs[0]);
    for (ip=0;ip<np;ip++)fnd[ip]=-1.;
+
+/* ---- the element index, if given; it must have been built with
+        atleast this tolerance, otherwise fall through to the full
+        search -------------------------------------------------------- */
+   if (nrhs >= 8 && mxIsStruct(prhs[7]) &&
+       mxGetField(prhs[7],0,"unbinned") != NULL &&
+       (int)mxGetScalar(mxGetField(prhs[7],0,"ne")) == ne &&
+       tol <= mxGetScalar(mxGetField(prhs[7],0,"tol")))
+      idx=prhs[7];
+
+/* ---- walking search ---------------------------------------------- */
+   if (nrhs == 9){
+      if (mxGetM(prhs[8]) != (mwSize)ne || mxGetN(prhs[8]) != 3)
+         mexErrMsgTxt("Element neighbors to findelemex must be ne x 3.");
+      if (mxIsInt32(prhs[8]))
+         ee=(int *)mxGetData(prhs[8]);
+      else {
+         mexAtExit(FreeScratch);
+         mxArenaReset(&Scratch);
+         ee=(int *)mxArenaAlloc(&Scratch,3*(size_t)ne*sizeof(int));
+         for (j=0;j<3*ne;j++) ee[j]=(int)mxGetPr(prhs[8])[j];
+      }
+      findwalk(np,xp,yp,AR,A,B,T,ne,tol,idx,ee,fnd);
+      goto l30;
+   }
+
+/* ---- indexed search ---------------------------------------------- */
+   if (idx){
+      findindexed(np,xp,yp,AR,A,B,T,ne,tol,idx,fnd);
+      goto l30;
+   }
+
+/* ---- point-parallel search.  Each point scans the elements in order
+        and stops at the first one that contains it, which is the
+        element the element-outer sweep would have given it.  Points
+        are independent, so they are split over the available cores
+        when compiled with OpenMP (see makemex). ------------------ */
    ONE=1.+tol;
    ZERO=0.-tol;
-   for (j=0;j<ne;j++){
-      for (ip=0;ip<np;ip++){  
-         if(fnd[ip]<(double)0){
-            fac=.5/AR[j];         
-            S1=(TT(j,0,ne)+BB(j,0,ne)*xp[ip]+AA(j,0,ne)*yp[ip])*fac;
-            if (S1>ONE|S1<ZERO)goto l20;
-            S2=(TT(j,1,ne)+BB(j,1,ne)*xp[ip]+AA(j,1,ne)*yp[ip])*fac;
-            if (S2>ONE|S2<ZERO)goto l20;
-            S3=(TT(j,2,ne)+BB(j,2,ne)*xp[ip]+AA(j,2,ne)*yp[ip])*fac;
-            if (S3>ONE|S3<ZERO)goto l20;         
-            fnd[ip]=(double)(j+1);            
+#pragma omp parallel for private(j) schedule(dynamic,16)
+   for (ip=0;ip<np;ip++){
+      for (j=0;j<ne;j++){
+         if (inelem(j,xp[ip],yp[ip],AR,A,B,T,ne,ONE,ZERO)){
+            fnd[ip]=(double)(j+1);
+            break;
          }
-       l20: continue;
-       }
-    }
+      }
+   }
+ l30:
     for (ip=0;ip<np;ip++) if(fnd[ip]<(double)0)fnd[ip]=NaN;
-               
-/* ---- Set elements of return matrix, pointed to by plhs[0] -------- */
-   plhs[0]=mxCreateDoubleMatrix(np,1,mxREAL); 
-   mxSetPr(plhs[0],fnd);
 
 /* ---- No need to free memory allocated with "mxCalloc"; MATLAB 
    does this automatically.  The CMEX allocation functions in 
    "opnml_allocs.c" use mxCalloc. ----------------------------------- */ 
    return;   
 }
+
+/*----------------------------------------------------------------------
+
+    #    #    #  ######  #       ######  #    #
+    #    ##   #  #       #       #       ##  ##
+    #    # #  #  #####   #       #####   # ## #
+    #    #  # #  #       #       #       #    #
+    #    #   ##  #       #       #       #    #
+    #    #    #  ######  ######  ######  #    #
+
+  Returns 1 if (xp,yp) is in element j, using the same basis function
+  test (and the same order of operations) as the full search above.
+----------------------------------------------------------------------*/
+int inelem(int j,double xp,double yp,
+           double *AR,double *A,double *B,double *T,
+           int ne,double ONE,double ZERO)
+{
+   double fac,S1,S2,S3;
+   fac=.5/AR[j];
+   S1=(TT(j,0,ne)+BB(j,0,ne)*xp+AA(j,0,ne)*yp)*fac;
+   if ((S1>ONE)||(S1<ZERO)) return(0);
+   S2=(TT(j,1,ne)+BB(j,1,ne)*xp+AA(j,1,ne)*yp)*fac;
+   if ((S2>ONE)||(S2<ZERO)) return(0);
+   S3=(TT(j,2,ne)+BB(j,2,ne)*xp+AA(j,2,ne)*yp)*fac;
+   if ((S3>ONE)||(S3<ZERO)) return(0);
+   return(1);
+}
+
+/*----------------------------------------------------------------------
+
+  #####   #    #     #    #       #####      #    #    #  #####   #    #
+  #    #  #    #     #    #       #    #     #    ##   #  #    #   #  #
+  #####   #    #     #    #       #    #     #    # #  #  #    #    ##
+  #    #  #    #     #    #       #    #     #    #  # #  #    #    ##
+  #    #  #    #     #    #       #    #     #    #   ##  #    #   #  #
+  #####    ####      #    ######  #####      #    #    #  #####   #    #
+
+  Uniform bucket grid over the element bounding boxes.  The vertices
+  of each element are recovered from the basis function coefficients
+  (vertex k is where the other two basis functions vanish), and the
+  bounding box is padded so that every point passing the toleranced
+  basis test lands in a bucket containing that element.  Elements are
+  stored in CSR form (start,list), in increasing element number within
+  each bucket, so that the first element found for a point is the same
+  one the full search finds.  Elements whose box is not finite (zero
+  area) are kept in a separate "unbinned" list tested for every point.
+----------------------------------------------------------------------*/
+void buildindex(int ne,double *AR,double *A,double *B,double *T,
+                double tol,mxArray **idx)
+{
+   int i,j,k,k1,k2,nx,ny,nb,nglob,ix,iy,ix1,ix2,iy1,iy2;
+   int *cnt,*start,*list,*glob,*box;
+   double det,vx,vy,pad,xmin,xmax,ymin,ymax;
+   double X0,Y0,X1,Y1,DX,DY;
+   double *bb,*ebox;
+   mxArray *fld;
+
+   ebox=(double *)mxDvector(0,4*ne-1);
+   box =(int *)   mxIvector(0,4*ne-1);
+
+/* ---- element bounding boxes from the basis coefficients ---------- */
+   X0=Y0=mxGetInf();
+   X1=Y1=-mxGetInf();
+   nglob=0;
+   for (j=0;j<ne;j++){
+      xmin=ymin=mxGetInf();
+      xmax=ymax=-mxGetInf();
+      for (k=0;k<3;k++){
+         k1=(k+1)%3;
+         k2=(k+2)%3;
+         det=BB(j,k1,ne)*AA(j,k2,ne)-AA(j,k1,ne)*BB(j,k2,ne);
+         vx=(AA(j,k1,ne)*TT(j,k2,ne)-AA(j,k2,ne)*TT(j,k1,ne))/det;
+         vy=(BB(j,k2,ne)*TT(j,k1,ne)-BB(j,k1,ne)*TT(j,k2,ne))/det;
+         xmin=DMIN(xmin,vx); xmax=DMAX(xmax,vx);
+         ymin=DMIN(ymin,vy); ymax=DMAX(ymax,vy);
+      }
+      /* the toleranced element is the element scaled by (1+3*tol)
+         about its centroid; pad a bit more than that */
+      pad=4.*(tol+1.e-12)*DMAX(xmax-xmin,ymax-ymin);
+      ebox[4*j  ]=xmin-pad;
+      ebox[4*j+1]=xmax+pad;
+      ebox[4*j+2]=ymin-pad;
+      ebox[4*j+3]=ymax+pad;
+      if (!(mxIsFinite(ebox[4*j])&&mxIsFinite(ebox[4*j+1])&&
+            mxIsFinite(ebox[4*j+2])&&mxIsFinite(ebox[4*j+3])&&
+            AR[j]!=0.)){
+         ebox[4*j]=mxGetNaN();
+         nglob++;
+         continue;
+      }
+      X0=DMIN(X0,ebox[4*j  ]);
+      X1=DMAX(X1,ebox[4*j+1]);
+      Y0=DMIN(Y0,ebox[4*j+2]);
+      Y1=DMAX(Y1,ebox[4*j+3]);
+   }
+   if (!(X1>X0)) {X0=0.;X1=1.;}
+   if (!(Y1>Y0)) {Y0=0.;Y1=1.;}
+
+/* ---- about one element per bucket, shaped like the domain -------- */
+   nx=(int)ceil(sqrt((double)ne*(X1-X0)/(Y1-Y0)));
+   nx=IMAX(1,IMIN(nx,ne));
+   ny=IMAX(1,(int)ceil((double)ne/(double)nx));
+   nb=nx*ny;
+   DX=(X1-X0)/nx;
+   DY=(Y1-Y0)/ny;
+
+/* ---- count, prefix sum, fill ------------------------------------- */
+   cnt=(int *)mxIvector(0,nb);
+   glob=(int *)mxIvector(0,IMAX(nglob,1)-1);
+   nglob=0;
+   for (j=0;j<ne;j++){
+      if (mxIsNaN(ebox[4*j])){
+         glob[nglob++]=j+1;
+         continue;
+      }
+      ix1=IMIN(nx-1,(int)((ebox[4*j  ]-X0)/DX));
+      ix2=IMIN(nx-1,(int)((ebox[4*j+1]-X0)/DX));
+      iy1=IMIN(ny-1,(int)((ebox[4*j+2]-Y0)/DY));
+      iy2=IMIN(ny-1,(int)((ebox[4*j+3]-Y0)/DY));
+      box[4*j]=ix1;box[4*j+1]=ix2;box[4*j+2]=iy1;box[4*j+3]=iy2;
+      for (iy=iy1;iy<=iy2;iy++)
+         for (ix=ix1;ix<=ix2;ix++)
+            cnt[iy*nx+ix]++;
+   }
+
+   fld=mxCreateNumericMatrix(nb+1,1,mxINT32_CLASS,mxREAL);
+   start=(int *)mxGetData(fld);
+   start[0]=0;
+   for (i=0;i<nb;i++) start[i+1]=start[i]+cnt[i];
+   for (i=0;i<nb;i++) cnt[i]=start[i];
+
+   *idx=mxCreateStructMatrix(1,1,7,IndexFields);
+   mxSetField(*idx,0,"start",fld);
+   fld=mxCreateNumericMatrix(IMAX(start[nb],1),1,mxINT32_CLASS,mxREAL);
+   list=(int *)mxGetData(fld);
+   mxSetField(*idx,0,"list",fld);
+   for (j=0;j<ne;j++){
+      if (mxIsNaN(ebox[4*j])) continue;
+      for (iy=box[4*j+2];iy<=box[4*j+3];iy++)
+         for (ix=box[4*j];ix<=box[4*j+1];ix++)
+            list[cnt[iy*nx+ix]++]=j+1;
+   }
+
+   fld=mxCreateNumericMatrix(nglob,1,mxINT32_CLASS,mxREAL);
+   for (i=0;i<nglob;i++) ((int *)mxGetData(fld))[i]=glob[i];
+   mxSetField(*idx,0,"unbinned",fld);
+
+   fld=mxCreateDoubleMatrix(1,4,mxREAL);
+   bb=mxGetPr(fld);
+   bb[0]=X0;bb[1]=Y0;bb[2]=DX;bb[3]=DY;
+   mxSetField(*idx,0,"bbox",fld);
+   fld=mxCreateDoubleMatrix(1,2,mxREAL);
+   bb=mxGetPr(fld);
+   bb[0]=(double)nx;bb[1]=(double)ny;
+   mxSetField(*idx,0,"nbins",fld);
+   mxSetField(*idx,0,"tol",mxCreateDoubleScalar(tol));
+   mxSetField(*idx,0,"ne",mxCreateDoubleScalar((double)ne));
+   return;
+}
+
+/*----------------------------------------------------------------------
+
+  ######     #    #    #  #####      #    #    #  #####   ######  #    #
+  #          #    ##   #  #    #     #    ##   #  #    #  #        #  #
+  #####      #    # #  #  #    #     #    # #  #  #    #  #####     ##
+  #          #    #  # #  #    #     #    #  # #  #    #  #         ##
+  #          #    #   ##  #    #     #    #   ##  #    #  #        #  #
+  #          #    #    #  #####      #    #    #  #####   ######  #    #
+
+  Search only the elements in the point's bucket, merged in element
+  order with the unbinned list.  fnd[ip] is left <0 if not found.
+----------------------------------------------------------------------*/
+void findindexed(int np,double *xp,double *yp,
+                 double *AR,double *A,double *B,double *T,
+                 int ne,double tol,const mxArray *idx,double *fnd)
+{
+   int ip,ix,iy,nx,ny,k,kend,g,nglob,j;
+   int *start,*list,*glob;
+   double *bb,*nb,ONE,ZERO,fx,fy;
+
+   bb   =mxGetPr(mxGetField(idx,0,"bbox"));
+   nb   =mxGetPr(mxGetField(idx,0,"nbins"));
+   start=(int *)mxGetData(mxGetField(idx,0,"start"));
+   list =(int *)mxGetData(mxGetField(idx,0,"list"));
+   glob =(int *)mxGetData(mxGetField(idx,0,"unbinned"));
+   nglob=mxGetM(mxGetField(idx,0,"unbinned"));
+   nx=(int)nb[0];
+   ny=(int)nb[1];
+   ONE=1.+tol;
+   ZERO=0.-tol;
+
+/* ---- the IMIN/IMAX macros use static temporaries, so they are not
+        used inside the parallel loop --------------------------------- */
+#pragma omp parallel for private(ix,iy,k,kend,g,j,fx,fy) schedule(dynamic,64)
+   for (ip=0;ip<np;ip++){
+      k=kend=0;
+      if (!(ISFINITE(xp[ip]) && ISFINITE(yp[ip]))){
+         /* non-finite points are not bucketed; give them whatever the
+            full search gives them */
+         for (j=0;j<ne;j++){
+            if (inelem(j,xp[ip],yp[ip],AR,A,B,T,ne,ONE,ZERO)){
+               fnd[ip]=(double)(j+1);
+               break;
+            }
+         }
+         continue;
+      }
+      fx=(xp[ip]-bb[0])/bb[2];
+      fy=(yp[ip]-bb[1])/bb[3];
+      if (fx>=0. && fy>=0. && fx<=(double)nx && fy<=(double)ny){
+         ix=(int)fx;
+         iy=(int)fy;
+         if (ix>nx-1) ix=nx-1;
+         if (iy>ny-1) iy=ny-1;
+         k=start[iy*nx+ix];
+         kend=start[iy*nx+ix+1];
+      }
+      g=0;
+      while (k<kend || g<nglob){
+         if (g>=nglob || (k<kend && list[k]<glob[g])) j=list[k++]-1;
+         else j=glob[g++]-1;
+         if (inelem(j,xp[ip],yp[ip],AR,A,B,T,ne,ONE,ZERO)){
+            fnd[ip]=(double)(j+1);
+            break;
+         }
+      }
+   }
+   return;
+}
+
+/*----------------------------------------------------------------------
+
+  #    #    ##    #       #    #
+  #    #   #  #   #       #   #
+  #    #  #    #  #       ####
+  # ## #  ######  #       #  #
+  ##  ##  #    #  #       #   #
+  #    #  #    #  ######  #    #
+
+  Each point starts from the element of the point before it and steps
+  across the edge opposite its most negative basis function, toward
+  the point, until an element contains it.  A walk that leaves the
+  grid (a boundary edge), or takes more than a few times the grid's
+  width in elements (a point far from the one before, or a degenerate
+  element), falls back to the indexed search if idx is given, else
+  to the full search, as does the point after one off the grid.
+
+  Along a track or transect this is a few element tests per point.
+  A point on an element edge may be given either element.  Points
+  depend on the point before, so this is serial.
+----------------------------------------------------------------------*/
+void findwalk(int np,double *xp,double *yp,
+              double *AR,double *A,double *B,double *T,
+              int ne,double tol,const mxArray *idx,int *ee,double *fnd)
+{
+   int ip,j,k,step,maxstep,last=-1;
+   double fac,S[3],ONE,ZERO;
+
+   ONE=1.+tol;
+   ZERO=0.-tol;
+   maxstep=4*(int)sqrt((double)ne)+16;
+
+   for (ip=0;ip<np;ip++){
+      j=(ISFINITE(xp[ip]) && ISFINITE(yp[ip])) ? last : -1;
+      for (step=0;j>=0 && step<maxstep;step++){
+         if (inelem(j,xp[ip],yp[ip],AR,A,B,T,ne,ONE,ZERO)){
+            fnd[ip]=(double)(j+1);
+            break;
+         }
+         fac=.5/AR[j];
+         S[0]=(TT(j,0,ne)+BB(j,0,ne)*xp[ip]+AA(j,0,ne)*yp[ip])*fac;
+         S[1]=(TT(j,1,ne)+BB(j,1,ne)*xp[ip]+AA(j,1,ne)*yp[ip])*fac;
+         S[2]=(TT(j,2,ne)+BB(j,2,ne)*xp[ip]+AA(j,2,ne)*yp[ip])*fac;
+         k=0;
+         if (S[1]<S[k]) k=1;
+         if (S[2]<S[k]) k=2;
+         /* basis function k vanishes on the edge from node k+1 to
+            node k+2, which is neighbor column k+1 */
+         j=ee[j+ne*((k+1)%3)]-1;
+      }
+      if (fnd[ip]<0.){
+         if (idx)
+            findindexed(1,xp+ip,yp+ip,AR,A,B,T,ne,tol,idx,fnd+ip);
+         else {
+            for (j=0;j<ne;j++){
+               if (inelem(j,xp[ip],yp[ip],AR,A,B,T,ne,ONE,ZERO)){
+                  fnd[ip]=(double)(j+1);
+                  break;
+               }
+            }
+         }
+      }
+      /* a point off the grid restarts the walk at the next found */
+      last=fnd[ip]>0. ? (int)fnd[ip]-1 : -1;
+   }
+   return;
+}
@@ -66,39 +66,38 @@ void mexFunction(int            nlhs,
    njsearch=mxGetM(prhs[6]);
    if (debug) printf("njsearch=%d\n",njsearch);
    
-/* ---- allocate space for list containing element numbers following NRC 
-        allocation style
-        double *mxDvector(int nl,int nh)
-        fnd= (double *) mxDvector(0,np); ---------------------------- */
-	
-   fnd= (double *) mxDvector(0,np);
+/* ---- the element numbers are found straight into the returned
+        matrix, pointed to by plhs[0] ------------------------------- */
+   plhs[0]=mxCreateDoubleMatrix(np,1,mxREAL); 
+   fnd=mxGetPr(plhs[0]);
    for (ip=0;ip<np;ip++)fnd[ip]=-1.;
+
+/* ---- point-parallel search.  Each point scans the candidate list in
+        order and stops at the first element that contains it, which
+        is the element the candidate-outer sweep would have given it.
+        Points are split over the available cores when compiled with
+        OpenMP (see makemex). --------------------------------------- */
    ONE=1.+tol;
    ZERO=0.-tol;
-   for (jj=0;jj<njsearch;jj++){
-      j=(int)djsearch[jj]-1;
-      for (ip=0;ip<np;ip++){  
-         if(fnd[ip]<(double)0){
-            fac=.5/AR[j];         
-            S1=(TT(j,0,ne)+BB(j,0,ne)*xp[ip]+AA(j,0,ne)*yp[ip])*fac;
-            S2=(TT(j,1,ne)+BB(j,1,ne)*xp[ip]+AA(j,1,ne)*yp[ip])*fac;
-            S3=(TT(j,2,ne)+BB(j,2,ne)*xp[ip]+AA(j,2,ne)*yp[ip])*fac;
-            if (debug)printf("%d %lf %lf %lf\n",j,S1,S2,S3);
-            if (S1>ONE|S1<ZERO)goto l20;
-            if (S2>ONE|S2<ZERO)goto l20;
-            if (S3>ONE|S3<ZERO)goto l20;         
-            fnd[ip]=(double)(j+1);            
-         }
-       l20: continue;
-       }
-    }
+#pragma omp parallel for private(jj,j,fac,S1,S2,S3) schedule(dynamic,16)
+   for (ip=0;ip<np;ip++){
+      for (jj=0;jj<njsearch;jj++){
+         j=(int)djsearch[jj]-1;
+         fac=.5/AR[j];
+         S1=(TT(j,0,ne)+BB(j,0,ne)*xp[ip]+AA(j,0,ne)*yp[ip])*fac;
+         S2=(TT(j,1,ne)+BB(j,1,ne)*xp[ip]+AA(j,1,ne)*yp[ip])*fac;
+         S3=(TT(j,2,ne)+BB(j,2,ne)*xp[ip]+AA(j,2,ne)*yp[ip])*fac;
+         if (S1>ONE|S1<ZERO) continue;
+         if (S2>ONE|S2<ZERO) continue;
+         if (S3>ONE|S3<ZERO) continue;
+         fnd[ip]=(double)(j+1);
+         break;
+      }
+   }
     for (ip=0;ip<np;ip++) {
        if(fnd[ip]<(double)0)
           fnd[ip]=NaN;
     } 
-/* ---- Set elements of return matrix, pointed to by plhs[0] -------- */
-   plhs[0]=mxCreateDoubleMatrix(np,1,mxREAL); 
-   mxSetPr(plhs[0],fnd);
 
 /* ---- No need to free memory allocated with "mxCalloc"; MATLAB 
    does this automatically.  The CMEX allocation functions in 
@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <string.h>
+#include "mex.h"
+
+/* ---- XXH64 (Yann Collet's xxHash, 64-bit variant) over a stream of
+        bytes.  Not cryptographic, but fast and well mixed, which is
+        what a cache key for grid content needs. ------------------- */
+typedef unsigned long long u64;
+
+#define P1 0x9E3779B185EBCA87ULL
+#define P2 0xC2B2AE3D27D4EB4FULL
+#define P3 0x165667B19E3779F9ULL
+#define P4 0x85EBCA77C2B2AE63ULL
+#define P5 0x27D4EB2F165667C5ULL
+#define ROTL(x,r) (((x)<<(r))|((x)>>(64-(r))))
+
+typedef struct {
+   u64 v[4];
+   u64 total;
+   unsigned char buf[32];
+   int nbuf;
+} xxh64state;
+
+/* PROTOTYPES */
+void xxhinit(xxh64state *);
+void xxhupdate(xxh64state *,const unsigned char *,size_t);
+u64  xxhdigest(xxh64state *);
+
+/************************************************************
+
+  ####     ##     #####  ######  #    #    ##     #   #
+ #    #   #  #      #    #       #    #   #  #     # #
+ #       #    #     #    #####   #    #  #    #     #
+ #  ###  ######     #    #       # ## #  ######     #
+ #    #  #    #     #    #       ##  ##  #    #     #
+  ####   #    #     #    ######  #    #  #    #     #
+
+************************************************************/
+
+void mexFunction(int            nlhs,
+                 mxArray       *plhs[],
+		 int            nrhs,
+		 const mxArray *prhs[])
+{
+
+/* ---- gridhashmex5 will be called as :
+        h=gridhashmex5(A1,A2,...);
+
+        h is a 16-character hex string hashing, in order, the class,
+        dimensions and (real) contents of each numeric, char or
+        logical argument, so that e.g. int32 and double copies of an
+        element list hash differently.  ----------------------------- */
+
+   int i;
+   mwSize nd;
+   const mwSize *dims;
+   u64 hdr[4],h;
+   char str[17];
+   xxh64state st;
+
+   if (nlhs > 1)
+      mexErrMsgTxt("gridhashmex5 requires 1 output argument.");
+
+   xxhinit(&st);
+   for (i=0;i<nrhs;i++){
+      if (!(mxIsNumeric(prhs[i]) || mxIsChar(prhs[i]) || mxIsLogical(prhs[i])))
+         mexErrMsgTxt("Arguments to gridhashmex5 must be numeric, char or logical.");
+      nd=mxGetNumberOfDimensions(prhs[i]);
+      dims=mxGetDimensions(prhs[i]);
+      hdr[0]=(u64)mxGetClassID(prhs[i]);
+      hdr[1]=(u64)nd;
+      hdr[2]=(u64)dims[0];
+      hdr[3]=(u64)dims[1];
+      xxhupdate(&st,(const unsigned char *)hdr,4*sizeof(u64));
+      if (mxGetNumberOfElements(prhs[i])>0)
+         xxhupdate(&st,(const unsigned char *)mxGetData(prhs[i]),
+                   mxGetNumberOfElements(prhs[i])*mxGetElementSize(prhs[i]));
+   }
+   h=xxhdigest(&st);
+   for (i=0;i<16;i++)
+      str[i]="0123456789abcdef"[(h>>(60-4*i))&0xF];
+   str[16]='\0';
+   plhs[0]=mxCreateString(str);
+   return;
+}
+
+/*----------------------------------------------------------------------
+
+  #    #  #    #  #    #   ####   #    #
+   #  #    #  #   #    #  #    #  #    #
+    ##      ##    ######  #       #    #
+    ##      ##    #    #  #  ###  ######
+   #  #    #  #   #    #  #    #       #
+  #    #  #    #  #    #   ####        #
+
+----------------------------------------------------------------------*/
+static u64 rd64(const unsigned char *p)
+{
+   u64 v;
+   memcpy(&v,p,8);
+   return(v);
+}
+
+static u64 round64(u64 acc,u64 in)
+{
+   acc+=in*P2;
+   acc=ROTL(acc,31);
+   return(acc*P1);
+}
+
+static u64 merge64(u64 acc,u64 v)
+{
+   acc^=round64(0,v);
+   return(acc*P1+P4);
+}
+
+void xxhinit(xxh64state *st)
+{
+   st->v[0]=P1+P2;
+   st->v[1]=P2;
+   st->v[2]=0;
+   st->v[3]=0-P1;
+   st->total=0;
+   st->nbuf=0;
+}
+
+void xxhupdate(xxh64state *st,const unsigned char *p,size_t n)
+{
+   int k;
+   st->total+=n;
+   if (st->nbuf+n<32){
+      memcpy(st->buf+st->nbuf,p,n);
+      st->nbuf+=(int)n;
+      return;
+   }
+   if (st->nbuf>0){
+      k=32-st->nbuf;
+      memcpy(st->buf+st->nbuf,p,k);
+      p+=k;
+      n-=k;
+      st->v[0]=round64(st->v[0],rd64(st->buf));
+      st->v[1]=round64(st->v[1],rd64(st->buf+8));
+      st->v[2]=round64(st->v[2],rd64(st->buf+16));
+      st->v[3]=round64(st->v[3],rd64(st->buf+24));
+      st->nbuf=0;
+   }
+   while (n>=32){
+      st->v[0]=round64(st->v[0],rd64(p));
+      st->v[1]=round64(st->v[1],rd64(p+8));
+      st->v[2]=round64(st->v[2],rd64(p+16));
+      st->v[3]=round64(st->v[3],rd64(p+24));
+      p+=32;
+      n-=32;
+   }
+   if (n>0){
+      memcpy(st->buf,p,n);
+      st->nbuf=(int)n;
+   }
+}
+
+u64 xxhdigest(xxh64state *st)
+{
+   u64 h,k1;
+   unsigned int k32;
+   const unsigned char *p=st->buf;
+   int n=st->nbuf;
+
+   if (st->total>=32){
+      h=ROTL(st->v[0],1)+ROTL(st->v[1],7)+ROTL(st->v[2],12)+ROTL(st->v[3],18);
+      h=merge64(h,st->v[0]);
+      h=merge64(h,st->v[1]);
+      h=merge64(h,st->v[2]);
+      h=merge64(h,st->v[3]);
+   }
+   else
+      h=st->v[2]+P5;
+   h+=st->total;
+
+   while (n>=8){
+      k1=round64(0,rd64(p));
+      h^=k1;
+      h=ROTL(h,27)*P1+P4;
+      p+=8;
+      n-=8;
+   }
+   if (n>=4){
+      memcpy(&k32,p,4);
+      h^=(u64)k32*P1;
+      h=ROTL(h,23)*P2+P3;
+      p+=4;
+      n-=4;
+   }
+   while (n>0){
+      h^=(*p)*P5;
+      h=ROTL(h,11)*P1;
+      p++;
+      n--;
+   }
+   h^=h>>33;
+   h*=P2;
+   h^=h>>29;
+   h*=P3;
+   h^=h>>32;
+   return(h);
+}
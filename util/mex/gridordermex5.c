@@ -0,0 +1,173 @@
+#include <math.h>
+#include <stdio.h>
+#include "mex.h"
+#include "opnml_mex5_allocs.c"
+
+/* ---- the Hilbert curve is laid over a 2^HORDER x 2^HORDER grid
+        covering the node bounding box ----------------------------- */
+#define HORDER 16
+
+typedef struct {
+   unsigned int key;
+   int          id;
+} hkey;
+
+/* PROTOTYPES */
+int  hkeycmp(const void *,const void *);
+unsigned int hilbert(unsigned int,unsigned int);
+void hilbertorder(int,double *,double *,double *,int *);
+
+#define ELE(i,j,m) ele[i+m*j]
+
+/************************************************************
+
+  ####     ##     #####  ######  #    #    ##     #   #
+ #    #   #  #      #    #       #    #   #  #     # #
+ #       #    #     #    #####   #    #  #    #     #
+ #  ###  ######     #    #       # ## #  ######     #
+ #    #  #    #     #    #       ##  ##  #    #     #
+  ####   #    #     #    ######  #    #  #    #     #
+
+************************************************************/
+
+void mexFunction(int            nlhs,
+                 mxArray       *plhs[],
+		 int            nrhs,
+		 const mxArray *prhs[])
+{
+
+/* ---- gridordermex5 will be called as :
+        [nperm,eperm]=gridordermex5(x,y,ele);
+
+        nperm orders the nodes, and eperm the elements (by centroid),
+        along a Hilbert curve over the grid's bounding box, so that
+        nodes and elements close in space are close in memory.  The
+        renumbered grid is x(nperm), y(nperm), and ele(eperm,:)
+        mapped through the inverse of nperm.  Ties keep the original
+        order, so the permutations are deterministic. -------------- */
+
+   int i,k,nn,ne,*ele,*ord;
+   double *x,*y,*dele,*ex,*ey,*nperm,*eperm;
+   double bb[4];
+
+/* ---- check I/O arguments ----------------------------------------- */
+   if (nrhs != 3)
+      mexErrMsgTxt("gridordermex5 requires 3 input arguments.");
+   else if (nlhs != 2)
+      mexErrMsgTxt("gridordermex5 requires 2 output arguments.");
+
+/* ---- dereference input arrays ------------------------------------ */
+   x=mxGetPr(prhs[0]);
+   y=mxGetPr(prhs[1]);
+   dele=mxGetPr(prhs[2]);
+   nn=mxGetM(prhs[0])*mxGetN(prhs[0]);
+   ne=mxGetM(prhs[2]);
+   if (mxGetN(prhs[2]) != 3)
+      mexErrMsgTxt("Element list to gridordermex5 must be ne x 3.");
+
+   ele=(int *)mxIvector(0,3*ne-1);
+   for (i=0;i<3*ne;i++){
+      ele[i]=((int)dele[i])-1;
+      if (ele[i]<0 || ele[i]>=nn)
+         mexErrMsgTxt("Element list references nodes not in x,y.");
+   }
+
+/* ---- bounding box of the finite node coordinates ---------------- */
+   bb[0]=bb[2]=mxGetInf();
+   bb[1]=bb[3]=-mxGetInf();
+   for (i=0;i<nn;i++){
+      if (x[i]-x[i]!=0. || y[i]-y[i]!=0.) continue;
+      if (x[i]<bb[0]) bb[0]=x[i];
+      if (x[i]>bb[1]) bb[1]=x[i];
+      if (y[i]<bb[2]) bb[2]=y[i];
+      if (y[i]>bb[3]) bb[3]=y[i];
+   }
+
+/* ---- node order -------------------------------------------------- */
+   ord=(int *)mxIvector(0,(nn>ne?nn:ne)-1);
+   hilbertorder(nn,x,y,bb,ord);
+   plhs[0]=mxCreateDoubleMatrix(nn,1,mxREAL);
+   nperm=mxGetPr(plhs[0]);
+   for (i=0;i<nn;i++)
+      nperm[i]=(double)(ord[i]+1);
+
+/* ---- element order, by centroid ---------------------------------- */
+   ex=(double *)mxDvector(0,ne-1);
+   ey=(double *)mxDvector(0,ne-1);
+   for (k=0;k<ne;k++){
+      ex[k]=(x[ELE(k,0,ne)]+x[ELE(k,1,ne)]+x[ELE(k,2,ne)])/3.;
+      ey[k]=(y[ELE(k,0,ne)]+y[ELE(k,1,ne)]+y[ELE(k,2,ne)])/3.;
+   }
+   hilbertorder(ne,ex,ey,bb,ord);
+   plhs[1]=mxCreateDoubleMatrix(ne,1,mxREAL);
+   eperm=mxGetPr(plhs[1]);
+   for (k=0;k<ne;k++)
+      eperm[k]=(double)(ord[k]+1);
+
+   return;
+}
+
+int hkeycmp(const void *a,const void *b)
+{
+   unsigned int ka=((const hkey *)a)->key,kb=((const hkey *)b)->key;
+   if (ka<kb) return(-1);
+   if (ka>kb) return(1);
+   return(((const hkey *)a)->id-((const hkey *)b)->id);
+}
+
+/*----------------------------------------------------------------------
+
+  #    #     #    #          #####   ######  #####   #####
+  #    #     #    #          #    #  #       #    #    #
+  ######     #    #          #####   #####   #    #    #
+  #    #     #    #          #    #  #       #####     #
+  #    #     #    #          #    #  #       #   #     #
+  #    #     #    ######     #####   ######  #    #    #
+
+  Distance along the Hilbert curve of order HORDER to cell (ix,iy).
+----------------------------------------------------------------------*/
+unsigned int hilbert(unsigned int ix,unsigned int iy)
+{
+   unsigned int n=1u<<HORDER,s,rx,ry,d=0,t;
+   for (s=n/2;s>0;s/=2){
+      rx=(ix&s)>0;
+      ry=(iy&s)>0;
+      d+=s*s*((3*rx)^ry);
+      if (ry==0){
+         if (rx==1){
+            ix=n-1-ix;
+            iy=n-1-iy;
+         }
+         t=ix;
+         ix=iy;
+         iy=t;
+      }
+   }
+   return(d);
+}
+
+/* ---- sort n points into ord[] by Hilbert distance over the box bb
+        [xmin xmax ymin ymax]; non-finite points go last ----------- */
+void hilbertorder(int n,double *x,double *y,double *bb,int *ord)
+{
+   int i;
+   unsigned int cmax=(1u<<HORDER)-1;
+   double sx,sy,cx,cy;
+   hkey *key;
+
+   key=(hkey *)mxCalloc(n>0?n:1,sizeof(hkey));
+   sx=bb[1]>bb[0]?cmax/(bb[1]-bb[0]):0.;
+   sy=bb[3]>bb[2]?cmax/(bb[3]-bb[2]):0.;
+   for (i=0;i<n;i++){
+      key[i].id=i;
+      if (x[i]-x[i]!=0. || y[i]-y[i]!=0.)
+         key[i].key=0xFFFFFFFFu;
+      else {
+         cx=DMIN(DMAX((x[i]-bb[0])*sx,0.),(double)cmax);
+         cy=DMIN(DMAX((y[i]-bb[2])*sy,0.),(double)cmax);
+         key[i].key=hilbert((unsigned int)cx,(unsigned int)cy);
+      }
+   }
+   qsort(key,n,sizeof(hkey),hkeycmp);
+   for (i=0;i<n;i++) ord[i]=key[i].id;
+}
@@ -0,0 +1,260 @@
+#include <math.h>
+#include <stdio.h>
+#include "mex.h"
+#include "opnml_mex5_allocs.c"
+#include "opnml_mex5_hash.c"
+
+#define ELE(i,j,m) ele[(i)+(m)*(j)]
+
+static const char *TopoFields[]={"edges","ee","n2estart","n2e","bnd","loops"};
+
+/* PROTOTYPES */
+void gridtopo(int,int,int *,mxArray **);
+
+/************************************************************
+
+  ####     ##     #####  ######  #    #    ##     #   #
+ #    #   #  #      #    #       #    #   #  #     # #
+ #       #    #     #    #####   #    #  #    #     #
+ #  ###  ######     #    #       # ## #  ######     #
+ #    #  #    #     #    #       ##  ##  #    #     #
+  ####   #    #     #    ######  #    #  #    #     #
+
+************************************************************/
+
+void mexFunction(int            nlhs,
+                 mxArray       *plhs[],
+		 int            nrhs,
+		 const mxArray *prhs[])
+{
+
+/* ---- gridtopomex5 will be called as :
+        T=gridtopomex5(ele);
+     or T=gridtopomex5(ele,nn);
+
+        The topology of the triangular grid ele (ne x 3) on nn nodes
+        (default max(ele(:))), from one pass over the elements with
+        an open-addressing hash of the edges.  T has int32 fields:
+           .edges    - nedges x 2, the unique edges [n1 n2], n1<n2,
+                       in order of first use
+           .ee       - ne x 3, the element across edge j of each
+                       element, the edge from node j to node j+1
+                       (3 to 1); 0 on the boundary
+           .n2estart - nn+1 x 1, 0-based offsets into .n2e; the
+                       elements of node i are
+                       T.n2e(T.n2estart(i)+1:T.n2estart(i+1))
+           .n2e      - 3*ne x 1, elements by node
+           .bnd      - nb x 2, the boundary edges, in the direction
+                       of their element's edge (for counter-clockwise
+                       elements, the domain is on the left), head to
+                       tail along each boundary loop
+           .loops    - nloops+1 x 1, 0-based offsets into .bnd; loop
+                       k is T.bnd(T.loops(k)+1:T.loops(k+1),:)
+        An edge on more than two elements is reported; the first two
+        are made neighbors across it, and the others see it as
+        boundary.  --------------------------------------------------- */
+
+   int i,nn,ne,*ele;
+   double *dele;
+
+/* ---- check I/O arguments ----------------------------------------- */
+   if (nrhs != 1 && nrhs != 2)
+      mexErrMsgTxt("gridtopomex5 requires 1 or 2 input arguments.");
+   else if (nlhs > 1)
+      mexErrMsgTxt("gridtopomex5 requires 1 output argument.");
+   if (mxGetN(prhs[0]) != 3 || !mxIsDouble(prhs[0]))
+      mexErrMsgTxt("Element list to gridtopomex5 must be ne x 3 double.");
+
+/* ---- dereference input arrays ------------------------------------ */
+   dele=mxGetPr(prhs[0]);
+   ne=mxGetM(prhs[0]);
+   nn=0;
+   for (i=0;i<3*ne;i++)
+      if (dele[i]>nn) nn=(int)dele[i];
+   if (nrhs == 2){
+      if ((int)mxGetScalar(prhs[1])<nn)
+         mexErrMsgTxt("Element list to gridtopomex5 references nodes beyond nn.");
+      nn=(int)mxGetScalar(prhs[1]);
+   }
+
+   ele=(int *)mxIvector(0,IMAX(3*ne,1)-1);
+   for (i=0;i<3*ne;i++){
+      ele[i]=((int)dele[i])-1;
+      if (ele[i]<0)
+         mexErrMsgTxt("Element list to gridtopomex5 has node numbers < 1.");
+   }
+
+   gridtopo(nn,ne,ele,&plhs[0]);
+
+   mxFree(ele);
+   return;
+}
+
+/*----------------------------------------------------------------------
+
+   ####   #####      #    #####    #####   ####   #####    ####
+  #    #  #    #     #    #    #     #    #    #  #    #  #    #
+  #       #    #     #    #    #     #    #    #  #    #  #    #
+  #  ###  #####      #    #    #     #    #    #  #####   #    #
+  #    #  #   #      #    #    #     #    #    #  #       #    #
+   ####   #    #     #    #####      #     ####   #        ####
+
+----------------------------------------------------------------------*/
+
+#ifdef __STDC__
+void gridtopo(int nn,int ne,int *ele,mxArray **T)
+#else
+void gridtopo(nn,ne,ele,T)
+int nn,ne,*ele;
+mxArray **T;
+#endif
+{
+   int i,j,k,a,b,id,ned,nb,nl,nbad=0,*edges,*owner,*ee,*start,*n2e,
+       *bhead,*bnext,*bedge,*bnd,*loops,*used;
+   long long key;
+   size_t est;
+   mxArray *fld;
+   mxI64Hash h;
+   char msg[128];
+
+/* ---- edges and element adjacency --------------------------------- */
+   /* a connected grid with h holes has nn+ne-1+h edges; a margin for
+      the holes, never more than 3 per element.  A grid with more
+      holes than the margin grows the arrays and the table below */
+   est=(size_t)nn+(size_t)ne+(size_t)ne/8+64;
+   if (est>3*(size_t)ne) est=3*(size_t)ne;
+   mxI64HashInit(&h,est);
+   edges=(int *)mxIvector(0,2*(int)est-1);
+   owner=(int *)mxIvector(0,(int)est-1);
+
+   *T=mxCreateStructMatrix(1,1,6,TopoFields);
+   fld=mxCreateNumericMatrix(ne,3,mxINT32_CLASS,mxREAL);
+   ee=(int *)mxGetData(fld);
+   mxSetField(*T,0,"ee",fld);
+
+   ned=0;
+   for (k=0;k<ne;k++){
+      for (j=0;j<3;j++){
+         a=ELE(k,j,ne);
+         b=ELE(k,(j+1)%3,ne);
+         key=a<b ? (long long)a*nn+b : (long long)b*nn+a;
+         if ((size_t)ned==est){
+            /* room for half as many edges again, and a table twice
+               the size, rehashed */
+            mxI64Hash h2;
+            est+=est/2;
+            if (est>3*(size_t)ne) est=3*(size_t)ne;
+            edges=(int *)mxRealloc(edges,2*est*sizeof(int));
+            owner=(int *)mxRealloc(owner,est*sizeof(int));
+            mxI64HashInit(&h2,est);
+            for (i=0;(size_t)i<=h.mask;i++)
+               if (h.key[i]!=-1)
+                  mxI64HashInsert(&h2,h.key[i],h.val[i]);
+            mxFree(h.key);
+            mxFree(h.val);
+            h=h2;
+         }
+         id=mxI64HashInsert(&h,key,ned);
+         if (id==ned){
+            edges[2*ned]=IMIN(a,b);
+            edges[2*ned+1]=IMAX(a,b);
+            owner[ned]=3*k+j;
+            ned++;
+         }
+         else if (owner[id]>=0){
+            /* second element on the edge; owner is element*3+side */
+            ee[k+ne*j]=owner[id]/3+1;
+            ee[owner[id]/3+ne*(owner[id]%3)]=k+1;
+            owner[id]=-1;
+         }
+         else {
+            /* more than two elements; keep the first pair */
+            nbad++;
+         }
+      }
+   }
+   if (nbad){
+      sprintf(msg,"gridtopomex5: %d element edges are on more than two elements.",nbad);
+      mexWarnMsgTxt(msg);
+   }
+
+   fld=mxCreateNumericMatrix(ned,2,mxINT32_CLASS,mxREAL);
+   for (i=0;i<ned;i++){
+      ((int *)mxGetData(fld))[i]=edges[2*i]+1;
+      ((int *)mxGetData(fld))[i+ned]=edges[2*i+1]+1;
+   }
+   mxSetField(*T,0,"edges",fld);
+   mxFree(edges);
+   mxFree(owner);
+   mxFree(h.key);
+   mxFree(h.val);
+
+/* ---- node to element incidence: count, prefix sum, fill ---------- */
+   fld=mxCreateNumericMatrix(nn+1,1,mxINT32_CLASS,mxREAL);
+   start=(int *)mxGetData(fld);
+   mxSetField(*T,0,"n2estart",fld);
+   for (i=0;i<3*ne;i++) start[ele[i]+1]++;
+   for (i=0;i<nn;i++) start[i+1]+=start[i];
+   fld=mxCreateNumericMatrix(3*ne,1,mxINT32_CLASS,mxREAL);
+   n2e=(int *)mxGetData(fld);
+   mxSetField(*T,0,"n2e",fld);
+   used=(int *)mxIvector(0,IMAX(nn,1)-1);
+   for (k=0;k<ne;k++)
+      for (j=0;j<3;j++){
+         a=ELE(k,j,ne);
+         n2e[start[a]+used[a]++]=k+1;
+      }
+   mxFree(used);
+
+/* ---- boundary edges, chained by their first node ----------------- */
+   nb=0;
+   for (i=0;i<3*ne;i++)
+      if (ee[i]==0) nb++;
+   bhead=(int *)mxIvector(0,IMAX(nn,1)-1);
+   bnext=(int *)mxIvector(0,IMAX(nb,1)-1);
+   bedge=(int *)mxIvector(0,IMAX(2*nb,1)-1);
+   used=(int *)mxIvector(0,IMAX(nb,1)-1);
+   for (i=0;i<nn;i++) bhead[i]=-1;
+   nb=0;
+   for (k=0;k<ne;k++)
+      for (j=0;j<3;j++){
+         if (ee[k+ne*j]) continue;
+         a=ELE(k,j,ne);
+         bedge[2*nb]=a;
+         bedge[2*nb+1]=ELE(k,(j+1)%3,ne);
+         bnext[nb]=bhead[a];
+         bhead[a]=nb;
+         nb++;
+      }
+
+/* ---- walk the loops; each edge continues from its last node ------ */
+   fld=mxCreateNumericMatrix(nb,2,mxINT32_CLASS,mxREAL);
+   bnd=(int *)mxGetData(fld);
+   mxSetField(*T,0,"bnd",fld);
+   loops=(int *)mxIvector(0,nb);
+   nl=0;
+   k=0;
+   for (i=0;i<nb;i++){
+      if (used[i]) continue;
+      loops[nl++]=k;
+      id=i;
+      while (id>=0){
+         used[id]=1;
+         bnd[k]=bedge[2*id]+1;
+         bnd[k+nb]=bedge[2*id+1]+1;
+         k++;
+         /* next unused edge out of this edge's last node */
+         for (id=bhead[bedge[2*id+1]];id>=0 && used[id];id=bnext[id]);
+      }
+   }
+   loops[nl]=k;
+   fld=mxCreateNumericMatrix(nl+1,1,mxINT32_CLASS,mxREAL);
+   for (i=0;i<=nl;i++) ((int *)mxGetData(fld))[i]=loops[i];
+   mxSetField(*T,0,"loops",fld);
+
+   mxFree(bhead);
+   mxFree(bnext);
+   mxFree(bedge);
+   mxFree(used);
+   mxFree(loops);
+}
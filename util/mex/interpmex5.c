@@ -0,0 +1,188 @@
+#include <math.h>
+#include <stdio.h>
+#include <stddef.h>
+#include "mex.h"
+#include "opnml_mex5_allocs.c"
+
+#define ELE(i,j,m) ele[i+m*j]
+#define AA(i,j,m) A[i+m*j]
+#define BB(i,j,m) B[i+m*j]
+#define TT(i,j,m) T[i+m*j]
+
+/* PROTOTYPES; sizes are mwSize, since an apply over a raster of
+   millions of points and many time levels exceeds an int */
+void weights(mwSize,mwSize,double *,double *,double *,double *,double *,
+             double *,double *,double *,double *,double *);
+void apply(mwSize,mwSize,mwSize,double *,double *,double *,double *);
+
+/************************************************************
+
+  ####     ##     #####  ######  #    #    ##     #   #
+ #    #   #  #      #    #       #    #   #  #     # #
+ #       #    #     #    #####   #    #  #    #     #
+ #  ###  ######     #    #       # ## #  ######     #
+ #    #  #    #     #    #       ##  ##  #    #     #
+  ####   #    #     #    ######  #    #  #    #     #
+
+************************************************************/
+
+void mexFunction(int            nlhs,
+                 mxArray       *plhs[],
+		 int            nrhs,
+		 const mxArray *prhs[])
+{
+
+/* ---- interpmex5 will be called as :
+        [n,w]=interpmex5(ele,ar,A,B,T,xp,yp,j);     (locate)
+        qp=interpmex5(n,w,Q);                       (apply)
+
+        The locate form gives, for the points xp,yp in elements j
+        (from findelemex5; NaN for points outside the grid), the
+        np x 3 node numbers n and linear basis weights w, from the
+        BELINT arrays.  Rows for points outside the grid are NaN.
+
+        The apply form interpolates the nn x nt block Q (e.g., every
+        time level of a field, or every ensemble member) onto the
+        points in one pass, qp(p,t)=sum(w(p,:).*Q(n(p,:),t)).  Points
+        are located once and the weights reused for every column.
+        Columns are split over the available cores when compiled with
+        OpenMP (see makemex).  A NaN nodal value gives a NaN result,
+        as in INTERP_SCALAR.  ----------------------------------------- */
+
+   mwSize np,ne,nn,nt;
+
+/* ---- check I/O arguments ----------------------------------------- */
+   if (nrhs == 8){
+      if (nlhs != 2)
+         mexErrMsgTxt("interpmex5(ele,ar,A,B,T,xp,yp,j) requires 2 output arguments.");
+      ne=mxGetM(prhs[0]);
+      np=mxGetM(prhs[5])*mxGetN(prhs[5]);
+      if (mxGetN(prhs[0]) != 3)
+         mexErrMsgTxt("Element list to interpmex5 must be ne x 3.");
+      if (mxGetM(prhs[6])*mxGetN(prhs[6]) != np ||
+          mxGetM(prhs[7])*mxGetN(prhs[7]) != np)
+         mexErrMsgTxt("xp,yp and j to interpmex5 must be the same length.");
+      plhs[0]=mxCreateDoubleMatrix(np,3,mxREAL);
+      plhs[1]=mxCreateDoubleMatrix(np,3,mxREAL);
+      weights(np,ne,mxGetPr(prhs[0]),mxGetPr(prhs[1]),mxGetPr(prhs[2]),
+              mxGetPr(prhs[3]),mxGetPr(prhs[4]),mxGetPr(prhs[5]),
+              mxGetPr(prhs[6]),mxGetPr(prhs[7]),
+              mxGetPr(plhs[0]),mxGetPr(plhs[1]));
+   }
+   else if (nrhs == 3){
+      if (nlhs > 1)
+         mexErrMsgTxt("interpmex5(n,w,Q) requires 1 output argument.");
+      np=mxGetM(prhs[0]);
+      if (mxGetN(prhs[0]) != 3 || mxGetM(prhs[1]) != np || mxGetN(prhs[1]) != 3)
+         mexErrMsgTxt("n and w to interpmex5 must both be np x 3.");
+      if (!mxIsDouble(prhs[2]))
+         mexErrMsgTxt("Q to interpmex5 must be double.");
+      nn=mxGetM(prhs[2]);
+      nt=mxGetN(prhs[2]);
+      plhs[0]=mxCreateDoubleMatrix(np,nt,mxREAL);
+      apply(np,nn,nt,mxGetPr(prhs[0]),mxGetPr(prhs[1]),mxGetPr(prhs[2]),
+            mxGetPr(plhs[0]));
+   }
+   else
+      mexErrMsgTxt("interpmex5 requires 3 or 8 input arguments.");
+
+/* ---- No need to free memory allocated with "mxCalloc"; MATLAB
+   does this automatically.  The CMEX allocation functions in
+   "opnml_allocs.c" use mxCalloc. ----------------------------------- */
+   return;
+}
+
+/*----------------------------------------------------------------------
+
+  #    #  ######     #     ####   #    #   #####   ####
+  #    #  #          #    #    #  #    #     #    #
+  #    #  #####      #    #       ######     #     ####
+  # ## #  #          #    #  ###  #    #     #         #
+  ##  ##  #          #    #    #  #    #     #    #    #
+  #    #  ######     #     ####   #    #     #     ####
+
+----------------------------------------------------------------------*/
+#ifdef __STDC__
+void weights(mwSize np,mwSize ne,double *ele,double *ar,double *A,double *B,
+             double *T,double *xp,double *yp,double *j,double *n,
+             double *w)
+#else
+void weights(np,ne,ele,ar,A,B,T,xp,yp,j,n,w)
+mwSize np,ne;
+double *ele,*ar,*A,*B,*T,*xp,*yp,*j,*n,*w;
+#endif
+{
+   mwSize ip,k,m;
+   double NaN=mxGetNaN();
+   double fac;
+
+   for (ip=0;ip<np;ip++){
+      if (!(j[ip]>=1. && j[ip]<=(double)ne)){
+         for (m=0;m<3;m++){
+            n[ip+np*m]=NaN;
+            w[ip+np*m]=NaN;
+         }
+         continue;
+      }
+      k=(mwSize)j[ip]-1;
+      fac=.5/ar[k];
+      for (m=0;m<3;m++){
+         n[ip+np*m]=ELE(k,m,ne);
+         w[ip+np*m]=(TT(k,m,ne)+BB(k,m,ne)*xp[ip]+AA(k,m,ne)*yp[ip])*fac;
+      }
+   }
+}
+
+/*----------------------------------------------------------------------
+
+    ##    #####   #####   #       #   #
+   #  #   #    #  #    #  #        # #
+  #    #  #    #  #    #  #         #
+  ######  #####   #####   #         #
+  #    #  #       #       #         #
+  #    #  #       #       ######    #
+
+----------------------------------------------------------------------*/
+#ifdef __STDC__
+void apply(mwSize np,mwSize nn,mwSize nt,double *n,double *w,double *Q,double *qp)
+#else
+void apply(np,nn,nt,n,w,Q,qp)
+mwSize np,nn,nt;
+double *n,*w,*Q,*qp;
+#endif
+{
+   mwSize ip;
+   ptrdiff_t it;             /* signed, for OpenMP 2.0 (MSVC) */
+   int *n1,*n2,*n3;
+   double NaN=mxGetNaN();
+   double *q;
+
+/* ---- node numbers are converted and checked once, so the inner
+        loop over columns is three gathers and a dot product ------- */
+   n1=(int *)mxMalloc((np+1)*sizeof(int));
+   n2=(int *)mxMalloc((np+1)*sizeof(int));
+   n3=(int *)mxMalloc((np+1)*sizeof(int));
+   for (ip=0;ip<np;ip++){
+      n1[ip]=(n[ip]>=1. && n[ip]<=(double)nn) ? (int)n[ip]-1 : -1;
+      n2[ip]=(n[ip+np]>=1. && n[ip+np]<=(double)nn) ? (int)n[ip+np]-1 : -1;
+      n3[ip]=(n[ip+2*np]>=1. && n[ip+2*np]<=(double)nn) ? (int)n[ip+2*np]-1 : -1;
+      if (n1[ip]<0 || n2[ip]<0 || n3[ip]<0)
+         n1[ip]=-1;
+   }
+
+#pragma omp parallel for private(ip,q) schedule(static)
+   for (it=0;it<(ptrdiff_t)nt;it++){
+      q=Q+nn*(mwSize)it;
+      for (ip=0;ip<np;ip++){
+         if (n1[ip]<0)
+            qp[ip+np*(mwSize)it]=NaN;
+         else
+            qp[ip+np*(mwSize)it]=w[ip]*q[n1[ip]]
+                                +w[ip+np]*q[n2[ip]]
+                                +w[ip+2*np]*q[n3[ip]];
+      }
+   }
+   mxFree(n1);
+   mxFree(n2);
+   mxFree(n3);
+}
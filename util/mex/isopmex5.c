@@ -2,17 +2,41 @@
 #include <stdio.h>
 #include "mex.h"
 #include "opnml_mex5_allocs.c"
+#include "opnml_mex5_arena.c"
+
+/* ---- elements are processed in blocks of ISOBLK; the output rows
+        of each block are counted first, then written in place, so
+        the output is exactly sized and in element order whatever
+        the number of threads -------------------------------------- */
+#define ISOBLK 4096
 
 /* PROTOTYPES */
 void isophase(int,
+              int,
+              int,
               double *,
               double *,
               int *,
               double *,
-              double,
-              double **,
+              int,
+              double *,
+              int *,
               int *,
+              int,
+              double *,
               double);
+int isoelem(double *,
+            double *,
+            double *,
+            double,
+            double,
+            double *,
+            double *);
+
+/* ---- scratch kept from call to call, so that contouring a series
+        of fields on one grid reuses the same memory --------------- */
+static mxArena Scratch=MXARENA_PERSISTENT;
+static void FreeScratch(void) { mxArenaFree(&Scratch); }
 
 /************************************************************
 
@@ -33,23 +57,33 @@ void mexFunction(int            nlhs,
 {
 
 /* ---- isopmex will be called as :
-        mat=isopmex(x,y,e,q,cval); 
-[e,x,y,z,b]=loadgrid('nsea2ll');                                     
+        mat=isopmex(x,y,e,q,cval);
+     or [mat,lev]=isopmex(x,y,e,q,cval);
+[e,x,y,z,b]=loadgrid('nsea2ll');
 [data,gname]=read_s2r;
-q=data(:,2);                        
+q=data(:,2);
+
+        cval may be a vector of phases; all are extracted in one
+        sweep over the elements.  mat rows are grouped by phase in
+        the order given in cval, and within each phase are in
+        element order, so the rows for cval(k) are exactly those of
+        isopmex5(x,y,e,q,cval(k)).  lev(i) is the index into cval of
+        row i of mat (including the NaN row ending each segment).
+        NaN phases give no rows.  Element blocks are split over the
+        available cores when compiled with OpenMP (see makemex).
                                       ------------------------------- */
-   int cnt,*ele,i,j,nn,ne;
+   int *ele,i,k,b,ne,nc,nblk,nrow;
+   int *cnt,*off;
    double *x, *y, *q;
    double *cval,*dele;
-   double **cmat,*newcmat;
-   int nrl,nrh,ncl,nch;
-   double NaN=mxGetNaN(); 
-     
+   double *newcmat,*newlev;
+   double NaN=mxGetNaN();
+
 /* ---- check I/O arguments ----------------------------------------- */
-   if (nrhs != 5) 
+   if (nrhs != 5)
       mexErrMsgTxt("isophase_mex requires 5 input arguments.");
-   else if (nlhs !=1) 
-      mexErrMsgTxt("isophase_mex requires 1 output arguments.");
+   else if (nlhs > 2)
+      mexErrMsgTxt("isophase_mex requires 1 or 2 output arguments.");
 
 /* ---- dereference input arrays ------------------------------------ */
    x=mxGetPr(prhs[0]);
@@ -57,51 +91,65 @@ q=data(:,2);
    dele=mxGetPr(prhs[2]);
    q=mxGetPr(prhs[3]);
    cval=mxGetPr(prhs[4]);
-   nn=mxGetM(prhs[0]);
-   ne=mxGetM(prhs[2]);  
-   
-   
+   ne=mxGetM(prhs[2]);
+   nc=mxGetNumberOfElements(prhs[4]);
+
 /* ---- allocate space for int representation of dele &
         convert double element representation to int  &
         shift node numbers toward 0 by 1 for proper indexing -------- */
-   ele=(int *)mxIvector(0,3*ne-1);
+   mexAtExit(FreeScratch);
+   mxArenaReset(&Scratch);
+   ele=(int *)mxArenaAlloc(&Scratch,3*(size_t)ne*sizeof(int));
    for (i=0;i<3*ne;i++) ele[i]=((int)dele[i]-1);
-   
-/* ---- allocate space for divergence list dv following 
-        NRC allocation style                            
-   cmat= mxDmatrix(     0,     ne-1,    0,      3)     -------------- */
-
-   nrl=0;
-   nrh=6*ne;
-   ncl=0;
-   nch=3;
-   cmat=(double **) mxDmatrix(nrl,nrh,ncl,nch);
-        
-   isophase(ne,x,y,ele,q,cval[0],cmat,&cnt,NaN); 
-   
-   if (cnt<1){
-      plhs[0]=mxCreateDoubleMatrix(0,0,mxREAL); 
-      return; 
-   }     
-    
-   newcmat=(double *) mxDvector(0,2*cnt-1);
-   for (j=0;j<2;j++)
-      for (i=0;i<cnt;i++)
-         newcmat[cnt*j+i]=cmat[i][j];
-
-   /* 
-   Set elements of return matrix, pointed to by plhs[0]
-   */
-   plhs[0]=mxCreateDoubleMatrix(cnt,2,mxREAL); 
-   mxSetPr(plhs[0],newcmat);
+
+/* ---- pass 1: rows per block and phase; cnt[b*nc+k] -------------- */
+   nblk=(ne+ISOBLK-1)/ISOBLK;
+   cnt=(int *)mxArenaCalloc(&Scratch,nblk*nc+1,sizeof(int));
+#pragma omp parallel for schedule(dynamic,1)
+   for (b=0;b<nblk;b++)
+      isophase(b*ISOBLK,(b+1)*ISOBLK<ne?(b+1)*ISOBLK:ne,ne,x,y,ele,q,
+               nc,cval,cnt+b*nc,NULL,0,NULL,NaN);
+
+/* ---- starting row of each block within each phase --------------- */
+   off=(int *)mxArenaAlloc(&Scratch,(nblk*nc+1)*sizeof(int));
+   nrow=0;
+   for (k=0;k<nc;k++)
+      for (b=0;b<nblk;b++){
+         off[b*nc+k]=nrow;
+         nrow+=cnt[b*nc+k];
+      }
+
+   if (nrow<1){
+      plhs[0]=mxCreateDoubleMatrix(0,0,mxREAL);
+      if (nlhs>1)
+         plhs[1]=mxCreateDoubleMatrix(0,1,mxREAL);
+      return;
+   }
+
+/* ---- pass 2: each block writes its rows in place, in the 
+        returned matrix pointed to by plhs[0] ---------------------- */
+   plhs[0]=mxCreateDoubleMatrix(nrow,2,mxREAL);
+   newcmat=mxGetPr(plhs[0]);
+   if (nlhs>1){
+      plhs[1]=mxCreateDoubleMatrix(nrow,1,mxREAL);
+      newlev=mxGetPr(plhs[1]);
+      for (k=0;k<nc;k++)
+         for (i=off[k];i<(k+1<nc?off[k+1]:nrow);i++)
+            newlev[i]=(double)(k+1);
+   }
+#pragma omp parallel for schedule(dynamic,1)
+   for (b=0;b<nblk;b++)
+      isophase(b*ISOBLK,(b+1)*ISOBLK<ne?(b+1)*ISOBLK:ne,ne,x,y,ele,q,
+               nc,cval,NULL,off+b*nc,nrow,newcmat,NaN);
 
    /*
    No need to free memory allocated with "mxCalloc"; MATLAB does
-   this auotmatically.  The CMEX allocation functions in 
-   "opnml_allocs.c" use mxCalloc.   
-   */ 
-   
-   return;   
+   this auotmatically.  The CMEX allocation functions in
+   "opnml_allocs.c" use mxCalloc.  Scratch is persistent, and
+   is reused by the next call.
+   */
+
+   return;
 }
 
 /****************************************************************
@@ -115,117 +163,140 @@ q=data(:,2);
   ###    #####  ####### #       #     # #     #  #####  #######
 
 ****************************************************************/
-   
+
+/* ---- isophase extracts all phases for elements l0..l1-1.  With
+        cmat NULL it adds the number of output rows for phase k to
+        cnt[k]; otherwise it writes them to the nrow x 2 cmat from
+        row off[k] on, advancing off[k].  The NaN test, node gather
+        and 0-phase wrap are done once per element; phases outside
+        an element's range are skipped, as they have no crossing. -- */
+
 #ifdef __STDC__
-   void isophase(int ne,
-        	 double *x, 
+   void isophase(int l0,
+                 int l1,
+                 int ne,
+        	 double *x,
         	 double *y,
         	 int *ele,
         	 double *pha,
-        	 double cval,
-        	 double **cmat,
+                 int nc,
+        	 double *cval,
         	 int *cnt,
+                 int *off,
+                 int nrow,
+        	 double *cmat,
         	 double NaN)
 #else
-   void isophase(ne,x,y,ele,pha,cval,cmat,cnt,NaN)
-   int ne;
-   double *x, *y, *pha,cval,**cmat,NaN;
-   int *ele,*cnt;
+   void isophase(l0,l1,ne,x,y,ele,pha,nc,cval,cnt,off,nrow,cmat,NaN)
+   int l0,l1,ne,nc,nrow;
+   double *x, *y, *pha,*cval,*cmat,NaN;
+   int *ele,*cnt,*off;
 #endif
 #define ELE(i,j,m) ele[i+m*j]
-// #define DEBUG 
 {
-   double var[9],xx[9],yy[9];
+   double var[2][3],vmin[2],vmax[2],xx[3],yy[3];
    double plmt=150.,p0lmt=260.,xp[6],yp[6];
-   int i,icnt,k,k2,l,n,count,nsw,nvert=3;
+   int i,icnt,k,l,n,w,r,nvert=3;
    int n0,n1,n2;
-   double vlmt,v1,v3,xcon,ycon;
-   bool test;
-   
-   count=0;
-   
-   for(l=0;l<ne;l++){                  /* begin 651 */
-       
+
+   for(l=l0;l<l1;l++){                 /* begin 651 */
+
       n0=ELE(l,0,ne);
       n1=ELE(l,1,ne);
-      n2=ELE(l,2,ne);  
-      /* if element contains a NaN, ignore this element */
-      test=(mxIsNaN(pha[n0]) | mxIsNaN(pha[n1]) | mxIsNaN(pha[n2]));
-      if (test){continue;}
-
-#ifdef DEBUG
-//        if ((l % 1000)==0){
-//        if (l == 0){
-//           printf(" L = %d\n",l);
-//        }
-         if(l==10){
-            /* */ 
-            test=(mxIsNaN(pha[n0]) | mxIsNaN(pha[n1]) | mxIsNaN(pha[n2]));
-            if (test){continue;}
-            printf("%d %f %d %d ... \n",n0,pha[n0],mxIsNaN(pha[n0]),test);
-            printf("%d %f %d ... \n",n1,pha[n1],mxIsNaN(pha[n1]));
-            printf("%d %f %d ... \n",n2,pha[n2],mxIsNaN(pha[n2]));            
-            /* */ 
-         }
-#endif
+      n2=ELE(l,2,ne);
+      /* if element contains a NaN, ignore this element (x!=x is
+         the NaN test; the mx API is not called from threads) */
+      if (pha[n0]!=pha[n0] || pha[n1]!=pha[n1] || pha[n2]!=pha[n2]) continue;
 
-      nsw=0;
+      /* var[0] is the phase as given, var[1] wrapped to (-180,180]
+         for contouring phases near 0 */
       for(k=0;k<nvert;k++){            /* begin 641 */
          n=ELE(l,k,ne);
          xx[k]=x[n];
          yy[k]=y[n];
-         var[k]=pha[n];
-         vlmt=plmt;         
-
-         if(cval<1.){
-            vlmt=p0lmt;
-            if(var[k]>180.) var[k]=var[k]-360.;
-         }
+         var[0][k]=pha[n];
+         var[1][k]=pha[n]>180.?pha[n]-360.:pha[n];
       }                                /* end 641 */
-   
-      if(cval==var[0]) {
-         nsw=1;
-         icnt=1;
-         xp[icnt]=xx[0];
-         yp[icnt]=yy[0];
-      }
-      for(k=0;k<nvert;k++){                /* begin 649 */
-         k2=k+1;
-         if(k2>nvert-1) k2=0;
-         if(var[k]>var[k2]) goto L610;
-         if(cval<var[k]||cval>var[k2]) goto L649;
-         goto L611;
- L610:   if(cval<var[k2]||cval>var[k]) goto L649;
- L611:   v3=var[k2]-var[k];
-         if(fabs(v3)>vlmt) goto L649;
-         v1=1.;
-         if(fabs(v3)>1.e-7) v1=(cval-var[k])/v3;
-         xcon=v1*(xx[k2]-xx[k])+xx[k];
-         ycon=v1*(yy[k2]-yy[k])+yy[k];
-         if(nsw==1) {
-            icnt++;
-            xp[icnt]=xcon;
-            yp[icnt]=ycon;
+      for(w=0;w<2;w++){
+         vmin[w]=vmax[w]=var[w][0];
+         for(k=1;k<nvert;k++){
+            if(var[w][k]<vmin[w]) vmin[w]=var[w][k];
+            if(var[w][k]>vmax[w]) vmax[w]=var[w][k];
          }
-         else{
-            nsw=1;
-            icnt=1;
-            xp[icnt]=xcon;
-            yp[icnt]=ycon;
+      }
+
+      for(k=0;k<nc;k++){
+         w=cval[k]<1.;
+         if(!(cval[k]>=vmin[w]&&cval[k]<=vmax[w])) continue;
+         icnt=isoelem(xx,yy,var[w],cval[k],w?p0lmt:plmt,xp,yp);
+         if(icnt<2) continue;
+         if(cmat==NULL){
+            cnt[k]+=icnt+1;
+            continue;
          }
- L649:continue;
-      }                                  /* end 649 */
-      if(nsw==1&&icnt>1) {
+         r=off[k];
          for(i=1;i<=icnt;i++){
-            cmat[count][0]=xp[i];
-            cmat[count][1]=yp[i];
-            count++;
+            cmat[r]=xp[i];
+            cmat[nrow+r]=yp[i];
+            r++;
          }
-         cmat[count][0]=NaN;   /* this puts a break in the plotted line */
-         cmat[count][1]=NaN;
-         count++;        
+         cmat[r]=NaN;   /* this puts a break in the plotted line */
+         cmat[nrow+r]=NaN;
+         off[k]=r+1;
       }
    }                                    /* end 651 */
-   *cnt=count;
    return;
 }
+
+/* ---- crossings of phase cval on the edges of one element, in
+        xp[1..icnt]; returns icnt, or 0 if there are none --------- */
+#ifdef __STDC__
+   int isoelem(double *xx,
+               double *yy,
+               double *var,
+               double cval,
+               double vlmt,
+               double *xp,
+               double *yp)
+#else
+   int isoelem(xx,yy,var,cval,vlmt,xp,yp)
+   double *xx,*yy,*var,cval,vlmt,*xp,*yp;
+#endif
+{
+   int icnt=0,k,k2,nsw=0,nvert=3;
+   double v1,v3,xcon,ycon;
+
+   if(cval==var[0]) {
+      nsw=1;
+      icnt=1;
+      xp[icnt]=xx[0];
+      yp[icnt]=yy[0];
+   }
+   for(k=0;k<nvert;k++){                /* begin 649 */
+      k2=k+1;
+      if(k2>nvert-1) k2=0;
+      if(var[k]>var[k2]) goto L610;
+      if(cval<var[k]||cval>var[k2]) goto L649;
+      goto L611;
+ L610:if(cval<var[k2]||cval>var[k]) goto L649;
+ L611:v3=var[k2]-var[k];
+      if(fabs(v3)>vlmt) goto L649;
+      v1=1.;
+      if(fabs(v3)>1.e-7) v1=(cval-var[k])/v3;
+      xcon=v1*(xx[k2]-xx[k])+xx[k];
+      ycon=v1*(yy[k2]-yy[k])+yy[k];
+      if(nsw==1) {
+         icnt++;
+         xp[icnt]=xcon;
+         yp[icnt]=ycon;
+      }
+      else{
+         nsw=1;
+         icnt=1;
+         xp[icnt]=xcon;
+         yp[icnt]=ycon;
+      }
+ L649:continue;
+   }                                    /* end 649 */
+   return(nsw==1?icnt:0);
+}
@@ -1,10 +1,52 @@
 function makemex
 
+% kernels with OpenMP-parallel loops.  On compilers without OpenMP 
+% (e.g., the default OSX clang) these build and run single-threaded.
+ompfiles={'findelemex5.c','findelemex52.c','belintmex5.c','interpmex5.c','isopmex5.c'};
+% kernels whose results are the same numbers as the m-files they
+% replace.  gcc (and clang, for some targets) fuse a*b+c into one
+% rounding by default, which changes the last bits, so these are
+% built with -ffp-contract=off; cl does not contract by default.
+fpfiles={'belintmex5.c'};
+if ispc
+   ompcflags='';
+   ompldflags='';
+   ompflags='COMPFLAGS="$COMPFLAGS /openmp"';
+   fpcflags='';
+elseif ismac
+   ompcflags='';
+   ompldflags='';
+   ompflags='';
+   fpcflags=' -ffp-contract=off';
+else
+   ompcflags=' -fopenmp';
+   ompldflags=' -fopenmp';
+   ompflags='';
+   fpcflags=' -ffp-contract=off';
+end
+
 disp(' ')
-files={'isopmex5.c','ele2neimex5.c','contmex5.c','findelemex5.c','findelemex52.c','read_adcirc_fort_compact_mex.c','read_adcirc_fort_mex.c'};
+files={'isopmex5.c','ele2neimex5.c','gridtopomex5.c','contmex5.c','findelemex5.c','findelemex52.c','strtreemex5.c','gridordermex5.c','gridhashmex5.c','belintmex5.c','interpmex5.c','bandmex5.c','vecbinmex5.c','ensstatmex5.c','read_adcirc_fort_compact_mex.c','read_adcirc_fort_mex.c'};
 for i=1:length(files)
    disp(sprintf('Compiling %s',files{i}))
-   com=sprintf('mex %s',files{i});
+   cflags='';
+   ldflags='';
+   flags='';
+   if any(strcmp(files{i},ompfiles))
+      cflags=[cflags ompcflags];
+      ldflags=[ldflags ompldflags];
+      flags=ompflags;
+   end
+   if any(strcmp(files{i},fpfiles))
+      cflags=[cflags fpcflags];
+   end
+   if ~isempty(cflags)
+      flags=[flags sprintf(' CFLAGS="$CFLAGS%s"',cflags)];
+   end
+   if ~isempty(ldflags)
+      flags=[flags sprintf(' LDFLAGS="$LDFLAGS%s"',ldflags)];
+   end
+   com=sprintf('mex %s %s',flags,files{i});
    eval(com);
 end
 
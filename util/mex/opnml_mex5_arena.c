@@ -0,0 +1,270 @@
+/*----------------------------------------------------------------------
+
+  MATLAB C-MEX file functions:
+
+  This is the file opnml_mex5_arena.c, allocation for kernels whose
+  output size is only known once they have run, and whose scratch
+  is the same size call after call on a grid.  It is included in
+  c-source after "opnml_mex5_allocs.c" as:
+
+  #include "mex.h"
+  #include "opnml_mex5_allocs.c"
+  #include "opnml_mex5_arena.c"
+
+  An arena hands out scratch from large chunks, and is reset (not
+  freed) between calls.  A chunk left unused by a call is freed at
+  the next reset, so the arena follows the size of the grid in use.
+  An arena declared static and persistent keeps its chunks across
+  calls; its kernel frees it from a mexAtExit function:
+
+     static mxArena Scratch=MXARENA_PERSISTENT;
+     static void FreeScratch(void) { mxArenaFree(&Scratch); }
+     ...
+     mexAtExit(FreeScratch);
+     mxArenaReset(&Scratch);
+
+  p=mxArenaAlloc(&a,n)       n bytes, 16-byte aligned, not cleared
+  p=mxArenaCalloc(&a,n,s)    n*s bytes, cleared
+  mxArenaReset(&a)           forget all allocations, keep the chunks
+  mxArenaFree(&a)            free the chunks
+
+  An emit buffer collects rows of a double matrix column-major, as
+  MATLAB stores it, growing as rows are added, and hands its memory
+  to the output mxArray without copying:
+
+  mxEmitInit(&e,ncol,rows)   an empty buffer with room for rows rows
+  i=mxEmitRow(&e)            appends a row and returns its index;
+                             its values are set with MXEMIT(&e,i,j)
+  mxEmitPermute(&e,ord)      reorders the rows; row k becomes the
+                             row that was ord[k]
+  a=mxEmitArray(&e)          the rows x ncol mxArray, on the buffer's
+                             memory; the buffer is then empty
+
+  Neither is safe to use from more than one thread at a time.
+
+--------------------------------------------------------------------- */
+
+#ifndef _OPNML_ARENA_INCLUDED
+#define _OPNML_ARENA_INCLUDED
+
+#include <string.h>
+
+typedef struct mxArenaChunk {
+   struct mxArenaChunk *next;
+   size_t size;         /* bytes after the header */
+   size_t used;
+   int    touched;      /* used since the last reset */
+} mxArenaChunk;
+
+typedef struct {
+   mxArenaChunk *head;
+   mxArenaChunk *cur;
+   int persistent;
+} mxArena;
+
+#define MXARENA_CHUNK      ((size_t)4<<20)
+#define MXARENA_HDR        ((sizeof(mxArenaChunk)+15)&~(size_t)15)
+#define MXARENA_INIT       {NULL,NULL,0}
+#define MXARENA_PERSISTENT {NULL,NULL,1}
+
+typedef struct {
+   double *p;
+   int     ncol;
+   size_t  rows;
+   size_t  cap;
+} mxEmit;
+
+#define MXEMIT(e,i,j) ((e)->p[(i)+(e)->cap*(size_t)(j)])
+
+#ifdef __STDC__
+void *mxArenaAlloc(mxArena *a,size_t n)
+#else
+void *mxArenaAlloc(a,n)
+mxArena *a;
+size_t n;
+#endif
+{
+   mxArenaChunk *c,*last=NULL;
+   size_t size;
+   char *p;
+
+   n=(n+15)&~(size_t)15;
+   for (c=a->cur?a->cur:a->head;c;c=c->next){
+      if (c->used+n<=c->size) break;
+      last=c;
+   }
+   if (c==NULL){
+      size=n>MXARENA_CHUNK ? n : MXARENA_CHUNK;
+      c=(mxArenaChunk *)mxMalloc(MXARENA_HDR+size);
+      if (c==NULL)
+         mexErrMsgTxt("allocation failure in mxArenaAlloc()");
+      if (a->persistent)
+         mexMakeMemoryPersistent(c);
+      c->next=NULL;
+      c->size=size;
+      c->used=0;
+      if (last==NULL)
+         for (last=a->head;last && last->next;last=last->next);
+      if (last)
+         last->next=c;
+      else
+         a->head=c;
+   }
+   p=(char *)c+MXARENA_HDR+c->used;
+   c->used+=n;
+   c->touched=1;
+   a->cur=c;
+   return (void *)p;
+}
+
+#ifdef __STDC__
+void *mxArenaCalloc(mxArena *a,size_t n,size_t s)
+#else
+void *mxArenaCalloc(a,n,s)
+mxArena *a;
+size_t n,s;
+#endif
+{
+   void *p=mxArenaAlloc(a,n*s);
+   memset(p,0,n*s);
+   return p;
+}
+
+#ifdef __STDC__
+void mxArenaReset(mxArena *a)
+#else
+void mxArenaReset(a)
+mxArena *a;
+#endif
+{
+   mxArenaChunk **pc=&a->head,*c;
+   while ((c=*pc)!=NULL){
+      if (!c->touched){
+         *pc=c->next;
+         mxFree(c);
+         continue;
+      }
+      c->used=0;
+      c->touched=0;
+      pc=&c->next;
+   }
+   a->cur=a->head;
+}
+
+#ifdef __STDC__
+void mxArenaFree(mxArena *a)
+#else
+void mxArenaFree(a)
+mxArena *a;
+#endif
+{
+   mxArenaChunk *c;
+   while ((c=a->head)!=NULL){
+      a->head=c->next;
+      mxFree(c);
+   }
+   a->cur=NULL;
+}
+
+/* ---- emit buffers; column j of the buffer starts at p+j*cap ----- */
+#ifdef __STDC__
+void mxEmitInit(mxEmit *e,int ncol,size_t cap)
+#else
+void mxEmitInit(e,ncol,cap)
+mxEmit *e;
+int ncol;
+size_t cap;
+#endif
+{
+   e->ncol=ncol;
+   e->rows=0;
+   e->cap=cap>16 ? cap : 16;
+   e->p=(double *)mxMalloc(e->cap*ncol*sizeof(double));
+   if (e->p==NULL)
+      mexErrMsgTxt("allocation failure in mxEmitInit()");
+}
+
+#ifdef __STDC__
+size_t mxEmitRow(mxEmit *e)
+#else
+size_t mxEmitRow(e)
+mxEmit *e;
+#endif
+{
+   size_t cap;
+   int j;
+   if (e->rows==e->cap){
+      /* double, and move the columns out to their new starts, last
+         first since they only move up */
+      cap=2*e->cap;
+      e->p=(double *)mxRealloc(e->p,cap*e->ncol*sizeof(double));
+      if (e->p==NULL)
+         mexErrMsgTxt("allocation failure in mxEmitRow()");
+      for (j=e->ncol-1;j>0;j--)
+         memmove(e->p+cap*j,e->p+e->cap*j,e->rows*sizeof(double));
+      e->cap=cap;
+   }
+   return e->rows++;
+}
+
+#ifdef __STDC__
+void mxEmitPermute(mxEmit *e,int *ord)
+#else
+void mxEmitPermute(e,ord)
+mxEmit *e;
+int *ord;
+#endif
+{
+   /* follow each cycle of ord once, marking its entries by
+      negating them, and restore ord at the end */
+   size_t k,i,s,n=e->rows;
+   double *t;
+   int j;
+   t=(double *)mxMalloc((e->ncol>0?e->ncol:1)*sizeof(double));
+   for (k=0;k<n;k++){
+      if (ord[k]<0 || (size_t)ord[k]==k) continue;
+      for (j=0;j<e->ncol;j++) t[j]=MXEMIT(e,k,j);
+      i=k;
+      for (;;){
+         s=(size_t)ord[i];
+         ord[i]=-ord[i]-1;
+         if (s==k) break;
+         for (j=0;j<e->ncol;j++) MXEMIT(e,i,j)=MXEMIT(e,s,j);
+         i=s;
+      }
+      for (j=0;j<e->ncol;j++) MXEMIT(e,i,j)=t[j];
+   }
+   for (k=0;k<n;k++)
+      if (ord[k]<0) ord[k]=-ord[k]-1;
+   mxFree(t);
+}
+
+#ifdef __STDC__
+mxArray *mxEmitArray(mxEmit *e)
+#else
+mxArray *mxEmitArray(e)
+mxEmit *e;
+#endif
+{
+   mxArray *a;
+   int j;
+   if (e->rows==0){
+      mxFree(e->p);
+      e->p=NULL;
+      return mxCreateDoubleMatrix(0,e->ncol,mxREAL);
+   }
+   /* close up the columns, then give back the room past them */
+   for (j=1;j<e->ncol;j++)
+      memmove(e->p+e->rows*j,e->p+e->cap*j,e->rows*sizeof(double));
+   if (e->rows<e->cap)
+      e->p=(double *)mxRealloc(e->p,e->rows*e->ncol*sizeof(double));
+   a=mxCreateDoubleMatrix(0,0,mxREAL);
+   mxSetPr(a,e->p);
+   mxSetM(a,e->rows);
+   mxSetN(a,e->ncol);
+   e->p=NULL;
+   e->rows=e->cap=0;
+   return a;
+}
+
+#endif
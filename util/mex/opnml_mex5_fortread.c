@@ -0,0 +1,356 @@
+/*----------------------------------------------------------------------
+
+  MATLAB C-MEX file functions:
+
+  This is the file opnml_mex5_fortread.c, a buffered reader and
+  number tokenizer for the ADCIRC ASCII output files (fort.6x,
+  fort.7x, fort.4x) read by read_adcirc_fort_mex.c and
+  read_adcirc_fort_compact_mex.c.  The file is read in large blocks
+  and numbers are converted in place, without fscanf or a strtod per
+  token; byte offsets are kept as 64-bit integers, so files beyond
+  2GB can be indexed and seeked.  It is included in c-source after
+  "mex.h", in a file that defines _FILE_OFFSET_BITS 64 and
+  _POSIX_C_SOURCE 200809L before its first #include, as:
+
+  #define _FILE_OFFSET_BITS 64
+  #define _POSIX_C_SOURCE 200809L
+  ...
+  #include "mex.h"
+  #include "opnml_mex5_allocs.c"
+  #include "opnml_mex5_fortread.c"
+
+  ok=mxFortOpen(&r,name)     opens name; 0 if it cannot be opened
+  mxFortClose(&r)
+  mxFortSeek(&r,off)         positions r at byte offset off
+  off=mxFortTell(&r)         byte offset of the next unread char
+  ok=mxFortDouble(&r,&v)     next number, across white space and line
+                             ends, into v; 0 at end of file.  Fortran
+                             D exponents and E-less exponents (1.5-100)
+                             are read; a token that is not a number
+                             (e.g., ******) is read as NaN
+  n=mxFortSkipLines(&r,n)    skips past the next n line ends; returns
+                             the number skipped (fewer at end of file)
+  n=mxFortLineTokens(&r)     number of tokens between the current
+                             position and the next line end; nothing
+                             is consumed
+  mxFortLine(&r,s,n)         copies the rest of the line, at most n-1
+                             chars, into s and skips past its end
+  n=mxFortUnit(unit,names)   number of values per node (per level,
+                             for the 3-d units 45,46) of an output
+                             unit, and the names of the fields they
+                             are returned in; 0 if not supported
+  mxFortProgress(f,v,msg)    sends msg to the MATLAB function handle f
+                             (if not empty) and, if v, to the command
+                             window
+
+--------------------------------------------------------------------- */
+
+#ifndef _OPNML_FORTREAD_INCLUDED
+#define _OPNML_FORTREAD_INCLUDED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#define FORTSEEK(f,o) _fseeki64(f,o,SEEK_SET)
+#else
+#include <sys/types.h>
+#define FORTSEEK(f,o) fseeko(f,(off_t)(o),SEEK_SET)
+/* ---- offsets past 2GB would be truncated by a 32-bit off_t; see
+        _FILE_OFFSET_BITS above --------------------------------- */
+typedef char fortread_off_t_is_64_bits[sizeof(off_t)>=8 ? 1 : -1];
+#endif
+
+#define FORTBUF  (1<<22)    /* read block, bytes */
+#define FORTTOK  4096       /* look-ahead kept for one token or line */
+
+typedef struct {
+   FILE      *fp;
+   char      *buf;          /* FORTBUF+1, NUL after the last char */
+   size_t     pos,len;
+   long long  off;          /* file offset of buf[0] */
+   int        eof;
+} mxFortReader;
+
+/* exact powers of ten; m*10^e with m<2^53 and |e|<=22 is correctly
+   rounded by one multiply or divide */
+static const double mxFortP10[23]={
+   1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,
+   1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+
+#define FORTSPACE(c) ((c)==' '||(c)=='\t'||(c)=='\r'||(c)=='\n'||(c)==',')
+#define FORTDIGIT(c) ((c)>='0'&&(c)<='9')
+
+#ifdef __STDC__
+int mxFortOpen(mxFortReader *r,const char *name)
+#else
+int mxFortOpen(r,name)
+mxFortReader *r;
+char *name;
+#endif
+{
+   r->fp=fopen(name,"rb");
+   if (!r->fp) return(0);
+   r->buf=(char *)mxMalloc(FORTBUF+1);
+   if (!r->buf)
+      mexErrMsgTxt("allocation failure in mxFortOpen()");
+   r->buf[0]='\0';
+   r->pos=r->len=0;
+   r->off=0;
+   r->eof=0;
+   return(1);
+}
+
+#ifdef __STDC__
+void mxFortClose(mxFortReader *r)
+#else
+void mxFortClose(r)
+mxFortReader *r;
+#endif
+{
+   if (r->fp) fclose(r->fp);
+   r->fp=NULL;
+   mxFree(r->buf);
+}
+
+#ifdef __STDC__
+void mxFortSeek(mxFortReader *r,long long off)
+#else
+void mxFortSeek(r,off)
+mxFortReader *r;
+long long off;
+#endif
+{
+   if (FORTSEEK(r->fp,off) != 0)
+      mexErrMsgTxt("seek past the end of the file in mxFortSeek(); stale record offsets?");
+   r->buf[0]='\0';
+   r->pos=r->len=0;
+   r->off=off;
+   r->eof=0;
+}
+
+#ifdef __STDC__
+long long mxFortTell(mxFortReader *r)
+#else
+long long mxFortTell(r)
+mxFortReader *r;
+#endif
+{
+   return(r->off+(long long)r->pos);
+}
+
+/* ---- make at least need chars available from pos, unless the end
+        of the file comes first; returns the number available ----- */
+#ifdef __STDC__
+size_t mxFortFill(mxFortReader *r,size_t need)
+#else
+size_t mxFortFill(r,need)
+mxFortReader *r;
+size_t need;
+#endif
+{
+   size_t n,want;
+   if (r->len-r->pos>=need || r->eof) return(r->len-r->pos);
+   memmove(r->buf,r->buf+r->pos,r->len-r->pos);
+   r->off+=(long long)r->pos;
+   r->len-=r->pos;
+   r->pos=0;
+   want=FORTBUF-r->len;
+   n=fread(r->buf+r->len,1,want,r->fp);
+   r->len+=n;
+   if (n<want) r->eof=1;
+   r->buf[r->len]='\0';
+   return(r->len);
+}
+
+#ifdef __STDC__
+int mxFortDouble(mxFortReader *r,double *v)
+#else
+int mxFortDouble(r,v)
+mxFortReader *r;
+double *v;
+#endif
+{
+   char *p,*s,tmp[64];
+   int neg=0,nd=0,ndig=0,e=0,ex,eneg,k;
+   unsigned long long m=0;
+
+   /* ---- skip white space, refilling as needed ---- */
+   for (;;){
+      while (r->pos<r->len && FORTSPACE(r->buf[r->pos])) r->pos++;
+      if (r->pos<r->len) break;
+      if (mxFortFill(r,FORTTOK)==0) return(0);
+   }
+   mxFortFill(r,FORTTOK);
+   s=p=r->buf+r->pos;
+
+   if (*p=='-'){neg=1;p++;}
+   else if (*p=='+') p++;
+   while (FORTDIGIT(*p)){
+      if (nd<19){m=m*10+(*p-'0'); if (m) nd++;}
+      else e++;
+      ndig++;
+      p++;
+   }
+   if (*p=='.'){
+      p++;
+      while (FORTDIGIT(*p)){
+         if (nd<19){m=m*10+(*p-'0'); if (m) nd++; e--;}
+         ndig++;
+         p++;
+      }
+   }
+   if (ndig==0){
+      /* NaN, Inf or a Fortran overflow field */
+      while (*p && !FORTSPACE(*p)) p++;
+      k=(int)(p-s)<63 ? (int)(p-s) : 63;
+      memcpy(tmp,s,k);
+      tmp[k]='\0';
+      *v=strtod(tmp,&s);
+      if (s==tmp) *v=mxGetNaN();
+      r->pos=p-r->buf;
+      return(1);
+   }
+   if (*p=='e'||*p=='E'||*p=='d'||*p=='D'||
+       ((*p=='+'||*p=='-') && FORTDIGIT(p[1]))){
+      if (*p!='+' && *p!='-') p++;
+      eneg=0;
+      if (*p=='-'){eneg=1;p++;}
+      else if (*p=='+') p++;
+      ex=0;
+      while (FORTDIGIT(*p)){ if (ex<100000) ex=ex*10+(*p-'0'); p++; }
+      e+=eneg ? -ex : ex;
+   }
+
+   if (m==0)
+      *v=0.;
+   else if (m<(1ULL<<53) && e>=-22 && e<=22)
+      *v=e<0 ? (double)m/mxFortP10[-e] : (double)m*mxFortP10[e];
+   else {
+      /* outside the exact range; let strtod round it */
+      sprintf(tmp,"%llue%d",m,e);
+      *v=strtod(tmp,NULL);
+   }
+   if (neg) *v=-*v;
+
+   while (*p && !FORTSPACE(*p)) p++;
+   r->pos=p-r->buf;
+   return(1);
+}
+
+#ifdef __STDC__
+long long mxFortSkipLines(mxFortReader *r,long long n)
+#else
+long long mxFortSkipLines(r,n)
+mxFortReader *r;
+long long n;
+#endif
+{
+   long long k=0;
+   int partial=0;
+   char *p;
+   while (k<n){
+      if (r->pos>=r->len && mxFortFill(r,1)==0){
+         /* a last line without its line end */
+         if (partial) k++;
+         break;
+      }
+      p=(char *)memchr(r->buf+r->pos,'\n',r->len-r->pos);
+      if (p){
+         r->pos=p-r->buf+1;
+         partial=0;
+         k++;
+      }
+      else {
+         r->pos=r->len;
+         partial=1;
+      }
+   }
+   return(k);
+}
+
+#ifdef __STDC__
+int mxFortLineTokens(mxFortReader *r)
+#else
+int mxFortLineTokens(r)
+mxFortReader *r;
+#endif
+{
+   int n=0,in=0;
+   char *p;
+   mxFortFill(r,FORTTOK);
+   for (p=r->buf+r->pos;*p && *p!='\n';p++){
+      if (FORTSPACE(*p)) in=0;
+      else if (!in){in=1;n++;}
+   }
+   return(n);
+}
+
+#ifdef __STDC__
+void mxFortLine(mxFortReader *r,char *s,int n)
+#else
+void mxFortLine(r,s,n)
+mxFortReader *r;
+char *s;
+int n;
+#endif
+{
+   int k=0;
+   char *p;
+   mxFortFill(r,FORTTOK);
+   for (p=r->buf+r->pos;*p && *p!='\n' && *p!='\r';p++)
+      if (k<n-1) s[k++]=*p;
+   s[k]='\0';
+   r->pos=p-r->buf;
+   mxFortSkipLines(r,1);
+}
+
+#ifdef __STDC__
+int mxFortUnit(int unit,char **names)
+#else
+int mxFortUnit(unit,names)
+int unit;
+char **names;
+#endif
+{
+   switch (unit){
+      case 61: case 63:
+         names[0]="zeta";
+         return(1);
+      case 71: case 73:
+         names[0]="pres";
+         return(1);
+      case 62: case 64: case 72: case 74:
+         names[0]="u"; names[1]="v";
+         return(2);
+      case 45:
+         names[0]="u"; names[1]="v"; names[2]="w";
+         return(3);
+      case 46:
+         names[0]="q20"; names[1]="l"; names[2]="ev";
+         return(3);
+   }
+   return(0);
+}
+
+#ifdef __STDC__
+void mxFortProgress(const mxArray *fcn,int verbose,const char *msg)
+#else
+void mxFortProgress(fcn,verbose,msg)
+mxArray *fcn;
+int verbose;
+char *msg;
+#endif
+{
+   mxArray *args[2];
+   if (verbose) mexPrintf("%s\n",msg);
+   if (fcn==NULL || mxIsEmpty(fcn)) return;
+   args[0]=(mxArray *)fcn;
+   args[1]=mxCreateString(msg);
+   mexCallMATLAB(0,NULL,2,args,"feval");
+   mxDestroyArray(args[1]);
+}
+
+#endif
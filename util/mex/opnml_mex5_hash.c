@@ -0,0 +1,94 @@
+/*----------------------------------------------------------------------
+
+  MATLAB C-MEX file functions:
+  
+  This is the file opnml_mex5_hash.c, a small open-addressing hash
+  table for use in MATLAB/C-MEX files that need to match mesh
+  entities (nodes, edges, contour endpoints) by an integer key.
+  Keys are non-negative 64-bit integers, values are ints.  Memory
+  is allocated with mxCalloc/mxMalloc, so, as with the routines in
+  "opnml_mex5_allocs.c", MATLAB frees it on exit from the mex 
+  function.  It is included in c-source after "mex.h" as:
+  
+  #include "mex.h"
+  #include "opnml_mex5_allocs.c"
+  #include "opnml_mex5_hash.c"
+  
+  mxI64HashInit(&h,n)        sizes the table for up to n keys
+  v=mxI64HashInsert(&h,k,v)  returns the value stored for k; if k
+                             is not in the table, stores and returns v
+  v=mxI64HashFind(&h,k)      returns the value stored for k, or -1
+    
+--------------------------------------------------------------------- */
+  
+#ifndef _OPNML_HASH_INCLUDED
+#define _OPNML_HASH_INCLUDED
+
+typedef struct {
+   long long *key;      /* -1 marks an empty slot */
+   int       *val;
+   size_t     mask;
+   size_t     cnt;
+} mxI64Hash;
+
+/* ---- multiplicative (Fibonacci) hash of a 64-bit key ------------ */
+#define MXI64HASH(k) ((size_t)(((unsigned long long)(k)*0x9E3779B97F4A7C15ULL)>>17))
+
+#ifdef __STDC__
+void mxI64HashInit(mxI64Hash *h,size_t n)
+#else
+void mxI64HashInit(h,n)
+mxI64Hash *h;
+size_t n;
+#endif
+{
+   size_t cap=16,i;
+   while (cap<2*n) cap*=2;
+   h->key=(long long *)mxMalloc(cap*sizeof(long long));
+   h->val=(int *)mxCalloc(cap,sizeof(int));
+   if (!h->key || !h->val)
+      mexErrMsgTxt("allocation failure in mxI64HashInit()");
+   for (i=0;i<cap;i++) h->key[i]=-1;
+   h->mask=cap-1;
+   h->cnt=0;
+}
+
+#ifdef __STDC__
+int mxI64HashInsert(mxI64Hash *h,long long k,int v)
+#else
+int mxI64HashInsert(h,k,v)
+mxI64Hash *h;
+long long k;
+int v;
+#endif
+{
+   size_t i=MXI64HASH(k)&h->mask;
+   while (h->key[i]!=-1){
+      if (h->key[i]==k) return h->val[i];
+      i=(i+1)&h->mask;
+   }
+   if (2*(h->cnt+1)>h->mask+1)
+      mexErrMsgTxt("mxI64HashInsert: table full; size it with mxI64HashInit");
+   h->key[i]=k;
+   h->val[i]=v;
+   h->cnt++;
+   return v;
+}
+
+#ifdef __STDC__
+int mxI64HashFind(mxI64Hash *h,long long k)
+#else
+int mxI64HashFind(h,k)
+mxI64Hash *h;
+long long k;
+#endif
+{
+   size_t i=MXI64HASH(k)&h->mask;
+   while (h->key[i]!=-1){
+      if (h->key[i]==k) return h->val[i];
+      i=(i+1)&h->mask;
+   }
+   return -1;
+}
+
+#endif
@@ -0,0 +1,195 @@
+/* 64-bit file offsets and fseeko for opnml_mex5_fortread.c; these
+   must be defined before the first system header */
+#define _FILE_OFFSET_BITS 64
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include "mex.h"
+#include "opnml_mex5_allocs.c"
+#include "opnml_mex5_fortread.c"
+
+/************************************************************
+
+  ####     ##     #####  ######  #    #    ##     #   #
+ #    #   #  #      #    #       #    #   #  #     # #
+ #       #    #     #    #####   #    #  #    #     #
+ #  ###  ######     #    #       # ## #  ######     #
+ #    #  #    #     #    #       ##  ##  #    #     #
+  ####   #    #     #    ######  #    #  #    #     #
+
+************************************************************/
+
+void mexFunction(int            nlhs,
+                 mxArray       *plhs[],
+		 int            nrhs,
+		 const mxArray *prhs[])
+{
+
+/* ---- read_adcirc_fort_compact_mex will be called as :
+        D=read_adcirc_fort_compact_mex(FileName,FortUnit,Verbose,Stride,
+                                       Strip,IterStart,IterEnd);
+     or D=read_adcirc_fort_compact_mex(...,IterEnd,Offsets);
+     or D=read_adcirc_fort_compact_mex(...,IterEnd,Offsets,ProgressFcn);
+
+        As read_adcirc_fort_mex, for the compact (sparse) ADCIRC
+        ASCII format, in which each time level starts with a line
+        "time iter nnondefault default" followed by only the
+        nnondefault nodes whose values differ from default (e.g.,
+        the wet nodes of a fort.63); the other nodes are returned
+        as default.  The output structure is that of
+        read_adcirc_fort_mex.  3-d units are not written in compact
+        format.  ------------------------------------------------------ */
+
+   char *fname,header[1024],msg[256];
+   char *names[3];
+   const char *fields[9]={"header","nodes","dt","time","iter","offsets","nlevels",NULL,NULL};
+   int unit,verbose,ncomp,nf,c,done;
+   long long ndsets,nn,i,istart,iend,stride,nsel,k,j,n,every,noff=0,nnz;
+   double hdr[5],rec[4],v,node,*time,*iter,*offsets,*q[3],*qq;
+   const double *offin=NULL;
+   const mxArray *prog=NULL;
+   mxArray *D,*data[3];
+   mxFortReader r;
+
+/* ---- check I/O arguments ----------------------------------------- */
+   if (nrhs < 7 || nrhs > 9)
+      mexErrMsgTxt("read_adcirc_fort_compact_mex requires 7, 8 or 9 input arguments.");
+   else if (nlhs > 1)
+      mexErrMsgTxt("read_adcirc_fort_compact_mex requires 1 output argument.");
+   if (!mxIsChar(prhs[0]))
+      mexErrMsgTxt("FileName to read_adcirc_fort_compact_mex must be a string.");
+
+   fname=mxArrayToString(prhs[0]);
+   unit=(int)mxGetScalar(prhs[1]);
+   verbose=(int)mxGetScalar(prhs[2]);
+   stride=(long long)mxGetScalar(prhs[3]);
+   istart=(long long)mxGetScalar(prhs[5]);
+   v=mxGetScalar(prhs[6]);
+   if (stride<1) stride=1;
+   if (istart<1) istart=1;
+   if (nrhs>7 && !mxIsEmpty(prhs[7])) offin=mxGetPr(prhs[7]);
+   if (nrhs>8) prog=prhs[8];
+
+   ncomp=mxFortUnit(unit,names);
+   if (ncomp==0 || unit==45 || unit==46)
+      mexErrMsgTxt("FortUnit to read_adcirc_fort_compact_mex is not supported.");
+
+   if (!mxFortOpen(&r,fname))
+      mexErrMsgTxt("read_adcirc_fort_compact_mex could not open FileName.");
+
+/* ---- header: title line, then NDSETS NP DT NSTEP IFLAG ------------ */
+   mxFortLine(&r,header,1024);
+   for (i=0;i<5;i++)
+      if (!mxFortDouble(&r,&hdr[i])){
+         mxFortClose(&r);
+         mexErrMsgTxt("read_adcirc_fort_compact_mex: short header.");
+      }
+   mxFortSkipLines(&r,1);
+   ndsets=(long long)hdr[0];
+   nn=(long long)hdr[1];
+
+   iend=(v!=v || v>ndsets || v<1) ? ndsets : (long long)v;
+   nsel=iend>=istart ? (iend-istart)/stride+1 : 0;
+   if (offin && (long long)mxGetNumberOfElements(prhs[7])<iend){
+      mexWarnMsgTxt("Offsets are shorter than IterEnd; scanning the file.");
+      offin=NULL;
+   }
+
+   for (c=0;c<ncomp;c++){
+      data[c]=mxCreateDoubleMatrix(nn,nsel,mxREAL);
+      q[c]=mxGetPr(data[c]);
+   }
+   for (nf=0;fields[nf];nf++);
+   for (c=0;c<ncomp;c++) fields[nf++]=names[c];
+   plhs[0]=D=mxCreateStructMatrix(1,1,nf,fields);
+   mxSetField(D,0,"time",mxCreateDoubleMatrix(nsel,1,mxREAL));
+   mxSetField(D,0,"iter",mxCreateDoubleMatrix(nsel,1,mxREAL));
+   mxSetField(D,0,"offsets",mxCreateDoubleMatrix(iend,1,mxREAL));
+   time=mxGetPr(mxGetField(D,0,"time"));
+   iter=mxGetPr(mxGetField(D,0,"iter"));
+   offsets=mxGetPr(mxGetField(D,0,"offsets"));
+   if (offin){
+      for (k=0;k<iend;k++) offsets[k]=offin[k];
+      noff=iend;
+   }
+
+/* ---- time levels -------------------------------------------------- */
+   every=(offin ? nsel : iend)/20;
+   if (every<1) every=1;
+   n=0;
+   done=1;
+   for (k=offin ? istart : 1;k<=iend;k+=offin ? stride : 1){
+      if (offin)
+         mxFortSeek(&r,(long long)offin[k-1]);
+      else
+         offsets[noff++]=(double)mxFortTell(&r);
+
+      for (c=0;c<4;c++)
+         if (!mxFortDouble(&r,&rec[c])) break;
+      if (c<4){
+         if (!offin) noff--;
+         done=0;
+         break;
+      }
+      mxFortSkipLines(&r,1);
+      nnz=(long long)rec[2];
+
+      if (k<istart || (k-istart)%stride){
+         /* not returned */
+         if (mxFortSkipLines(&r,nnz)<nnz){noff--;done=0;break;}
+         continue;
+      }
+
+      time[n]=rec[0];
+      iter[n]=rec[1];
+      for (c=0;c<ncomp;c++){
+         qq=q[c]+nn*n;
+         for (i=0;i<nn;i++) qq[i]=rec[3];
+      }
+      for (j=0;j<nnz;j++){
+         if (!mxFortDouble(&r,&node)) break;
+         if (node<1 || node>nn){
+            mxFortClose(&r);
+            mexErrMsgTxt("read_adcirc_fort_compact_mex: node number out of range.");
+         }
+         i=(long long)node-1;
+         for (c=0;c<ncomp;c++){
+            mxFortDouble(&r,&v);
+            q[c][i+nn*n]=v;
+         }
+         mxFortSkipLines(&r,1);
+      }
+      if (j<nnz){
+         if (!offin) noff--;
+         done=0;
+         break;
+      }
+      n++;
+
+      if ((offin ? n : k)%every==0){
+         sprintf(msg,"* Read %lld of %lld time levels from %.180s",n,nsel,fname);
+         mxFortProgress(prog,verbose,msg);
+      }
+   }
+   mxFortClose(&r);
+
+   if (!done){
+      sprintf(msg,"%.180s ends after %lld of %lld time levels.",fname,
+              offin ? n : noff,offin ? nsel : iend);
+      mexWarnMsgTxt(msg);
+      mxSetM(mxGetField(D,0,"time"),n);
+      mxSetM(mxGetField(D,0,"iter"),n);
+      mxSetM(mxGetField(D,0,"offsets"),noff);
+      for (c=0;c<ncomp;c++) mxSetN(data[c],n);
+   }
+
+   mxSetField(D,0,"header",mxCreateString(header));
+   mxSetField(D,0,"nodes",mxCreateDoubleScalar((double)nn));
+   mxSetField(D,0,"dt",mxCreateDoubleScalar(hdr[2]));
+   mxSetField(D,0,"nlevels",mxCreateDoubleScalar(1.));
+   for (c=0;c<ncomp;c++) mxSetField(D,0,names[c],data[c]);
+
+   mxFree(fname);
+   return;
+}
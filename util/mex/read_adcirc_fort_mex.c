@@ -0,0 +1,217 @@
+/* 64-bit file offsets and fseeko for opnml_mex5_fortread.c; these
+   must be defined before the first system header */
+#define _FILE_OFFSET_BITS 64
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include "mex.h"
+#include "opnml_mex5_allocs.c"
+#include "opnml_mex5_fortread.c"
+
+/************************************************************
+
+  ####     ##     #####  ######  #    #    ##     #   #
+ #    #   #  #      #    #       #    #   #  #     # #
+ #       #    #     #    #####   #    #  #    #     #
+ #  ###  ######     #    #       # ## #  ######     #
+ #    #  #    #     #    #       ##  ##  #    #     #
+  ####   #    #     #    ######  #    #  #    #     #
+
+************************************************************/
+
+void mexFunction(int            nlhs,
+                 mxArray       *plhs[],
+		 int            nrhs,
+		 const mxArray *prhs[])
+{
+
+/* ---- read_adcirc_fort_mex will be called as :
+        D=read_adcirc_fort_mex(FileName,FortUnit,Verbose,Stride,Strip,
+                               IterStart,IterEnd,Level);
+     or D=read_adcirc_fort_mex(...,Level,Offsets);
+     or D=read_adcirc_fort_mex(...,Level,Offsets,ProgressFcn);
+
+        Reads time levels IterStart:Stride:IterEnd (1-based; IterEnd
+        NaN for the last) of the full-format ADCIRC ASCII output file
+        FileName of unit FortUnit, in one streaming pass.  Strip is
+        IterStart-1 and is not used.  Level is the vertical level
+        to return from a 3-d unit (45,46), and is ignored otherwise.
+
+        D.offsets is the byte offset of each of the time levels
+        1..IterEnd in the file.  Passing it back as Offsets, for the
+        same file, seeks straight to each level to read instead of
+        scanning the levels before it.  With IterStart>IterEnd no
+        levels are read and only the offsets are returned.
+
+        ProgressFcn is a function handle called with a status
+        string (e.g., @SetUIStatusMessage) every 5% of the levels.
+
+        D.header   - first line of the file
+        D.nodes    - number of nodes (or stations)
+        D.dt       - output interval in the file (secs)
+        D.time     - model time of each level read (secs)
+        D.iter     - model time step of each level read
+        D.offsets  - byte offsets of time levels 1..IterEnd
+        D.zeta     - nodes x levels, units 61,63
+        D.pres     - nodes x levels, units 71,73
+        D.u,D.v    - nodes x levels, units 62,64,72,74
+        D.u,D.v,D.w     - nodes x levels at Level, unit 45
+        D.q20,D.l,D.ev  - nodes x levels at Level, unit 46
+
+        A file that ends early (e.g., a run still going) returns
+        the levels completed.  ------------------------------------- */
+
+   char *fname,header[1024],msg[256];
+   char *names[3];
+   const char *fields[11]={"header","nodes","dt","time","iter","offsets","nlevels",NULL,NULL,NULL,NULL};
+   int unit,verbose,ncomp,nlev=1,level,nf,c,l,done;
+   long long ndsets,nn,i,istart,iend,stride,nsel,k,j,n,every,noff=0;
+   double hdr[5],v,node,*time,*iter,*offsets,*q[3];
+   const double *offin=NULL;
+   const mxArray *prog=NULL;
+   mxArray *D,*data[3];
+   mxFortReader r;
+
+/* ---- check I/O arguments ----------------------------------------- */
+   if (nrhs < 8 || nrhs > 10)
+      mexErrMsgTxt("read_adcirc_fort_mex requires 8, 9 or 10 input arguments.");
+   else if (nlhs > 1)
+      mexErrMsgTxt("read_adcirc_fort_mex requires 1 output argument.");
+   if (!mxIsChar(prhs[0]))
+      mexErrMsgTxt("FileName to read_adcirc_fort_mex must be a string.");
+
+   fname=mxArrayToString(prhs[0]);
+   unit=(int)mxGetScalar(prhs[1]);
+   verbose=(int)mxGetScalar(prhs[2]);
+   stride=(long long)mxGetScalar(prhs[3]);
+   istart=(long long)mxGetScalar(prhs[5]);
+   v=mxGetScalar(prhs[6]);
+   level=(int)mxGetScalar(prhs[7]);
+   if (stride<1) stride=1;
+   if (istart<1) istart=1;
+   if (nrhs>8 && !mxIsEmpty(prhs[8])) offin=mxGetPr(prhs[8]);
+   if (nrhs>9) prog=prhs[9];
+
+   ncomp=mxFortUnit(unit,names);
+   if (ncomp==0)
+      mexErrMsgTxt("FortUnit to read_adcirc_fort_mex is not supported.");
+   if (unit==45 || unit==46){
+      if (level<1)
+         mexErrMsgTxt("Level must be given for a 3-d unit number.");
+   }
+
+   if (!mxFortOpen(&r,fname))
+      mexErrMsgTxt("read_adcirc_fort_mex could not open FileName.");
+
+/* ---- header: title line, then NDSETS NP DT NSTEP IFLAG ------------ */
+   mxFortLine(&r,header,1024);
+   for (i=0;i<5;i++)
+      if (!mxFortDouble(&r,&hdr[i])){
+         mxFortClose(&r);
+         mexErrMsgTxt("read_adcirc_fort_mex: short header.");
+      }
+   mxFortSkipLines(&r,1);
+   ndsets=(long long)hdr[0];
+   nn=(long long)hdr[1];
+
+   iend=(v!=v || v>ndsets || v<1) ? ndsets : (long long)v;
+   nsel=iend>=istart ? (iend-istart)/stride+1 : 0;
+   if (offin && (long long)mxGetNumberOfElements(prhs[8])<iend){
+      mexWarnMsgTxt("Offsets are shorter than IterEnd; scanning the file.");
+      offin=NULL;
+   }
+
+   for (c=0;c<ncomp;c++){
+      data[c]=mxCreateDoubleMatrix(nn,nsel,mxREAL);
+      q[c]=mxGetPr(data[c]);
+   }
+   for (nf=0;fields[nf];nf++);
+   for (c=0;c<ncomp;c++) fields[nf++]=names[c];
+   plhs[0]=D=mxCreateStructMatrix(1,1,nf,fields);
+   mxSetField(D,0,"time",mxCreateDoubleMatrix(nsel,1,mxREAL));
+   mxSetField(D,0,"iter",mxCreateDoubleMatrix(nsel,1,mxREAL));
+   mxSetField(D,0,"offsets",mxCreateDoubleMatrix(iend,1,mxREAL));
+   time=mxGetPr(mxGetField(D,0,"time"));
+   iter=mxGetPr(mxGetField(D,0,"iter"));
+   offsets=mxGetPr(mxGetField(D,0,"offsets"));
+   if (offin){
+      for (k=0;k<iend;k++) offsets[k]=offin[k];
+      noff=iend;
+   }
+
+/* ---- time levels -------------------------------------------------- */
+   every=(offin ? nsel : iend)/20;
+   if (every<1) every=1;
+   n=0;
+   done=1;
+   for (k=offin ? istart : 1;k<=iend;k+=offin ? stride : 1){
+      if (offin)
+         mxFortSeek(&r,(long long)offin[k-1]);
+      else
+         offsets[noff++]=(double)mxFortTell(&r);
+
+      if (k<istart || (k-istart)%stride){
+         /* not returned: the time line and one line per node */
+         if (mxFortSkipLines(&r,nn+1)<nn+1){noff--;done=0;break;}
+         continue;
+      }
+
+      if (!mxFortDouble(&r,&time[n]) || !mxFortDouble(&r,&iter[n])){
+         if (!offin) noff--;
+         done=0;
+         break;
+      }
+      mxFortSkipLines(&r,1);
+      if ((unit==45 || unit==46) && n==0){
+         nlev=(mxFortLineTokens(&r)-1)/3;
+         if (level>nlev){
+            mxFortClose(&r);
+            mexErrMsgTxt("Level is greater than the number of levels in the file.");
+         }
+      }
+      for (j=0;j<nn;j++){
+         if (!mxFortDouble(&r,&node)) break;
+         i=(node>=1 && node<=nn) ? (long long)node-1 : j;
+         if (unit==45 || unit==46){
+            for (l=0;l<3*(level-1);l++) mxFortDouble(&r,&v);
+         }
+         for (c=0;c<ncomp;c++){
+            mxFortDouble(&r,&v);
+            q[c][i+nn*n]=v;
+         }
+         mxFortSkipLines(&r,1);
+      }
+      if (j<nn){
+         if (!offin) noff--;
+         done=0;
+         break;
+      }
+      n++;
+
+      if ((offin ? n : k)%every==0){
+         sprintf(msg,"* Read %lld of %lld time levels from %.180s",n,nsel,fname);
+         mxFortProgress(prog,verbose,msg);
+      }
+   }
+   mxFortClose(&r);
+
+   if (!done){
+      sprintf(msg,"%.180s ends after %lld of %lld time levels.",fname,
+              offin ? n : noff,offin ? nsel : iend);
+      mexWarnMsgTxt(msg);
+      mxSetM(mxGetField(D,0,"time"),n);
+      mxSetM(mxGetField(D,0,"iter"),n);
+      mxSetM(mxGetField(D,0,"offsets"),noff);
+      for (c=0;c<ncomp;c++) mxSetN(data[c],n);
+   }
+
+   mxSetField(D,0,"header",mxCreateString(header));
+   mxSetField(D,0,"nodes",mxCreateDoubleScalar((double)nn));
+   mxSetField(D,0,"dt",mxCreateDoubleScalar(hdr[2]));
+   mxSetField(D,0,"nlevels",mxCreateDoubleScalar((double)nlev));
+   for (c=0;c<ncomp;c++) mxSetField(D,0,names[c],data[c]);
+
+   mxFree(fname);
+   return;
+}
@@ -0,0 +1,339 @@
+#include <math.h>
+#include <stdio.h>
+#include "mex.h"
+#include "opnml_mex5_allocs.c"
+
+/* ---- node capacity of the packed tree ---------------------------- */
+#define NODECAP 8
+/* ---- element envelopes are fuzzed by 1/FUZZFAC of their extent,
+        as in the JTS version of ComputeStrTree ------------------- */
+#define FUZZFAC 100.
+
+typedef struct {
+   double key;
+   int    id;
+} strkey;
+
+/* PROTOTYPES */
+int  keycmp(const void *,const void *);
+void strpack(int,int,double *,int *,strkey *);
+void strbuild(int,double *,double *,int *,mxArray **);
+void strquery(const mxArray *,int,double *,double *,
+              double *,double *,double *,double *,int,double,double *);
+
+static const char *TreeFields[]={"ne","nleaf","box","child","item"};
+
+/* ---- AA,BB,TT are defined to perform the following array
+        element extractions     AA(i,j,m) AA[i+m*j] ---------------- */
+#define AA(i,j,m) A[i+m*j]
+#define BB(i,j,m) B[i+m*j]
+#define TT(i,j,m) T[i+m*j]
+#define ELE(i,j,m) ele[i+m*j]
+
+/************************************************************
+
+  ####     ##     #####  ######  #    #    ##     #   #
+ #    #   #  #      #    #       #    #   #  #     # #
+ #       #    #     #    #####   #    #  #    #     #
+ #  ###  ######     #    #       # ## #  ######     #
+ #    #  #    #     #    #       ##  ##  #    #     #
+  ####   #    #     #    ######  #    #  #    #     #
+
+************************************************************/
+
+void mexFunction(int            nlhs,
+                 mxArray       *plhs[],
+		 int            nrhs,
+		 const mxArray *prhs[])
+{
+
+/* ---- strtreemex5 will be called as :
+        tree=strtreemex5('build',x,y,e);
+        j_el=strtreemex5('query',tree,xp,yp,AR,A,B,T,tolerance);
+
+        The tree is a structure of flat arrays, so it can be saved
+        and loaded with the rest of the fem_grid_struct.         ---- */
+
+   int i,ne,nn,np,*ele;
+   double *dele;
+   char mode[8];
+
+   if (nrhs < 1 || !mxIsChar(prhs[0]))
+      mexErrMsgTxt("First argument to strtreemex5 must be 'build' or 'query'.");
+   mxGetString(prhs[0],mode,8);
+
+   if (strcmp(mode,"build")==0){
+      if (nrhs != 4)
+         mexErrMsgTxt("strtreemex5('build',...) requires 4 input arguments.");
+      else if (nlhs != 1)
+         mexErrMsgTxt("strtreemex5('build',...) requires 1 output argument.");
+      nn=mxGetM(prhs[1]);
+      ne=mxGetM(prhs[3]);
+      dele=mxGetPr(prhs[3]);
+      ele=(int *)mxIvector(0,3*ne-1);
+      for (i=0;i<3*ne;i++){
+         ele[i]=((int)dele[i])-1;
+         if (ele[i]<0 || ele[i]>=nn)
+            mexErrMsgTxt("Element list references nodes not in x,y.");
+      }
+      strbuild(ne,mxGetPr(prhs[1]),mxGetPr(prhs[2]),ele,&plhs[0]);
+   }
+   else if (strcmp(mode,"query")==0){
+      if (nrhs != 9)
+         mexErrMsgTxt("strtreemex5('query',...) requires 9 input arguments.");
+      else if (nlhs != 1)
+         mexErrMsgTxt("strtreemex5('query',...) requires 1 output argument.");
+      if (!mxIsStruct(prhs[1]))
+         mexErrMsgTxt("Second argument to strtreemex5('query',...) must be a tree.");
+      np=mxGetM(prhs[2])*mxGetN(prhs[2]);
+      ne=mxGetM(prhs[4]);
+      if ((int)mxGetScalar(mxGetField(prhs[1],0,"ne")) != ne)
+         mexErrMsgTxt("Tree was not built for this grid.");
+      plhs[0]=mxCreateDoubleMatrix(mxGetM(prhs[2]),mxGetN(prhs[2]),mxREAL);
+      strquery(prhs[1],np,mxGetPr(prhs[2]),mxGetPr(prhs[3]),
+               mxGetPr(prhs[4]),mxGetPr(prhs[5]),mxGetPr(prhs[6]),
+               mxGetPr(prhs[7]),ne,mxGetScalar(prhs[8]),mxGetPr(plhs[0]));
+   }
+   else
+      mexErrMsgTxt("First argument to strtreemex5 must be 'build' or 'query'.");
+   return;
+}
+
+int keycmp(const void *a,const void *b)
+{
+   double ka=((const strkey *)a)->key,kb=((const strkey *)b)->key;
+   if (ka<kb) return(-1);
+   if (ka>kb) return(1);
+   return(((const strkey *)a)->id-((const strkey *)b)->id);
+}
+
+/*----------------------------------------------------------------------
+
+   ####    #####  #####   #####     ##     ####   #    #
+  #          #    #    #  #    #   #  #   #    #  #   #
+   ####      #    #    #  #    #  #    #  #       ####
+       #     #    #####   #####   ######  #       #  #
+  #    #     #    #   #   #       #    #  #    #  #   #
+   ####      #    #    #  #       #    #   ####   #    #
+
+  Sort-Tile-Recursive ordering of n boxes (box[4*k]=xmin,xmax,ymin,ymax)
+  into ord[]: sort on center x, cut into ceil(sqrt(n/NODECAP)) vertical
+  slices, and sort each slice on center y.  Consecutive runs of
+  NODECAP entries of ord[] are then the children of one parent.
+----------------------------------------------------------------------*/
+void strpack(int n,int nslice,double *box,int *ord,strkey *key)
+{
+   int i,s,per,i2;
+   for (i=0;i<n;i++){
+      key[i].id=ord[i];
+      key[i].key=box[4*ord[i]]+box[4*ord[i]+1];
+   }
+   qsort(key,n,sizeof(strkey),keycmp);
+   per=nslice*NODECAP;
+   for (s=0;s<n;s+=per){
+      i2=IMIN(n,s+per);
+      for (i=s;i<i2;i++)
+         key[i].key=box[4*key[i].id+2]+box[4*key[i].id+3];
+      qsort(key+s,i2-s,sizeof(strkey),keycmp);
+   }
+   for (i=0;i<n;i++) ord[i]=key[i].id;
+}
+
+/*----------------------------------------------------------------------
+
+  #####   #    #     #    #       #####
+  #    #  #    #     #    #       #    #
+  #####   #    #     #    #       #    #
+  #    #  #    #     #    #       #    #
+  #    #  #    #     #    #       #    #
+  #####    ####      #    ######  #####
+
+  Bulk-loads the tree one level at a time.  Nodes are numbered leaves
+  first; node k's children are child(k,1)+[0..child(k,2)-1], which
+  index item() for the leaves (k<nleaf) and the node list otherwise.
+  The root is the last node.
+----------------------------------------------------------------------*/
+void strbuild(int ne,double *x,double *y,int *ele,mxArray **tree)
+{
+   int i,j,k,n,nlev,nnode,nleaf,first,nslice,cnt;
+   int *ord,*item,*child;
+   double *ebox,*nbox,*box,pad,xmn,xmx,ymn,ymx;
+   strkey *key;
+   mxArray *fld;
+
+/* ---- fuzzed element envelopes ------------------------------------ */
+   ebox=(double *)mxDvector(0,4*IMAX(ne,1)-1);
+   for (j=0;j<ne;j++){
+      xmn=DMIN(DMIN(x[ELE(j,0,ne)],x[ELE(j,1,ne)]),x[ELE(j,2,ne)]);
+      xmx=DMAX(DMAX(x[ELE(j,0,ne)],x[ELE(j,1,ne)]),x[ELE(j,2,ne)]);
+      ymn=DMIN(DMIN(y[ELE(j,0,ne)],y[ELE(j,1,ne)]),y[ELE(j,2,ne)]);
+      ymx=DMAX(DMAX(y[ELE(j,0,ne)],y[ELE(j,1,ne)]),y[ELE(j,2,ne)]);
+      pad=DMAX(xmx-xmn,ymx-ymn)/FUZZFAC;
+      ebox[4*j  ]=xmn-pad;
+      ebox[4*j+1]=xmx+pad;
+      ebox[4*j+2]=ymn-pad;
+      ebox[4*j+3]=ymx+pad;
+   }
+
+/* ---- number of nodes over all levels ----------------------------- */
+   nnode=0;
+   n=IMAX(ne,1);
+   do {
+      n=(n+NODECAP-1)/NODECAP;
+      nnode+=n;
+   } while (n>1);
+
+   fld=mxCreateNumericMatrix(IMAX(ne,1),1,mxINT32_CLASS,mxREAL);
+   item=(int *)mxGetData(fld);
+   *tree=mxCreateStructMatrix(1,1,5,TreeFields);
+   mxSetField(*tree,0,"item",fld);
+   fld=mxCreateDoubleMatrix(nnode,4,mxREAL);
+   nbox=mxGetPr(fld);
+   mxSetField(*tree,0,"box",fld);
+   fld=mxCreateNumericMatrix(nnode,2,mxINT32_CLASS,mxREAL);
+   child=(int *)mxGetData(fld);
+   mxSetField(*tree,0,"child",fld);
+
+   ord=(int *)mxIvector(0,IMAX(ne,1)-1);
+   key=(strkey *)mxCalloc(IMAX(ne,1),sizeof(strkey));
+   box=(double *)mxDvector(0,4*nnode-1);
+
+/* ---- leaves over the elements, then parents over the nodes ------- */
+   n=ne;
+   for (i=0;i<n;i++) ord[i]=i;
+   nslice=(int)ceil(sqrt((double)((n+NODECAP-1)/NODECAP)));
+   strpack(n,IMAX(nslice,1),ebox,ord,key);
+   for (i=0;i<n;i++) item[i]=ord[i]+1;
+
+   k=0;
+   first=0;
+   nlev=0;
+   while (1){
+      cnt=0;
+      for (i=0;i<IMAX(n,1);i+=NODECAP){
+         child[k]=first+i;
+         child[k+nnode]=IMIN(NODECAP,n-i);
+         box[4*k]=box[4*k+2]=mxGetInf();
+         box[4*k+1]=box[4*k+3]=-mxGetInf();
+         for (j=i;j<IMIN(n,i+NODECAP);j++){
+            double *b=(nlev==0) ? &ebox[4*ord[j]] : &box[4*ord[j]];
+            box[4*k  ]=DMIN(box[4*k  ],b[0]);
+            box[4*k+1]=DMAX(box[4*k+1],b[1]);
+            box[4*k+2]=DMIN(box[4*k+2],b[2]);
+            box[4*k+3]=DMAX(box[4*k+3],b[3]);
+         }
+         k++;
+         cnt++;
+      }
+      if (nlev==0) nleaf=cnt;
+      if (cnt==1) break;
+
+      /* order this level's nodes for packing into the next level;
+         the children of a parent must be contiguous, so renumber */
+      n=cnt;
+      first=k-cnt;
+      for (i=0;i<n;i++) ord[i]=first+i;
+      nslice=(int)ceil(sqrt((double)((n+NODECAP-1)/NODECAP)));
+      strpack(n,nslice,box,ord,key);
+      {
+         int *ch=(int *)mxIvector(0,2*n-1);
+         double *bx=(double *)mxDvector(0,4*n-1);
+         for (i=0;i<n;i++){
+            ch[2*i]=child[ord[i]];
+            ch[2*i+1]=child[ord[i]+nnode];
+            for (j=0;j<4;j++) bx[4*i+j]=box[4*ord[i]+j];
+         }
+         for (i=0;i<n;i++){
+            child[first+i]=ch[2*i];
+            child[first+i+nnode]=ch[2*i+1];
+            for (j=0;j<4;j++) box[4*(first+i)+j]=bx[4*i+j];
+            ord[i]=first+i;
+         }
+         mxFree(ch);
+         mxFree(bx);
+      }
+      nlev++;
+   }
+
+/* ---- node boxes out as an nnode x 4 [xmin xmax ymin ymax] -------- */
+   for (k=0;k<nnode;k++)
+      for (j=0;j<4;j++)
+         nbox[k+nnode*j]=box[4*k+j];
+
+   mxSetField(*tree,0,"ne",mxCreateDoubleScalar((double)ne));
+   mxSetField(*tree,0,"nleaf",mxCreateDoubleScalar((double)nleaf));
+   mxFree(ebox);
+   mxFree(ord);
+   mxFree(key);
+   mxFree(box);
+   return;
+}
+
+/*----------------------------------------------------------------------
+
+   ####   #    #  ######  #####    #   #
+  #    #  #    #  #       #    #    # #
+  #    #  #    #  #####   #    #     #
+  #  # #  #    #  #       #####      #
+  #   #   #    #  #       #   #      #
+   ### #   ####   ######  #    #     #
+
+  Depth-first descent with an explicit stack.  Every candidate element
+  is tested with the basis functions; the lowest numbered containing
+  element is returned, as findelemex5 does.  NaN if not found.
+----------------------------------------------------------------------*/
+void strquery(const mxArray *tree,int np,double *xp,double *yp,
+              double *AR,double *A,double *B,double *T,int ne,
+              double tol,double *fnd)
+{
+   int ip,k,c,c1,c2,j,jbest,top,nnode,nleaf;
+   int *stack,*child,*item;
+   double *box,px,py,fac,S1,S2,S3,ONE,ZERO;
+
+   box  =mxGetPr(mxGetField(tree,0,"box"));
+   child=(int *)mxGetData(mxGetField(tree,0,"child"));
+   item =(int *)mxGetData(mxGetField(tree,0,"item"));
+   nnode=mxGetM(mxGetField(tree,0,"box"));
+   nleaf=(int)mxGetScalar(mxGetField(tree,0,"nleaf"));
+   stack=(int *)mxIvector(0,nnode+64*NODECAP);
+   ONE=1.+tol;
+   ZERO=0.-tol;
+
+#define INBOX(k) (px>=box[k] && px<=box[k+nnode] && \
+                  py>=box[k+2*nnode] && py<=box[k+3*nnode])
+
+   for (ip=0;ip<np;ip++){
+      px=xp[ip];
+      py=yp[ip];
+      jbest=ne;
+      top=0;
+      if (ne>0 && INBOX(nnode-1)) stack[top++]=nnode-1;
+      while (top>0){
+         k=stack[--top];
+         c1=child[k];
+         c2=c1+child[k+nnode];
+         if (k<nleaf){
+            for (c=c1;c<c2;c++){
+               j=item[c]-1;
+               if (j>=jbest) continue;
+               fac=.5/AR[j];
+               S1=(TT(j,0,ne)+BB(j,0,ne)*px+AA(j,0,ne)*py)*fac;
+               if ((S1>ONE)||(S1<ZERO)) continue;
+               S2=(TT(j,1,ne)+BB(j,1,ne)*px+AA(j,1,ne)*py)*fac;
+               if ((S2>ONE)||(S2<ZERO)) continue;
+               S3=(TT(j,2,ne)+BB(j,2,ne)*px+AA(j,2,ne)*py)*fac;
+               if ((S3>ONE)||(S3<ZERO)) continue;
+               jbest=j;
+            }
+         }
+         else {
+            for (c=c1;c<c2;c++)
+               if (INBOX(c)) stack[top++]=c;
+         }
+      }
+      fnd[ip]=(jbest<ne) ? (double)(jbest+1) : mxGetNaN();
+   }
+   mxFree(stack);
+#undef INBOX
+   return;
+}
@@ -0,0 +1,145 @@
+#include <math.h>
+#include <stdio.h>
+#include "mex.h"
+#include "opnml_mex5_allocs.c"
+
+/* PROTOTYPES */
+int vecbin(int,double *,double *,double *,double *,double *,int,int,
+           double,double,int *,double *);
+
+/************************************************************
+
+  ####     ##     #####  ######  #    #    ##     #   #
+ #    #   #  #      #    #       #    #   #  #     # #
+ #       #    #     #    #####   #    #  #    #     #
+ #  ###  ######     #    #       # ## #  ######     #
+ #    #  #    #     #    #       ##  ##  #    #     #
+  ####   #    #     #    ######  #    #  #    #     #
+
+************************************************************/
+
+void mexFunction(int            nlhs,
+                 mxArray       *plhs[],
+		 int            nrhs,
+		 const mxArray *prhs[])
+{
+
+/* ---- vecbinmex5 will be called as :
+        idx=vecbinmex5(x,y,u,v,axx,cells);
+     or idx=vecbinmex5(x,y,u,v,axx,cells,thresh);
+
+        Picks the vectors to draw for the view axx=[xmin xmax ymin
+        ymax].  The view is split into cells=[nx ny] equal cells
+        (e.g., one per 25 screen pixels), and from each cell the
+        vector nearest the cell center is taken, so that the drawn
+        vectors are evenly spread on the screen whatever the node
+        order and resolution of the grid.  Vectors outside the view,
+        with a NaN component, or with a magnitude at or below
+        thresh(1) or at or above thresh(2) (default [0 Inf], as in
+        VECPLOT) are never taken.  idx is the 1-based node numbers
+        taken, in cell order, at most nx*ny of them.  One pass over
+        the nodes; no node-length arrays are allocated.  ----------- */
+
+   mwSize nn;
+   int nx,ny,nsel,i;
+   int *best;
+   double *axx,*cells,*dist,*idx;
+   double tmin=0.,tmax=mxGetInf();
+
+/* ---- check I/O arguments ----------------------------------------- */
+   if (nrhs != 6 && nrhs != 7)
+      mexErrMsgTxt("vecbinmex5 requires 6 or 7 input arguments.");
+   else if (nlhs > 1)
+      mexErrMsgTxt("vecbinmex5 requires 1 output argument.");
+
+   nn=mxGetNumberOfElements(prhs[0]);
+   if (mxGetNumberOfElements(prhs[1]) != nn ||
+       mxGetNumberOfElements(prhs[2]) != nn ||
+       mxGetNumberOfElements(prhs[3]) != nn)
+      mexErrMsgTxt("x,y,u,v to vecbinmex5 must be the same length.");
+   if (mxGetNumberOfElements(prhs[4]) < 4)
+      mexErrMsgTxt("axx to vecbinmex5 must be [xmin xmax ymin ymax].");
+   if (mxGetNumberOfElements(prhs[5]) != 2)
+      mexErrMsgTxt("cells to vecbinmex5 must be [nx ny].");
+   axx=mxGetPr(prhs[4]);
+   cells=mxGetPr(prhs[5]);
+   nx=cells[0]<1. ? 1 : (int)cells[0];
+   ny=cells[1]<1. ? 1 : (int)cells[1];
+   if (nrhs == 7){
+      if (mxGetNumberOfElements(prhs[6]) != 2)
+         mexErrMsgTxt("thresh to vecbinmex5 must be [MinThresh MaxThresh].");
+      tmin=mxGetPr(prhs[6])[0];
+      tmax=mxGetPr(prhs[6])[1];
+   }
+
+   best=(int *)mxIvector(0,nx*ny);
+   dist=(double *)mxDvector(0,nx*ny);
+   nsel=vecbin(nn,mxGetPr(prhs[0]),mxGetPr(prhs[1]),mxGetPr(prhs[2]),
+               mxGetPr(prhs[3]),axx,nx,ny,tmin,tmax,best,dist);
+
+   plhs[0]=mxCreateDoubleMatrix(nsel,1,mxREAL);
+   idx=mxGetPr(plhs[0]);
+   for (i=0;i<nx*ny;i++)
+      if (best[i]>0) *idx++=(double)best[i];
+
+   mxFree(best);
+   mxFree(dist);
+   return;
+}
+
+/*----------------------------------------------------------------------
+
+  #    #  ######   ####   #####      #    #    #
+  #    #  #       #    #  #    #     #    ##   #
+  #    #  #####   #       #####      #    # #  #
+  #    #  #       #       #    #     #    #  # #
+   #  #   #       #    #  #    #     #    #   ##
+    ##    ######   ####   #####      #    #    #
+
+----------------------------------------------------------------------*/
+/* ---- best[c] is the 1-based node nearest the center of cell c, and
+        dist[c] its squared distance in cell units; returns the
+        number of cells with a node ------------------------------- */
+#ifdef __STDC__
+int vecbin(int nn,double *x,double *y,double *u,double *v,double *axx,
+           int nx,int ny,double tmin,double tmax,int *best,double *dist)
+#else
+int vecbin(nn,x,y,u,v,axx,nx,ny,tmin,tmax,best,dist)
+int nn,nx,ny,*best;
+double *x,*y,*u,*v,*axx,tmin,tmax,*dist;
+#endif
+{
+   int i,ix,iy,c,nsel=0;
+   double sx,sy,fx,fy,d,mag;
+
+   sx=(double)nx/(axx[1]-axx[0]);
+   sy=(double)ny/(axx[3]-axx[2]);
+   for (i=0;i<nn;i++){
+      /* NaN coordinates and components fail these tests */
+      if (!(x[i]>=axx[0] && x[i]<=axx[1] && y[i]>=axx[2] && y[i]<=axx[3]))
+         continue;
+      mag=sqrt(u[i]*u[i]+v[i]*v[i]);
+      if (!(mag>tmin && mag<tmax))
+         continue;
+      fx=(x[i]-axx[0])*sx;
+      fy=(y[i]-axx[2])*sy;
+      ix=(int)fx;
+      iy=(int)fy;
+      if (ix>nx-1) ix=nx-1;
+      if (iy>ny-1) iy=ny-1;
+      fx-=ix+.5;
+      fy-=iy+.5;
+      d=fx*fx+fy*fy;
+      c=iy*nx+ix;
+      if (best[c]==0){
+         nsel++;
+         best[c]=i+1;
+         dist[c]=d;
+      }
+      else if (d<dist[c]){
+         best[c]=i+1;
+         dist[c]=d;
+      }
+   }
+   return(nsel);
+}